@@ -0,0 +1,88 @@
+#include "contact_sheet.h"
+
+#include "opencv2/imgproc.hpp"
+
+using namespace std;
+using namespace cv;
+
+static const int kLabelHeight = 18;
+static const int kGap = 2;
+
+ContactSheet::ContactSheet(ImageWriter& writer, const string& prefix, const string& ext,
+                           size_t nbr_of_tiles, int cols, int rows, int cell_size)
+    : writer_(writer),
+      prefix_(prefix),
+      ext_(ext),
+      nbr_of_tiles_(nbr_of_tiles),
+      cols_(cols > 0 ? cols : 1),
+      rows_(rows > 0 ? rows : 1),
+      cell_size_(cell_size > 0 ? cell_size : 256),
+      nbr_of_sheets_(0) {}
+
+void ContactSheet::Add(size_t index, const Mat& image, const string& label) {
+    const size_t tiles_per_sheet = (size_t)cols_ * rows_;
+    const size_t sheet_index = index / tiles_per_sheet;
+    const size_t slot = index % tiles_per_sheet;
+    const int cell_w = cell_size_ + kGap;
+    const int cell_h = cell_size_ + kLabelHeight + kGap;
+
+    // Scale the tile outside the lock, it is the expensive part
+    Mat tile;
+    if (!image.empty()) {
+        double scale = std::min(1.0, std::min((double)cell_size_ / image.cols,
+                                              (double)cell_size_ / image.rows));
+        if (scale < 1.0) {
+            resize(image, tile, Size(std::max(1, cvRound(image.cols * scale)),
+                                     std::max(1, cvRound(image.rows * scale))),
+                   0, 0, INTER_AREA);
+        } else {
+            tile = image;
+        }
+    }
+
+    Mat sheet;
+    {
+        lock_guard<mutex> lock(mutex_);
+        map<size_t, Sheet>::iterator it = sheets_.find(sheet_index);
+        if (it == sheets_.end()) {
+            // The last sheet only has the rows it needs
+            size_t nbr_of_tiles =
+                std::min(tiles_per_sheet, nbr_of_tiles_ - sheet_index * tiles_per_sheet);
+            int rows = (int)((nbr_of_tiles + cols_ - 1) / cols_);
+            Sheet s;
+            s.image = Mat(rows * cell_h + kGap, cols_ * cell_w + kGap, CV_8UC3,
+                          Scalar(48, 48, 48));
+            s.remaining = nbr_of_tiles;
+            it = sheets_.insert(make_pair(sheet_index, s)).first;
+        }
+        sheet = it->second.image;
+    }
+
+    // Every tile owns its cell, so cells are filled without the lock
+    Rect cell(kGap + (int)(slot % cols_) * cell_w, kGap + (int)(slot / cols_) * cell_h,
+              cell_size_, cell_size_ + kLabelHeight);
+    Mat cellImage = sheet(cell);
+    cellImage.setTo(Scalar(0, 0, 0));
+    if (!tile.empty()) {
+        tile.copyTo(cellImage(Rect((cell_size_ - tile.cols) / 2, (cell_size_ - tile.rows) / 2,
+                                   tile.cols, tile.rows)));
+    }
+    putText(cellImage, label, Point(2, cell_size_ + kLabelHeight - 5), FONT_HERSHEY_SIMPLEX,
+            0.4, Scalar(255, 255, 255));
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        map<size_t, Sheet>::iterator it = sheets_.find(sheet_index);
+        if (--it->second.remaining > 0) {
+            return;
+        }
+        sheets_.erase(it);
+        nbr_of_sheets_++;
+    }
+    writer_.Write(prefix_ + format("_%04d", (int)sheet_index) + ext_, sheet);
+}
+
+size_t ContactSheet::GetNbrOfSheets() {
+    lock_guard<mutex> lock(mutex_);
+    return nbr_of_sheets_;
+}
@@ -0,0 +1,46 @@
+#ifndef CONTACT_SHEET_H
+#define CONTACT_SHEET_H
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "image_writer.h"
+#include "opencv2/core.hpp"
+
+// Tiles images into mosaic contact sheets of cols x rows cells.
+//
+// Tile i lands on sheet i / (cols * rows), scaled down to fit a cell_size x cell_size
+// cell with its label printed underneath. A sheet is handed to the writer as soon as
+// all of its tiles have been added, as <prefix>_<sheet number><ext>.
+class ContactSheet {
+   public:
+    ContactSheet(ImageWriter& writer, const std::string& prefix, const std::string& ext,
+                 size_t nbr_of_tiles, int cols, int rows, int cell_size);
+
+    // Place tile index, may be called from several threads in any order. An empty image
+    // leaves the cell blank apart from the label.
+    void Add(size_t index, const cv::Mat& image, const std::string& label);
+
+    // Sheets handed to the writer so far.
+    size_t GetNbrOfSheets();
+
+   private:
+    struct Sheet {
+        cv::Mat image;
+        size_t remaining;
+    };
+
+    ImageWriter& writer_;
+    std::string prefix_;
+    std::string ext_;
+    size_t nbr_of_tiles_;
+    int cols_;
+    int rows_;
+    int cell_size_;
+    size_t nbr_of_sheets_;
+    std::map<size_t, Sheet> sheets_;  // sheets with tiles still missing
+    std::mutex mutex_;
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include "csv_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSV_MAX_PATH 1024
+// "-2147483648, \n"
+#define CSV_MAX_VALUE_CHARS 14
+
+static const char g_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the decimal digits of v at p, returns the end
+static char *put_uint(char *p, unsigned int v) {
+    char tmp[10];
+    char *t = tmp + sizeof(tmp);
+    size_t len;
+    while (v >= 100) {
+        unsigned int pair = (v % 100) * 2;
+        v /= 100;
+        *--t = g_digit_pairs[pair + 1];
+        *--t = g_digit_pairs[pair];
+    }
+    if (v >= 10) {
+        *--t = g_digit_pairs[v * 2 + 1];
+        *--t = g_digit_pairs[v * 2];
+    } else {
+        *--t = (char)('0' + v);
+    }
+    len = tmp + sizeof(tmp) - t;
+    memcpy(p, t, len);
+    return p + len;
+}
+
+static char *put_int(char *p, int v) {
+    if (v < 0) {
+        *p++ = '-';
+        return put_uint(p, 0u - (unsigned int)v);
+    }
+    return put_uint(p, (unsigned int)v);
+}
+
+static FILE *open_file(const char *filename, const char *mode) {
+    FILE *file = NULL;
+    // for long file name
+    char fn_long[CSV_MAX_PATH];
+#ifdef _MSC_VER
+    if (fopen_s(&file, filename, mode) != 0) {
+        sprintf_s(fn_long, CSV_MAX_PATH, "\\\\?\\%s", filename);
+        fopen_s(&file, fn_long, mode);
+    }
+#else
+    file = fopen(filename, mode);
+    (void)fn_long;
+#endif
+    return file;
+}
+
+static int write_file(const char *filename, const char *mode, const void *data,
+                      size_t size) {
+    int ret = 0;
+    FILE *file = open_file(filename, mode);
+    if (file == NULL) {
+        return -1;
+    }
+    if (size > 0 && fwrite(data, 1, size, file) != size) {
+        ret = -1;
+    }
+    if (fclose(file) != 0) {
+        ret = -1;
+    }
+    return ret;
+}
+
+// Row separator handling shared by the element types
+static char *put_separator(char *p, int i, int width) {
+    if (i != 0) {
+        *p++ = ',';
+        *p++ = ' ';
+        if (i % width == 0) {
+            *p++ = '\n';
+        }
+    }
+    return p;
+}
+
+static char *alloc_buffer(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return NULL;
+    }
+    return (char *)malloc((size_t)width * height * CSV_MAX_VALUE_CHARS + 2);
+}
+
+static int finish(const char *filename, char *buf, char *end) {
+    int ret;
+    *end++ = '\n';
+    // Text mode, so new lines match the files of the fprintf writers
+    ret = write_file(filename, "w", buf, end - buf);
+    free(buf);
+    return ret;
+}
+
+int csv_write_u8(const char *filename, const unsigned char *values, int width,
+                 int height) {
+    char *buf = alloc_buffer(width, height);
+    char *p = buf;
+    int i;
+    if (buf == NULL || values == NULL) {
+        free(buf);
+        return -1;
+    }
+    for (i = 0; i < width * height; i++) {
+        p = put_separator(p, i, width);
+        p = put_uint(p, values[i]);
+    }
+    return finish(filename, buf, p);
+}
+
+int csv_write_u16(const char *filename, const unsigned short *values, int width,
+                  int height) {
+    char *buf = alloc_buffer(width, height);
+    char *p = buf;
+    int i;
+    if (buf == NULL || values == NULL) {
+        free(buf);
+        return -1;
+    }
+    for (i = 0; i < width * height; i++) {
+        p = put_separator(p, i, width);
+        p = put_uint(p, values[i]);
+    }
+    return finish(filename, buf, p);
+}
+
+int csv_write_int(const char *filename, const int *values, int width,
+                  int height) {
+    char *buf = alloc_buffer(width, height);
+    char *p = buf;
+    int i;
+    if (buf == NULL || values == NULL) {
+        free(buf);
+        return -1;
+    }
+    for (i = 0; i < width * height; i++) {
+        p = put_separator(p, i, width);
+        if (values[i] == CSV_NAN_VALUE) {
+            memcpy(p, "NAN", 3);
+            p += 3;
+        } else {
+            p = put_int(p, values[i]);
+        }
+    }
+    return finish(filename, buf, p);
+}
+
+int bin_write(const char *filename, const void *data, size_t size) {
+    if (data == NULL && size > 0) {
+        return -1;
+    }
+    return write_file(filename, "wb", data, size);
+}
+
+int dump_u8(dump_format_t format, const char *name, const unsigned char *img,
+            int width, int height) {
+    char filename[CSV_MAX_PATH];
+    if (format == DUMP_NONE) {
+        return 0;
+    }
+    if (width <= 0 || height <= 0) {
+        return -1;
+    }
+#ifdef _MSC_VER
+    sprintf_s(filename, CSV_MAX_PATH, "%s.%s", name, format == DUMP_CSV ? "csv" : "bin");
+#else
+    snprintf(filename, CSV_MAX_PATH, "%s.%s", name, format == DUMP_CSV ? "csv" : "bin");
+#endif
+    if (format == DUMP_CSV) {
+        return csv_write_u8(filename, img, width, height);
+    }
+    return bin_write(filename, img, (size_t)width * height);
+}
@@ -0,0 +1,57 @@
+#ifndef CSV_WRITER_H_
+#define CSV_WRITER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * Buffered matrix dumps.
+ *
+ * A matrix is formatted into one memory buffer with a table-driven integer
+ * conversion and written with a single fwrite, instead of one fprintf per value.
+ * The CSV layout is the one of U82CSV / int2CSV / US2CSV: values separated by
+ * ", ", a new row starting after the separator, a final new line.
+ */
+
+typedef enum dump_format {
+    DUMP_NONE = 0,
+    DUMP_CSV,
+    DUMP_BIN,  // raw row-major values, as write_U8bin_file
+} dump_format_t;
+
+/** Value written as NAN by csv_write_int, as int2CSV. */
+#define CSV_NAN_VALUE (-9999)
+
+/**
+ * @return
+ *  0, or -1 if the file could not be written.
+ */
+int csv_write_u8(const char *filename, const unsigned char *values, int width,
+                 int height);
+int csv_write_u16(const char *filename, const unsigned short *values, int width,
+                  int height);
+int csv_write_int(const char *filename, const int *values, int width,
+                  int height);
+
+/**
+ * Write size bytes to filename in one call, with the long path fallback.
+ *
+ * @return
+ *  0, or -1 if the file could not be written.
+ */
+int bin_write(const char *filename, const void *data, size_t size);
+
+/**
+ * Dump an 8-bit image as <name>.csv or <name>.bin, nothing for DUMP_NONE.
+ */
+int dump_u8(dump_format_t format, const char *name, const unsigned char *img,
+            int width, int height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,121 +1,57 @@
 #include "fileio.h"
+#include "csv_writer.h"
+#include "raw16.h"
 //#include "lodepng.h"
 #include <errno.h>
 #include <string.h>
 
-int* read_bin_file(const char* fn, int width, int height, int endian) {
+// Reads width x height 16-bit pixels after head_size header words straight into the int
+// buffer, swaps them in place and widens them from the back so no temporary is needed.
+static int* read_raw16_as_int(const char* fn, int width, int height, int endian,
+                              int head_size) {
     FILE* f;
-    unsigned char SWAP[2];
+    int n = width * height;
+    size_t read;
 
-    int* img = (int*)malloc(width * height * sizeof(int));
+    int* img = (int*)malloc(n * sizeof(int));
     if (img == NULL) {
         return NULL;
     }
-    unsigned short* tmp = (unsigned short*)malloc(width * height * sizeof(unsigned short));
-    if (tmp == NULL) {
-        free(img);
-        return NULL;
-    }
+    unsigned short* pixels = (unsigned short*)img;
 
     // for long file name
     char fn_long[1024];
     sprintf_s(fn_long, 1024, "\\\\?\\%s", fn);
 
-    if (fopen_s(&f, fn, "rb") == 0) {
-        fread(tmp, sizeof(unsigned short), width * height, f);
-        for (int i = 0; i < width * height; i++) {
-            if (endian == BIG_ENDIAN) {
-                SWAP[0] = (tmp[i] & 0xFF00) >> 8;
-                SWAP[1] = tmp[i] & 0x00FF;
-                img[i] = ((SWAP[1] << 8) + SWAP[0]);
-            } else
-                img[i] = tmp[i];
-        }
-
-        fclose(f);
-    } else if (fopen_s(&f, fn_long, "rb") == 0) {
-        fread(tmp, sizeof(unsigned short), width * height, f);
-        for (int i = 0; i < width * height; i++) {
-            if (endian == BIG_ENDIAN) {
-                SWAP[0] = (tmp[i] & 0xFF00) >> 8;
-                SWAP[1] = tmp[i] & 0x00FF;
-                img[i] = ((SWAP[1] << 8) + SWAP[0]);
-            } else
-                img[i] = tmp[i];
-        }
-
-        fclose(f);
-    } else {
+    if (fopen_s(&f, fn, "rb") != 0 && fopen_s(&f, fn_long, "rb") != 0) {
         char errmsg[500];
 #ifdef BILL_DEBUG
         printf("Error: %s", strerror_s(errmsg, 500, errno));
 #endif
         free(img);
-        free(tmp);
         return NULL;
     }
+    fseek(f, head_size * (long)sizeof(unsigned short), SEEK_SET);
+    read = fread(pixels, sizeof(unsigned short), n, f);
+    memset(pixels + read, 0, (n - read) * sizeof(unsigned short));
+    fclose(f);
 
-    free(tmp);
-    return img;
-}
-
-int* read_bin_file_head(const char* fn, int width, int height, int endian, int head_size) {
-    int i, j;
-    FILE* f;
-    unsigned char SWAP[2];
-
-    int* img = (int*)malloc(width * height * sizeof(int));
-    if (img == NULL) {
-        return NULL;
+    if (endian == BIG_ENDIAN) {
+        raw16_swap_bytes(pixels, n);
     }
-    unsigned short* tmp =
-        (unsigned short*)malloc((head_size + width * height) * sizeof(unsigned short));
-
-    if (tmp == NULL) {
-        free(img);
-        return NULL;
+    // img[i] only overlaps pixels[2i] and pixels[2i + 1], which are already widened
+    for (int i = n - 1; i >= 0; i--) {
+        img[i] = pixels[i];
     }
+    return img;
+}
 
-    // for long file name
-    char fn_long[1024];
-    sprintf_s(fn_long, 1024, "\\\\?\\%s", fn);
-
-    if (fopen_s(&f, fn, "rb") == 0) {
-        fread(tmp, sizeof(unsigned short), head_size + width * height, f);
-        for (i = head_size, j = 0; i < head_size + width * height; i++, j++) {
-            if (endian == BIG_ENDIAN) {
-                SWAP[0] = (tmp[i] & 0xFF00) >> 8;
-                SWAP[1] = tmp[i] & 0x00FF;
-                img[j] = ((SWAP[1] << 8) + SWAP[0]);
-            } else
-                img[j] = tmp[i];
-        }
-
-        fclose(f);
-    } else if (fopen_s(&f, fn_long, "rb") == 0) {
-        fread(tmp, sizeof(unsigned short), head_size + width * height, f);
-        for (i = head_size, j = 0; i < head_size + width * height; i++, j++) {
-            if (endian == BIG_ENDIAN) {
-                SWAP[0] = (tmp[i] & 0xFF00) >> 8;
-                SWAP[1] = tmp[i] & 0x00FF;
-                img[j] = ((SWAP[1] << 8) + SWAP[0]);
-            } else
-                img[j] = tmp[i];
-        }
-
-        fclose(f);
-    } else {
-        char errmsg[500];
-#ifdef BILL_DEBUG
-        printf("Error: %s", strerror_s(errmsg, 500, errno));
-#endif
-        free(img);
-        free(tmp);
-        return NULL;
-    }
+int* read_bin_file(const char* fn, int width, int height, int endian) {
+    return read_raw16_as_int(fn, width, height, endian, 0);
+}
 
-    free(tmp);
-    return img;
+int* read_bin_file_head(const char* fn, int width, int height, int endian, int head_size) {
+    return read_raw16_as_int(fn, width, height, endian, head_size);
 }
 
 unsigned char* read_8bit_bin_file(const char* fn, int width, int height) {
@@ -571,130 +507,41 @@ void int2BMP_color(const char* filename, int* R_map, int* G_map, int* B_map, int
 //}
 
 void int2CSV(const char* filename, int* img, int width, int height) {
+    if (csv_write_int(filename, img, width, height) != 0) {
+        printf("Write fail!\n");
+    }
+}
+
+// PerfEval scores.txt: one line per score with genuine and impostor counts
+void histogram2Scores(const char* filename, const int* genuine, const int* impostor, int length) {
     FILE* file;
 
     // for long file name
     char fn_long[1024];
     sprintf_s(fn_long, 1024, "\\\\?\\%s", filename);
 
-    if (fopen_s(&file, filename, "w") == 0) {
-        int need_comma = 0;
-        for (int i = 0; i < width * height; ++i) {
-            if (need_comma)
-                fprintf(file, ", ");
-            else
-                need_comma = 1;
-            if ((i % width) == 0 && i != 0) fprintf(file, "\n");
-            if (img[i] == -9999) {
-                fprintf(file, "NAN");
-            } else {
-                fprintf(file, "%i", img[i]);
-            }
-        }
-        fprintf(file, "\n");
-
-        fclose(file);
-    } else if (fopen_s(&file, fn_long, "w") == 0) {
-        int need_comma = 0;
-        for (int i = 0; i < width * height; ++i) {
-            if (need_comma)
-                fprintf(file, ", ");
-            else
-                need_comma = 1;
-            if ((i % width) == 0 && i != 0) fprintf(file, "\n");
-            if (img[i] == -9999) {
-                fprintf(file, "NAN");
-            } else {
-                fprintf(file, "%i", img[i]);
+    if (fopen_s(&file, filename, "w") == 0 || fopen_s(&file, fn_long, "w") == 0) {
+        fprintf(file, "%6s %12s %12s\n", "%score", "#genuines", "#impostors");
+        for (int score = 0; score < length; score++) {
+            if (genuine[score] || impostor[score]) {
+                fprintf(file, "%6d %12d %12d\n", score, genuine[score], impostor[score]);
             }
         }
-        fprintf(file, "\n");
-
         fclose(file);
     } else
         printf("Write fail!\n");
 }
 
 void US2CSV(const char* filename, unsigned short* img, int width, int height) {
-    FILE* file;
-
-    // for long file name
-    char fn_long[1024];
-    sprintf_s(fn_long, 1024, "\\\\?\\%s", filename);
-
-    if (fopen_s(&file, filename, "w") == 0) {
-        int need_comma = 0;
-        for (int i = 0; i < width * height; ++i) {
-            if (need_comma)
-                fprintf(file, ", ");
-            else
-                need_comma = 1;
-            if ((i % width) == 0 && i != 0) fprintf(file, "\n");
-            if (img[i] == -9999) {
-                fprintf(file, "NAN");
-            } else {
-                fprintf(file, "%i", img[i]);
-            }
-        }
-        fprintf(file, "\n");
-
-        fclose(file);
-    } else if (fopen_s(&file, fn_long, "w") == 0) {
-        int need_comma = 0;
-        for (int i = 0; i < width * height; ++i) {
-            if (need_comma)
-                fprintf(file, ", ");
-            else
-                need_comma = 1;
-            if ((i % width) == 0 && i != 0) fprintf(file, "\n");
-            if (img[i] == -9999) {
-                fprintf(file, "NAN");
-            } else {
-                fprintf(file, "%i", img[i]);
-            }
-        }
-        fprintf(file, "\n");
-
-        fclose(file);
-    } else
+    if (csv_write_u16(filename, img, width, height) != 0) {
         printf("Write fail!\n");
+    }
 }
 
 void U82CSV(const char* filename, unsigned char* _pimg, int width, int height) {
-    FILE* file;
-
-    // for long file name
-    char fn_long[1024];
-    sprintf_s(fn_long, 1024, "\\\\?\\%s", filename);
-
-    if (fopen_s(&file, filename, "w") == 0) {
-        int need_comma = 0;
-        for (int i = 0; i < width * height; ++i) {
-            if (need_comma)
-                fprintf(file, ", ");
-            else
-                need_comma = 1;
-            if ((i % width) == 0 && i != 0) fprintf(file, "\n");
-            fprintf(file, "%i", _pimg[i]);
-        }
-        fprintf(file, "\n");
-
-        fclose(file);
-    } else if (fopen_s(&file, fn_long, "w") == 0) {
-        int need_comma = 0;
-        for (int i = 0; i < width * height; ++i) {
-            if (need_comma)
-                fprintf(file, ", ");
-            else
-                need_comma = 1;
-            if ((i % width) == 0 && i != 0) fprintf(file, "\n");
-            fprintf(file, "%i", _pimg[i]);
-        }
-        fprintf(file, "\n");
-
-        fclose(file);
-    } else
+    if (csv_write_u8(filename, _pimg, width, height) != 0) {
         printf("Write fail!\n");
+    }
 }
 
 void normalize_int2UINT8(int* input, unsigned char* output, int SZ) {
@@ -46,6 +46,8 @@ void pgmWrite(const char *filename, int rows, int cols, unsigned char *image,
 void int2CSV(const char *filename, int *img, int width, int height);
 void US2CSV(const char *filename, unsigned short *img, int width, int height);
 void U82CSV(const char *filename, unsigned char *_pimg, int width, int height);
+void histogram2Scores(const char *filename, const int *genuine,
+                      const int *impostor, int length);
 
 void normalize_int2UINT8(int *input, unsigned char *output, int SZ);
 void normalize_float2UINT8(float *input, unsigned char *output, int SZ);
@@ -0,0 +1,472 @@
+#include "image_archive.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define ARCHIVE_MAGIC "PBIA"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_ALIGN 64
+#define ARCHIVE_MAX_PATH 1024
+
+// On-disk structures. Every field is naturally aligned so there is no padding;
+// they are written as is by little endian hosts.
+typedef struct archive_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t data_offset;
+    uint64_t index_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+} archive_header_t;
+
+typedef struct archive_entry {
+    uint64_t offset;
+    uint32_t width;
+    uint32_t height;
+    uint32_t name_offset;
+    uint32_t reserved;
+} archive_entry_t;
+
+struct image_archive {
+    unsigned char *base;
+    uint64_t size;
+    const archive_header_t *header;
+    const archive_entry_t *index;
+    const char *names;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+typedef struct writer_entry {
+    archive_entry_t entry;
+    char *name;
+} writer_entry_t;
+
+struct image_archive_writer {
+    FILE *f;
+    uint64_t offset;
+    writer_entry_t *entries;
+    int count;
+    int capacity;
+};
+
+/* Reading */
+
+static int archive_map(image_archive_t *archive, const char *fn) {
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    archive->file = CreateFileA(fn, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, NULL);
+    if (archive->file == INVALID_HANDLE_VALUE) {
+        archive->file = NULL;
+        return -1;
+    }
+    if (!GetFileSizeEx(archive->file, &size) || size.QuadPart == 0) {
+        return -1;
+    }
+    archive->size = (uint64_t)size.QuadPart;
+    // Copy-on-write, the matcher API takes non-const pixels
+    archive->mapping = CreateFileMappingA(archive->file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (archive->mapping == NULL) {
+        return -1;
+    }
+    archive->base = (unsigned char *)MapViewOfFile(archive->mapping, FILE_MAP_COPY, 0, 0, 0);
+    return archive->base != NULL ? 0 : -1;
+#else
+    struct stat st;
+    void *base;
+    int fd = open(fn, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    archive->size = (uint64_t)st.st_size;
+    // Copy-on-write, the matcher API takes non-const pixels
+    base = mmap(NULL, (size_t)archive->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+    archive->base = (unsigned char *)base;
+    return 0;
+#endif
+}
+
+static void archive_unmap(image_archive_t *archive) {
+#ifdef _WIN32
+    if (archive->base != NULL) {
+        UnmapViewOfFile(archive->base);
+    }
+    if (archive->mapping != NULL) {
+        CloseHandle(archive->mapping);
+    }
+    if (archive->file != NULL) {
+        CloseHandle(archive->file);
+    }
+#else
+    if (archive->base != NULL) {
+        munmap(archive->base, (size_t)archive->size);
+    }
+#endif
+    archive->base = NULL;
+}
+
+static int archive_validate(image_archive_t *archive) {
+    const archive_header_t *header = (const archive_header_t *)archive->base;
+    uint64_t size = archive->size;
+    uint32_t i;
+
+    if (size < sizeof(archive_header_t) || memcmp(header->magic, ARCHIVE_MAGIC, 4) != 0 ||
+        header->version != ARCHIVE_VERSION) {
+        return -1;
+    }
+    if (header->data_offset > header->index_offset ||
+        header->index_offset > size ||
+        (size - header->index_offset) / sizeof(archive_entry_t) < header->count ||
+        header->names_offset < header->index_offset + header->count * sizeof(archive_entry_t) ||
+        header->names_offset > size || header->names_size > size - header->names_offset) {
+        return -1;
+    }
+    archive->header = header;
+    archive->index = (const archive_entry_t *)(archive->base + header->index_offset);
+    archive->names = (const char *)(archive->base + header->names_offset);
+    if (header->count > 0 &&
+        (header->names_size == 0 || archive->names[header->names_size - 1] != '\0')) {
+        return -1;
+    }
+    for (i = 0; i < header->count; i++) {
+        const archive_entry_t *entry = &archive->index[i];
+        uint64_t pixels = (uint64_t)entry->width * entry->height;
+        if (entry->offset < header->data_offset || entry->offset > header->index_offset ||
+            pixels > header->index_offset - entry->offset ||
+            entry->name_offset >= header->names_size) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+image_archive_t *image_archive_open(const char *fn) {
+    image_archive_t *archive;
+    if (fn == NULL) {
+        return NULL;
+    }
+    archive = (image_archive_t *)calloc(1, sizeof(image_archive_t));
+    if (archive == NULL) {
+        return NULL;
+    }
+    if (archive_map(archive, fn) != 0 || archive_validate(archive) != 0) {
+        image_archive_close(archive);
+        return NULL;
+    }
+    return archive;
+}
+
+void image_archive_close(image_archive_t *archive) {
+    if (archive == NULL) {
+        return;
+    }
+    archive_unmap(archive);
+    free(archive);
+}
+
+int image_archive_count(const image_archive_t *archive) {
+    return archive != NULL ? (int)archive->header->count : 0;
+}
+
+unsigned char *image_archive_pixels(image_archive_t *archive, int index, int *width,
+                                    int *height) {
+    const archive_entry_t *entry;
+    if (archive == NULL || index < 0 || (uint32_t)index >= archive->header->count) {
+        return NULL;
+    }
+    entry = &archive->index[index];
+    if (width != NULL) {
+        *width = (int)entry->width;
+    }
+    if (height != NULL) {
+        *height = (int)entry->height;
+    }
+    return archive->base + entry->offset;
+}
+
+const char *image_archive_name(const image_archive_t *archive, int index) {
+    if (archive == NULL || index < 0 || (uint32_t)index >= archive->header->count) {
+        return NULL;
+    }
+    return archive->names + archive->index[index].name_offset;
+}
+
+int image_archive_find(const image_archive_t *archive, const char *name) {
+    int lo = 0, hi = image_archive_count(archive) - 1;
+    if (name == NULL) {
+        return -1;
+    }
+    // The index is sorted by name
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(archive->names + archive->index[mid].name_offset, name);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -1;
+}
+
+/* Writing */
+
+static int write_bytes(image_archive_writer_t *writer, const void *data, size_t len) {
+    if (len > 0 && fwrite(data, 1, len, writer->f) != len) {
+        return -1;
+    }
+    writer->offset += len;
+    return 0;
+}
+
+static int write_padding(image_archive_writer_t *writer) {
+    static const unsigned char zeros[ARCHIVE_ALIGN] = {0};
+    size_t pad = (size_t)((ARCHIVE_ALIGN - writer->offset % ARCHIVE_ALIGN) % ARCHIVE_ALIGN);
+    return write_bytes(writer, zeros, pad);
+}
+
+static void writer_free(image_archive_writer_t *writer) {
+    int i;
+    if (writer->f != NULL) {
+        fclose(writer->f);
+    }
+    for (i = 0; i < writer->count; i++) {
+        free(writer->entries[i].name);
+    }
+    free(writer->entries);
+    free(writer);
+}
+
+image_archive_writer_t *image_archive_create(const char *fn) {
+    archive_header_t header;
+    image_archive_writer_t *writer =
+        (image_archive_writer_t *)calloc(1, sizeof(image_archive_writer_t));
+    if (writer == NULL) {
+        return NULL;
+    }
+#ifdef _MSC_VER
+    fopen_s(&writer->f, fn, "wb");
+#else
+    writer->f = fopen(fn, "wb");
+#endif
+    if (writer->f == NULL) {
+        free(writer);
+        return NULL;
+    }
+    // Placeholder, rewritten by image_archive_finish
+    memset(&header, 0, sizeof(header));
+    if (write_bytes(writer, &header, sizeof(header)) != 0 || write_padding(writer) != 0) {
+        writer_free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+int image_archive_add(image_archive_writer_t *writer, const char *name,
+                      const unsigned char *pixels, int width, int height) {
+    writer_entry_t *entry;
+    size_t name_len;
+    if (writer == NULL || name == NULL || pixels == NULL || width <= 0 || height <= 0) {
+        return -1;
+    }
+    if (writer->count == writer->capacity) {
+        int capacity = writer->capacity > 0 ? writer->capacity * 2 : 1024;
+        writer_entry_t *entries =
+            (writer_entry_t *)realloc(writer->entries, capacity * sizeof(writer_entry_t));
+        if (entries == NULL) {
+            return -1;
+        }
+        writer->entries = entries;
+        writer->capacity = capacity;
+    }
+    entry = &writer->entries[writer->count];
+    name_len = strlen(name) + 1;
+    entry->name = (char *)malloc(name_len);
+    if (entry->name == NULL) {
+        return -1;
+    }
+    memcpy(entry->name, name, name_len);
+    entry->entry.offset = writer->offset;
+    entry->entry.width = (uint32_t)width;
+    entry->entry.height = (uint32_t)height;
+    entry->entry.name_offset = 0;
+    entry->entry.reserved = 0;
+    if (write_bytes(writer, pixels, (size_t)width * height) != 0 || write_padding(writer) != 0) {
+        free(entry->name);
+        return -1;
+    }
+    writer->count++;
+    return 0;
+}
+
+static int compare_entry_name(const void *a, const void *b) {
+    return strcmp(((const writer_entry_t *)a)->name, ((const writer_entry_t *)b)->name);
+}
+
+int image_archive_finish(image_archive_writer_t *writer) {
+    archive_header_t header;
+    uint64_t names_size = 0;
+    int count, i;
+    int ret = 0;
+
+    if (writer == NULL) {
+        return -1;
+    }
+    qsort(writer->entries, writer->count, sizeof(writer_entry_t), compare_entry_name);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ARCHIVE_MAGIC, 4);
+    header.version = ARCHIVE_VERSION;
+    header.count = (uint32_t)writer->count;
+    header.data_offset = (sizeof(archive_header_t) + ARCHIVE_ALIGN - 1) / ARCHIVE_ALIGN *
+                         ARCHIVE_ALIGN;
+    header.index_offset = writer->offset;
+    for (i = 0; i < writer->count && ret == 0; i++) {
+        writer->entries[i].entry.name_offset = (uint32_t)names_size;
+        names_size += strlen(writer->entries[i].name) + 1;
+        if (i > 0 && strcmp(writer->entries[i - 1].name, writer->entries[i].name) == 0) {
+            ret = -1;  // duplicate name, image_archive_find would be ambiguous
+        }
+        if (names_size > 0xFFFFFFFFu) {
+            ret = -1;
+        }
+    }
+    for (i = 0; i < writer->count && ret == 0; i++) {
+        ret = write_bytes(writer, &writer->entries[i].entry, sizeof(archive_entry_t));
+    }
+    header.names_offset = writer->offset;
+    header.names_size = names_size;
+    for (i = 0; i < writer->count && ret == 0; i++) {
+        ret = write_bytes(writer, writer->entries[i].name, strlen(writer->entries[i].name) + 1);
+    }
+    if (ret == 0 && (fseek(writer->f, 0, SEEK_SET) != 0 ||
+                     fwrite(&header, sizeof(header), 1, writer->f) != 1)) {
+        ret = -1;
+    }
+    if (fclose(writer->f) != 0) {
+        ret = -1;
+    }
+    writer->f = NULL;
+    count = writer->count;
+    writer_free(writer);
+    return ret == 0 ? count : -1;
+}
+
+/* Directory walk */
+
+static int walk_dir(char *path, size_t path_len, size_t root_len,
+                    void (*visit)(const char *path, const char *name, void *ctx), void *ctx) {
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE find;
+    if (path_len + 2 >= ARCHIVE_MAX_PATH) {
+        return -1;
+    }
+    strcpy_s(path + path_len, ARCHIVE_MAX_PATH - path_len, "\\*");
+    find = FindFirstFileA(path, &data);
+    path[path_len] = '\0';
+    if (find == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+    do {
+        const char *entry = data.cFileName;
+        size_t len = strlen(entry);
+        if (strcmp(entry, ".") == 0 || strcmp(entry, "..") == 0 ||
+            path_len + 1 + len >= ARCHIVE_MAX_PATH) {
+            continue;
+        }
+        path[path_len] = '\\';
+        memcpy(path + path_len + 1, entry, len + 1);
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            walk_dir(path, path_len + 1 + len, root_len, visit, ctx);
+        } else {
+            // Names use '/' whatever the platform
+            char name[ARCHIVE_MAX_PATH];
+            char *p;
+            strcpy_s(name, ARCHIVE_MAX_PATH, path + root_len + 1);
+            for (p = name; *p; p++) {
+                if (*p == '\\') {
+                    *p = '/';
+                }
+            }
+            visit(path, name, ctx);
+        }
+        path[path_len] = '\0';
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+    return 0;
+#else
+    struct dirent *entry;
+    DIR *d = opendir(path);
+    if (d == NULL) {
+        return -1;
+    }
+    while ((entry = readdir(d)) != NULL) {
+        struct stat st;
+        size_t len = strlen(entry->d_name);
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 ||
+            path_len + 1 + len >= ARCHIVE_MAX_PATH) {
+            continue;
+        }
+        path[path_len] = '/';
+        memcpy(path + path_len + 1, entry->d_name, len + 1);
+        if (stat(path, &st) == 0) {
+            if (S_ISDIR(st.st_mode)) {
+                walk_dir(path, path_len + 1 + len, root_len, visit, ctx);
+            } else if (S_ISREG(st.st_mode)) {
+                visit(path, path + root_len + 1, ctx);
+            }
+        }
+        path[path_len] = '\0';
+    }
+    closedir(d);
+    return 0;
+#endif
+}
+
+int image_archive_walk_dir(const char *dir,
+                           void (*visit)(const char *path, const char *name, void *ctx),
+                           void *ctx) {
+    char path[ARCHIVE_MAX_PATH];
+    size_t len;
+    if (dir == NULL || visit == NULL) {
+        return -1;
+    }
+    len = strlen(dir);
+    while (len > 1 && (dir[len - 1] == '/' || dir[len - 1] == '\\')) {
+        len--;
+    }
+    if (len == 0 || len >= ARCHIVE_MAX_PATH) {
+        return -1;
+    }
+    memcpy(path, dir, len);
+    path[len] = '\0';
+    return walk_dir(path, len, len, visit, ctx);
+}
@@ -0,0 +1,99 @@
+#ifndef IMAGE_ARCHIVE_H_
+#define IMAGE_ARCHIVE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * Packed image archive.
+ *
+ * Holds many small 8-bit images in one file so a dataset is opened once instead of
+ * once per image. Layout (little endian):
+ *
+ *   header   magic "PBIA", version, image count, offsets of index, names and data
+ *   data     the pixels of every image, each image starting on a 64 byte boundary
+ *   index    one entry per image: data offset, width, height, name offset,
+ *            sorted by name
+ *   names    NUL terminated image names
+ *
+ * The archive is read through a memory mapping, image_archive_pixels() points
+ * straight into the mapping so the pixels can be handed to the matcher without a
+ * copy. The mapping is copy-on-write: writes to the pixels stay private to the
+ * process and never reach the file.
+ */
+
+#define IMAGE_ARCHIVE_EXT ".pbia"
+
+typedef struct image_archive image_archive_t;
+typedef struct image_archive_writer image_archive_writer_t;
+
+/**
+ * Map the archive fn.
+ *
+ * @return
+ *  the archive, or NULL if fn is missing or not a valid archive.
+ */
+image_archive_t *image_archive_open(const char *fn);
+
+void image_archive_close(image_archive_t *archive);
+
+int image_archive_count(const image_archive_t *archive);
+
+/**
+ * @return
+ *  the pixels of image index (0 <= index < count), valid until the archive is
+ *  closed, or NULL for a bad index.
+ */
+unsigned char *image_archive_pixels(image_archive_t *archive, int index,
+                                    int *width, int *height);
+
+const char *image_archive_name(const image_archive_t *archive, int index);
+
+/**
+ * @return
+ *  the index of the image called name, or -1.
+ */
+int image_archive_find(const image_archive_t *archive, const char *name);
+
+/**
+ * Start writing the archive fn, replacing any existing file.
+ */
+image_archive_writer_t *image_archive_create(const char *fn);
+
+/**
+ * Append a width x height 8-bit image. Names must be unique.
+ *
+ * @return
+ *  0, or -1 on a write failure.
+ */
+int image_archive_add(image_archive_writer_t *writer, const char *name,
+                      const unsigned char *pixels, int width, int height);
+
+/**
+ * Write the index and close the archive. The writer is freed in any case.
+ *
+ * @return
+ *  number of images in the archive, or -1 on failure.
+ */
+int image_archive_finish(image_archive_writer_t *writer);
+
+/**
+ * Call visit for every regular file below dir, in directory order. name is the
+ * path relative to dir with '/' separators.
+ *
+ * @return
+ *  0, or -1 if dir cannot be read.
+ */
+int image_archive_walk_dir(const char *dir,
+                           void (*visit)(const char *path, const char *name,
+                                         void *ctx),
+                           void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+#include "image_prefetcher.h"
+
+#include <chrono>
+#include <cstdlib>
+
+#include "../g5matcher/g5_trace.h"
+
+using namespace std;
+
+typedef chrono::high_resolution_clock Clock;
+
+static double ElapsedMs(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+ImagePrefetcher::ImagePrefetcher(LoadFn load, size_t nbr_of_items, int nbr_of_io_threads,
+                                 size_t depth)
+    : load_(load),
+      nbr_of_items_(nbr_of_items),
+      depth_(depth > 0 ? depth : 1),
+      next_load_(0),
+      nbr_of_popped_(0),
+      stop_(false),
+      sum_depth_(0),
+      max_depth_(0),
+      empty_pops_(0),
+      consumer_stall_ms_(0),
+      producer_stall_ms_(0),
+      load_ms_(0) {
+    if (nbr_of_io_threads <= 0) {
+        nbr_of_io_threads = 1;
+    }
+    for (int i = 0; i < nbr_of_io_threads; i++) {
+        threads_.push_back(thread(&ImagePrefetcher::IoThread, this, i));
+    }
+}
+
+ImagePrefetcher::~ImagePrefetcher() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+    for (size_t i = 0; i < threads_.size(); i++) {
+        threads_[i].join();
+    }
+    while (!queue_.empty()) {
+        FreeItem(queue_.front());
+        queue_.pop_front();
+    }
+}
+
+void ImagePrefetcher::IoThread(int thread_index) {
+    g5_trace_set_thread_name("loader", thread_index);
+    for (;;) {
+        size_t index;
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (stop_ || next_load_ >= nbr_of_items_) {
+                return;
+            }
+            index = next_load_++;
+        }
+
+        PrefetchItem item;
+        item.index = index;
+        item.w = 0;
+        item.h = 0;
+        Clock::time_point start = Clock::now();
+        G5_TRACE_SET_PAIR((int)index);
+        G5_TRACE_BEGIN("load");
+        item.ok = load_(index, item);
+        G5_TRACE_END("load");
+        double load_ms = ElapsedMs(start);
+
+        unique_lock<mutex> lock(mutex_);
+        load_ms_ += load_ms;
+        // Wait for a free slot, the queue never holds more than depth items
+        start = Clock::now();
+        if (!stop_ && queue_.size() >= depth_) {
+            G5_TRACE_BEGIN("queue full");
+            while (!stop_ && queue_.size() >= depth_) {
+                not_full_.wait(lock);
+            }
+            G5_TRACE_END("queue full");
+        }
+        producer_stall_ms_ += ElapsedMs(start);
+        if (stop_) {
+            FreeItem(item);
+            return;
+        }
+        queue_.push_back(item);
+        not_empty_.notify_one();
+    }
+}
+
+bool ImagePrefetcher::Pop(PrefetchItem& item) {
+    unique_lock<mutex> lock(mutex_);
+    if (nbr_of_popped_ >= nbr_of_items_) {
+        return false;
+    }
+    // Claim an item before waiting, so exactly nbr_of_items pops succeed
+    nbr_of_popped_++;
+    sum_depth_ += (double)queue_.size();
+    if (queue_.size() > max_depth_) {
+        max_depth_ = queue_.size();
+    }
+    if (queue_.empty()) {
+        empty_pops_++;
+        Clock::time_point start = Clock::now();
+        G5_TRACE_BEGIN("queue empty");
+        while (!stop_ && queue_.empty()) {
+            not_empty_.wait(lock);
+        }
+        G5_TRACE_END("queue empty");
+        consumer_stall_ms_ += ElapsedMs(start);
+        if (queue_.empty()) {
+            return false;
+        }
+    }
+    item = queue_.front();
+    queue_.pop_front();
+    not_full_.notify_one();
+    return true;
+}
+
+PrefetchStats ImagePrefetcher::GetStats() {
+    lock_guard<mutex> lock(mutex_);
+    PrefetchStats stats;
+    stats.items = nbr_of_popped_;
+    stats.depth = depth_;
+    stats.mean_depth = nbr_of_popped_ > 0 ? sum_depth_ / nbr_of_popped_ : 0;
+    stats.max_depth = max_depth_;
+    stats.empty_pops = empty_pops_;
+    stats.consumer_stall_ms = consumer_stall_ms_;
+    stats.producer_stall_ms = producer_stall_ms_;
+    stats.load_ms = load_ms_;
+    return stats;
+}
+
+void ImagePrefetcher::FreeItem(PrefetchItem& item) {
+    for (size_t i = 0; i < item.images.size(); i++) {
+        free(item.images[i]);
+    }
+    item.images.clear();
+}
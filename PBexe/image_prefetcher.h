@@ -0,0 +1,78 @@
+#ifndef IMAGE_PREFETCHER_H
+#define IMAGE_PREFETCHER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One unit of work handed from the I/O threads to the consumers, e.g. the two images of
+// a comparison. The consumer owns the images once the item has been popped.
+struct PrefetchItem {
+    size_t index;
+    std::vector<unsigned char*> images;
+    int w;
+    int h;
+    bool ok;  // false when loading failed, images may be partially set
+};
+
+struct PrefetchStats {
+    size_t items;
+    size_t depth;               // configured queue capacity
+    double mean_depth;          // queue depth seen by the consumers, before each pop
+    size_t max_depth;
+    size_t empty_pops;          // pops that found the queue empty and had to wait
+    double consumer_stall_ms;   // total time consumers waited for an item
+    double producer_stall_ms;   // total time I/O threads waited for a free slot
+    double load_ms;             // total time I/O threads spent loading
+};
+
+// Bounded queue of loaded items filled by a pool of I/O threads.
+//
+// Items 0 .. nbr_of_items - 1 are loaded in index order by nbr_of_io_threads threads
+// and queued, at most depth items ahead of the consumers. Consumers call Pop() from any
+// number of threads; items arrive roughly but not strictly in index order.
+class ImagePrefetcher {
+   public:
+    // Loads item index into item, returning false on failure. Called concurrently from
+    // the I/O threads.
+    typedef std::function<bool(size_t index, PrefetchItem& item)> LoadFn;
+
+    ImagePrefetcher(LoadFn load, size_t nbr_of_items, int nbr_of_io_threads, size_t depth);
+    // Stops the I/O threads and frees the items not popped.
+    ~ImagePrefetcher();
+
+    // Blocks until an item is available. Returns false once all items have been popped.
+    bool Pop(PrefetchItem& item);
+
+    PrefetchStats GetStats();
+
+    static void FreeItem(PrefetchItem& item);
+
+   private:
+    void IoThread(int thread_index);
+
+    LoadFn load_;
+    size_t nbr_of_items_;
+    size_t depth_;
+    size_t next_load_;
+    size_t nbr_of_popped_;
+    bool stop_;
+    std::deque<PrefetchItem> queue_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::vector<std::thread> threads_;
+
+    // statistics, guarded by mutex_
+    double sum_depth_;
+    size_t max_depth_;
+    size_t empty_pops_;
+    double consumer_stall_ms_;
+    double producer_stall_ms_;
+    double load_ms_;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "image_writer.h"
+
+#include <chrono>
+#include <fstream>
+
+#include "opencv2/imgcodecs.hpp"
+
+using namespace std;
+
+typedef chrono::high_resolution_clock Clock;
+
+static double ElapsedMs(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+ImageWriter::ImageWriter(int nbr_of_threads, size_t depth, int level)
+    : depth_(depth > 0 ? depth : 1), level_(level), nbr_of_busy_(0), stop_(false) {
+    stats_.images = 0;
+    stats_.errors = 0;
+    stats_.max_depth = 0;
+    stats_.bytes = 0;
+    stats_.encode_ms = 0;
+    stats_.write_ms = 0;
+    stats_.producer_stall_ms = 0;
+    if (nbr_of_threads <= 0) {
+        nbr_of_threads = 1;
+    }
+    for (int i = 0; i < nbr_of_threads; i++) {
+        threads_.push_back(thread(&ImageWriter::WriterThread, this));
+    }
+}
+
+ImageWriter::~ImageWriter() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    not_empty_.notify_all();
+    for (size_t i = 0; i < threads_.size(); i++) {
+        threads_[i].join();
+    }
+}
+
+void ImageWriter::Write(const string& path, const cv::Mat& image) {
+    unique_lock<mutex> lock(mutex_);
+    Clock::time_point start = Clock::now();
+    while (queue_.size() >= depth_) {
+        not_full_.wait(lock);
+    }
+    stats_.producer_stall_ms += ElapsedMs(start);
+    Job job;
+    job.path = path;
+    job.image = image;
+    queue_.push_back(job);
+    if (queue_.size() > stats_.max_depth) {
+        stats_.max_depth = queue_.size();
+    }
+    not_empty_.notify_one();
+}
+
+void ImageWriter::Flush() {
+    unique_lock<mutex> lock(mutex_);
+    while (!queue_.empty() || nbr_of_busy_ > 0) {
+        idle_.wait(lock);
+    }
+}
+
+ImageWriterStats ImageWriter::GetStats() {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+vector<int> ImageWriter::EncodeParams(const string& ext) {
+    vector<int> params;
+    if (level_ < 0) {
+        return params;
+    }
+    if (ext == ".png") {
+        params.push_back(cv::IMWRITE_PNG_COMPRESSION);
+        params.push_back(level_ > 9 ? 9 : level_);
+    } else if (ext == ".jpg" || ext == ".jpeg") {
+        params.push_back(cv::IMWRITE_JPEG_QUALITY);
+        params.push_back(level_ > 100 ? 100 : level_);
+    }
+    return params;
+}
+
+void ImageWriter::WriterThread() {
+    for (;;) {
+        Job job;
+        {
+            unique_lock<mutex> lock(mutex_);
+            // Drain the queue before stopping
+            while (!stop_ && queue_.empty()) {
+                not_empty_.wait(lock);
+            }
+            if (queue_.empty()) {
+                return;
+            }
+            job = queue_.front();
+            queue_.pop_front();
+            nbr_of_busy_++;
+        }
+        not_full_.notify_one();
+
+        size_t dot = job.path.rfind('.');
+        string ext = dot == string::npos ? ".png" : job.path.substr(dot);
+        vector<uchar> buf;
+        Clock::time_point start = Clock::now();
+        bool ok = cv::imencode(ext, job.image, buf, EncodeParams(ext));
+        double encode_ms = ElapsedMs(start);
+
+        start = Clock::now();
+        if (ok) {
+            ofstream file(job.path.c_str(), ios::binary);
+            file.write((const char*)&buf[0], buf.size());
+            file.close();
+            ok = !file.fail();
+        }
+        double write_ms = ElapsedMs(start);
+
+        lock_guard<mutex> lock(mutex_);
+        stats_.encode_ms += encode_ms;
+        stats_.write_ms += write_ms;
+        if (ok) {
+            stats_.images++;
+            stats_.bytes += buf.size();
+        } else {
+            stats_.errors++;
+        }
+        nbr_of_busy_--;
+        if (queue_.empty() && nbr_of_busy_ == 0) {
+            idle_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+struct ImageWriterStats {
+    size_t images;              // images written
+    size_t errors;              // images that could not be encoded or written
+    size_t max_depth;           // most images queued at once
+    unsigned long long bytes;   // encoded bytes written
+    double encode_ms;           // total time writer threads spent encoding
+    double write_ms;            // total time writer threads spent writing files
+    double producer_stall_ms;   // total time Write() callers waited for a free slot
+};
+
+// Pool of background threads that encode images and write them to disk.
+//
+// The format follows the file extension (.png or .jpg). Write() queues an image and
+// returns, so rendering threads do not wait for the encoder unless depth images are
+// already queued.
+class ImageWriter {
+   public:
+    // level is the PNG compression level (0 fastest - 9 smallest) or the JPEG quality
+    // (0 - 100), -1 keeps the OpenCV default.
+    ImageWriter(int nbr_of_threads, size_t depth, int level);
+    // Writes the images still queued.
+    ~ImageWriter();
+
+    // Queue image to be written to path. The pixels are shared, not copied; the caller
+    // must not modify them afterwards.
+    void Write(const std::string& path, const cv::Mat& image);
+
+    // Blocks until all queued images have been written.
+    void Flush();
+
+    ImageWriterStats GetStats();
+
+   private:
+    struct Job {
+        std::string path;
+        cv::Mat image;
+    };
+
+    void WriterThread();
+    std::vector<int> EncodeParams(const std::string& ext);
+
+    size_t depth_;
+    int level_;
+    size_t nbr_of_busy_;
+    bool stop_;
+    std::deque<Job> queue_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::condition_variable idle_;
+    std::vector<std::thread> threads_;
+
+    // statistics, guarded by mutex_
+    ImageWriterStats stats_;
+};
+
+#endif
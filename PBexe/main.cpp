@@ -7,11 +7,44 @@
 |*  Copyright (C) 2007-2018 Egis Technology Inc.                              *|
 |*                                                                            *|
 \******************************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "../g5matcher/g5_arena.h"
+#include "../g5matcher/g5_batch.h"
+#include "../g5matcher/g5_decision_store.h"
+#include "../g5matcher/g5_enroll.h"
+#include "../g5matcher/g5_eval.h"
+#include "../g5matcher/g5_identifier.h"
+#include "../g5matcher/g5_latency.h"
 #include "../g5matcher/g5_match.h"
+#include "../g5matcher/g5_mem.h"
+#include "../g5matcher/g5_pool.h"
+#include "../g5matcher/g5_sweep.h"
+#include "../g5matcher/g5_template_store.h"
+#include "../g5matcher/g5_trace.h"
+#include "../g5matcher/pb_alignment.h"
+#include "../g5matcher/pb_finger.h"
+#include "../g5matcher/pb_image.h"
+#include "../g5matcher/pb_session.h"
+#include "../g5matcher/pb_template.h"
+#include "../g5matcher/pb_user.h"
+#include "../g5matcher/plat_log_async.h"
+#include "contact_sheet.h"
+#include "csv_writer.h"
 #include "fileio.h"
+#include "image_archive.h"
+#include "image_prefetcher.h"
+#include "image_writer.h"
 #include "merge_opencv.h"
+#include "raw16.h"
 
 using namespace std;
 
@@ -27,13 +60,1856 @@ using namespace std;
     }
 #endif
 
-int main(int argc, char** argv) {
-    if (argc == 3 || argc == 4) {
+static unsigned char* LoadImage(MergeOpencv& mergeOpencv, const string& sImg, int& w, int& h) {
+    unsigned char* pimg = NULL;
+    if (sImg.find(".png") != std::string::npos) {
+        pimg = (unsigned char*)plat_alloc(w * h * sizeof(unsigned char));
+        if (pimg == NULL) {
+            return NULL;
+        }
+        if (!mergeOpencv.ReadPng(sImg, pimg, w, h)) {
+            PLAT_FREE(pimg);
+        }
+    } else {
+        pimg = read_8bit_bin_file(sImg.c_str(), w, h);
+    }
+    return pimg;
+}
+
+// sList is a text file with one image path per line, or a packed image archive
+// (IMAGE_ARCHIVE_EXT). Archive images point into the mapped archive, which is returned
+// in archive and released by FreeImageList.
+static bool LoadImageList(MergeOpencv& mergeOpencv, const string& sList,
+                          vector<unsigned char*>& images, int& w, int& h,
+                          image_archive_t*& archive) {
+    const string sExt = IMAGE_ARCHIVE_EXT;
+    if (sList.size() > sExt.size() &&
+        sList.compare(sList.size() - sExt.size(), sExt.size(), sExt) == 0) {
+        archive = image_archive_open(sList.c_str());
+        if (archive == NULL) {
+            printf("Open image archive %s fail\n", sList.c_str());
+            return false;
+        }
+        int nbr_of_images = image_archive_count(archive);
+        for (int i = 0; i < nbr_of_images; i++) {
+            int image_w = 0, image_h = 0;
+            unsigned char* pimg = image_archive_pixels(archive, i, &image_w, &image_h);
+            if (i == 0) {
+                w = image_w;
+                h = image_h;
+            } else if (image_w != w || image_h != h) {
+                printf("Image %s is %ix%i, expected %ix%i\n", image_archive_name(archive, i),
+                       image_w, image_h, w, h);
+                return false;
+            }
+            images.push_back(pimg);
+        }
+        return !images.empty();
+    }
+
+    ifstream list(sList.c_str());
+    if (!list) {
+        printf("Open image list %s fail\n", sList.c_str());
+        return false;
+    }
+    string sImg;
+    while (getline(list, sImg)) {
+        if (!sImg.empty() && sImg[sImg.size() - 1] == '\r') {
+            sImg.erase(sImg.size() - 1);
+        }
+        if (sImg.empty()) {
+            continue;
+        }
+        unsigned char* pimg = LoadImage(mergeOpencv, sImg, w, h);
+        if (pimg == NULL) {
+            printf("Load image file %s fail\n", sImg.c_str());
+            return false;
+        }
+        images.push_back(pimg);
+    }
+    return !images.empty();
+}
+
+static void FreeImageList(vector<unsigned char*>& images, image_archive_t*& archive) {
+    if (archive != NULL) {
+        image_archive_close(archive);
+        archive = NULL;
+    } else {
+        for (size_t i = 0; i < images.size(); i++) {
+            PLAT_FREE(images[i]);
+        }
+    }
+    images.clear();
+}
+
+// PBexe -batch <probe_list> [max_threads] [gallery_list]
+// Without a gallery list the probes are compared all-vs-all (i < j). The run is repeated
+// with 1, 2, 4, ... max_threads workers to show how throughput scales with core count.
+static int RunBatch(int argc, char** argv) {
+    int w = 200, h = 200;
+    int max_threads = argc > 3 ? atoi(argv[3]) : 1;
+    MergeOpencv mergeOpencv;
+    vector<unsigned char*> probes, gallery;
+    image_archive_t *probes_archive = NULL, *gallery_archive = NULL;
+
+    if (!LoadImageList(mergeOpencv, argv[2], probes, w, h, probes_archive) ||
+        (argc > 4 && !LoadImageList(mergeOpencv, argv[4], gallery, w, h, gallery_archive))) {
+        FreeImageList(probes, probes_archive);
+        FreeImageList(gallery, gallery_archive);
+        return -1;
+    }
+    if (max_threads <= 0) {
+        max_threads = 1;
+    }
+
+    g5_batch_result_t result = {0};
+    double base_rate = 0;
+    for (int nbr_of_threads = 1;; nbr_of_threads *= 2) {
+        if (nbr_of_threads > max_threads) {
+            nbr_of_threads = max_threads;
+        }
+        g5_batch_result_free(&result);
+        // fresh cache per run so every run pays the same extraction cost
+        g5_template_cache_t* cache = g5_template_cache_create(256 * 1024 * 1024, 0);
+
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        int ret = g5_batch_compare(&probes[0], (int)probes.size(),
+                                   gallery.empty() ? NULL : &gallery[0], (int)gallery.size(), w,
+                                   h, NULL, nbr_of_threads, cache, &result);
+        double seconds =
+            chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        g5_template_cache_destroy(cache);
+        if (ret != 0) {
+            printf("g5_batch_compare fail, ret = %i\n", ret);
+            break;
+        }
+
+        int nbr_of_pairs = 0;
+        for (int i = 0; i < result.nbr_of_workers; i++) {
+            nbr_of_pairs += result.pairs_per_worker[i];
+        }
+        double rate = seconds > 0 ? nbr_of_pairs / seconds : 0;
+        if (nbr_of_threads == 1) {
+            base_rate = rate;
+        }
+        printf("threads = %i, pairs = %i, failed = %i, time = %.3f s, pairs/s = %.1f, "
+               "speedup = %.2f\n",
+               nbr_of_threads, nbr_of_pairs, result.nbr_of_failed, seconds, rate,
+               base_rate > 0 ? rate / base_rate : 0);
+        if (nbr_of_threads == max_threads) {
+            break;
+        }
+    }
+
+    if (result.score != NULL) {
+        int2CSV("batch_score.csv", result.score, result.cols, result.rows);
+        int2CSV("batch_rot.csv", result.rot, result.cols, result.rows);
+        int2CSV("batch_dx.csv", result.dx, result.cols, result.rows);
+        int2CSV("batch_dy.csv", result.dy, result.cols, result.rows);
+        int2CSV("batch_status.csv", result.status, result.cols, result.rows);
+    }
+    int nbr_of_failed = result.nbr_of_failed;
+    g5_batch_result_free(&result);
+    FreeImageList(probes, probes_archive);
+    FreeImageList(gallery, gallery_archive);
+    return nbr_of_failed == 0 ? 0 : -1;
+}
+
+// PBexe -identify <gallery_list> <probe_list> [growth]
+// Loads the first 1, growth, growth^2, ... gallery images (and finally all of them) as the
+// gallery and identifies every probe against it: the probe is extracted once and verified
+// against each gallery template with verify_template_v2, which leaves the gallery as loaded.
+// Reports how probe latency grows with the gallery size.
+static int RunIdentify(int argc, char** argv) {
+    int w = 200, h = 200;
+    int growth = argc > 4 ? atoi(argv[4]) : 2;
+    MergeOpencv mergeOpencv;
+    vector<unsigned char*> gallery, probes;
+    image_archive_t *gallery_archive = NULL, *probes_archive = NULL;
+
+    if (!LoadImageList(mergeOpencv, argv[2], gallery, w, h, gallery_archive) ||
+        !LoadImageList(mergeOpencv, argv[3], probes, w, h, probes_archive)) {
+        FreeImageList(gallery, gallery_archive);
+        FreeImageList(probes, probes_archive);
+        return -1;
+    }
+    if (gallery.empty() || probes.empty()) {
+        printf("Empty gallery or probe list\n");
+        FreeImageList(gallery, gallery_archive);
+        FreeImageList(probes, probes_archive);
+        return -1;
+    }
+    if (growth < 2) {
+        growth = 2;
+    }
+
+    g5_matcher_t* matcher = g5_matcher_create(NULL);
+    if (matcher == NULL) {
+        printf("G5 matcher init fail\n");
+        FreeImageList(gallery, gallery_archive);
+        FreeImageList(probes, probes_archive);
+        return -1;
+    }
+
+    int nbr_of_gallery = (int)gallery.size();
+    int nbr_of_probes = (int)probes.size();
+    vector<int> scores(nbr_of_gallery);
+    vector<int> decisions(nbr_of_probes * 3);  // match_index, match_score, rot per probe
+    vector<double> latency(nbr_of_probes);
+    bool loaded = true;
+    int nbr_of_failed = 0;
+    for (int gallery_size = 1;; gallery_size *= growth) {
+        if (gallery_size > nbr_of_gallery) {
+            gallery_size = nbr_of_gallery;
+        }
+
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        int ret = g5_matcher_load_gallery(matcher, &gallery[0], gallery_size, w, h);
+        double load_ms =
+            chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        if (ret != 0) {
+            printf("g5_matcher_load_gallery fail, ret = %i\n", ret);
+            loaded = false;
+            break;
+        }
+
+        int nbr_of_accepts = 0;
+        for (int i = 0; i < nbr_of_probes; i++) {
+            g5_identify_result_t result = {0};
+            result.match_score_array = &scores[0];
+            start = chrono::high_resolution_clock::now();
+            ret = g5_matcher_identify(matcher, probes[i], w, h, &result);
+            latency[i] = chrono::duration<double, milli>(chrono::high_resolution_clock::now() -
+                                                         start).count();
+            if (ret != 0) {
+                printf("g5_matcher_identify probe %i fail, ret = %i\n", i, ret);
+                nbr_of_failed++;
+            }
+            if (result.match_index >= 0) {
+                nbr_of_accepts++;
+            }
+            decisions[i * 3] = result.match_index;
+            decisions[i * 3 + 1] = result.match_score;
+            decisions[i * 3 + 2] = result.rot;
+        }
+
+        double total_ms = 0;
+        for (int i = 0; i < nbr_of_probes; i++) {
+            total_ms += latency[i];
+        }
+        sort(latency.begin(), latency.end());
+        double mean_ms = total_ms / nbr_of_probes;
+        printf("gallery = %i, load = %.1f ms, probe mean = %.3f ms, p50 = %.3f ms, "
+               "p99 = %.3f ms, max = %.3f ms, per template = %.2f us, accepted = %i/%i\n",
+               gallery_size, load_ms, mean_ms, latency[nbr_of_probes / 2],
+               latency[(nbr_of_probes * 99) / 100], latency[nbr_of_probes - 1],
+               mean_ms * 1000 / gallery_size, nbr_of_accepts, nbr_of_probes);
+        if (gallery_size == nbr_of_gallery) {
+            break;
+        }
+    }
+
+    // Only a gallery that loaded in full gives the decisions of the full gallery
+    if (loaded) {
+        int2CSV("identify.csv", &decisions[0], 3, nbr_of_probes);
+    }
+    g5_matcher_destroy(matcher);
+    FreeImageList(gallery, gallery_archive);
+    FreeImageList(probes, probes_archive);
+    return loaded && nbr_of_failed == 0 ? 0 : -1;
+}
+
+static bool ExtractTemplates(g5_matcher_t* matcher, vector<unsigned char*>& images, int w, int h,
+                             vector<pb_template_t*>& templates) {
+    for (size_t i = 0; i < images.size(); i++) {
+        unsigned char* temp = NULL;
+        int temp_size = 0;
+        int ret = g5_matcher_extract(matcher, images[i], w, h, &temp, &temp_size);
+        if (temp == NULL) {
+            printf("g5_matcher_extract image %i fail, ret = %i\n", (int)i, ret);
+            return false;
+        }
+        templates.push_back(pb_template_create(G5_TEMPLATE_TYPE, temp, temp_size));
+        g5_matcher_free_template(temp);
+    }
+    return true;
+}
+
+static void DeleteTemplates(vector<pb_template_t*>& templates) {
+    for (size_t i = 0; i < templates.size(); i++) {
+        pb_template_delete(templates[i]);
+    }
+    templates.clear();
+}
+
+// Columns of rank.csv per candidate: gallery index, score, dx, dy, rot
+#define RANK_COLUMNS 5
+
+// PBexe -rank <gallery_list> <probe_list> [k] [max_threads]
+// Identifies every probe with pb_identifier_identify_template_rank on a G5 identifier and
+// returns the top-k gallery fingers with their scores and alignments. The run is repeated
+// with 1, 2, 4, ... max_threads identifier worker threads to find where throughput stops
+// scaling.
+static int RunRank(int argc, char** argv) {
+    int w = 200, h = 200;
+    int rank = argc > 4 ? atoi(argv[4]) : 10;
+    int max_threads = argc > 5 ? atoi(argv[5]) : 1;
+    MergeOpencv mergeOpencv;
+    vector<unsigned char*> gallery, probes;
+    image_archive_t *gallery_archive = NULL, *probes_archive = NULL;
+
+    if (!LoadImageList(mergeOpencv, argv[2], gallery, w, h, gallery_archive) ||
+        !LoadImageList(mergeOpencv, argv[3], probes, w, h, probes_archive)) {
+        FreeImageList(gallery, gallery_archive);
+        FreeImageList(probes, probes_archive);
+        return -1;
+    }
+    rank = min(max(rank, 1), 255);
+    max_threads = min(max(max_threads, 1), 255);
+
+    // Templates are extracted once, the sweep only measures identification
+    vector<pb_template_t*> gallery_templates, probe_templates;
+    g5_matcher_t* matcher = g5_matcher_create(NULL);
+    bool extracted = matcher != NULL &&
+                     ExtractTemplates(matcher, gallery, w, h, gallery_templates) &&
+                     ExtractTemplates(matcher, probes, w, h, probe_templates);
+    g5_matcher_destroy(matcher);
+    FreeImageList(gallery, gallery_archive);
+    FreeImageList(probes, probes_archive);
+    if (!extracted) {
+        DeleteTemplates(gallery_templates);
+        DeleteTemplates(probe_templates);
+        return -1;
+    }
+
+    int nbr_of_gallery = (int)gallery_templates.size();
+    int nbr_of_probes = (int)probe_templates.size();
+    vector<pb_finger_t*> fingers(nbr_of_gallery);
+    for (int i = 0; i < nbr_of_gallery; i++) {
+        // user id i + 1 is gallery index i, 0 means no user
+        pb_user_t* user = pb_user_create(i + 1);
+        fingers[i] = pb_finger_create(PB_FINGER_POSITION_UNKNOWN, user);
+        pb_user_delete(user);
+    }
+
+    pb_session_t* session = pb_session_create();
+    vector<int> ranks(nbr_of_probes * rank * RANK_COLUMNS);
+    vector<pb_finger_t*> identified(rank);
+    vector<uint16_t> scores(rank);
+    vector<pb_alignment_t*> alignments(rank);
+    double base_rate = 0;
+    int nbr_of_failed = 0;
+    bool completed = true;
+    for (int nbr_of_threads = 1;; nbr_of_threads *= 2) {
+        if (nbr_of_threads > max_threads) {
+            nbr_of_threads = max_threads;
+        }
+        pb_identifier_t* identifier = g5_identifier_create(session, nbr_of_threads, NULL);
+        if (identifier == NULL) {
+            printf("g5_identifier_create fail, threads = %i\n", nbr_of_threads);
+            completed = false;
+            break;
+        }
+        pb_rc_t rc = PB_RC_OK;
+        for (int i = 0; i < nbr_of_gallery && rc == PB_RC_OK; i += 0xFFFF) {
+            rc = pb_identifier_add_templates(identifier, &gallery_templates[i], &fingers[i], NULL,
+                                             (uint16_t)min(nbr_of_gallery - i, 0xFFFF));
+        }
+        if (rc != PB_RC_OK) {
+            printf("pb_identifier_add_templates fail, rc = %u\n", rc);
+            pb_identifier_delete(identifier);
+            completed = false;
+            break;
+        }
+
+        int run_failed = 0;
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < nbr_of_probes; i++) {
+            // A failed call may return before writing the outputs, the pointers of the
+            // previous probe are already deleted
+            fill(identified.begin(), identified.end(), (pb_finger_t*)NULL);
+            fill(alignments.begin(), alignments.end(), (pb_alignment_t*)NULL);
+            fill(scores.begin(), scores.end(), (uint16_t)0);
+            rc = pb_identifier_identify_template_rank(identifier, probe_templates[i], NULL,
+                                                      (uint8_t)rank, &identified[0], &scores[0],
+                                                      NULL, &alignments[0]);
+            if (rc != PB_RC_OK) {
+                printf("pb_identifier_identify_template_rank probe %i fail, rc = %u\n", i, rc);
+                run_failed++;
+                fill(ranks.begin() + i * rank * RANK_COLUMNS,
+                     ranks.begin() + (i + 1) * rank * RANK_COLUMNS, -1);
+                continue;
+            }
+            for (int k = 0; k < rank; k++) {
+                int* out = &ranks[(i * rank + k) * RANK_COLUMNS];
+                out[0] = identified[k] != NULL ? (int)pb_finger_get_user_id(identified[k]) - 1 : -1;
+                out[1] = identified[k] != NULL ? scores[k] : -1;
+                if (alignments[k] != NULL) {
+                    out[2] = pb_alignment_get_dx(alignments[k]);
+                    out[3] = pb_alignment_get_dy(alignments[k]);
+                    out[4] = pb_alignment_get_rotation(alignments[k]);
+                } else {
+                    out[2] = out[3] = out[4] = -1;
+                }
+                pb_finger_delete(identified[k]);
+                pb_alignment_delete(alignments[k]);
+            }
+        }
+        double seconds =
+            chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        pb_identifier_delete(identifier);
+
+        double rate = seconds > 0 ? nbr_of_probes / seconds : 0;
+        if (nbr_of_threads == 1) {
+            base_rate = rate;
+        }
+        printf("threads = %i, gallery = %i, probes = %i, time = %.3f s, probes/s = %.1f, "
+               "comparisons/s = %.0f, speedup = %.2f, failed = %i\n",
+               nbr_of_threads, nbr_of_gallery, nbr_of_probes, seconds, rate,
+               rate * nbr_of_gallery, base_rate > 0 ? rate / base_rate : 0, run_failed);
+        nbr_of_failed += run_failed;
+        if (nbr_of_threads == max_threads) {
+            break;
+        }
+    }
+
+    if (completed && nbr_of_probes > 0) {
+        int2CSV("rank.csv", &ranks[0], rank * RANK_COLUMNS, nbr_of_probes);
+    }
+    pb_session_delete(session);
+    for (int i = 0; i < nbr_of_gallery; i++) {
+        pb_finger_delete(fingers[i]);
+    }
+    DeleteTemplates(gallery_templates);
+    DeleteTemplates(probe_templates);
+    return completed && nbr_of_failed == 0 ? 0 : -1;
+}
+
+// Manifest line: <person> <finger> <sample> <image path>, '#' starts a comment line
+static bool LoadManifest(MergeOpencv& mergeOpencv, const string& sManifest,
+                         vector<g5_eval_sample_t>& samples, int& w, int& h) {
+    ifstream manifest(sManifest.c_str());
+    if (!manifest) {
+        printf("Open manifest %s fail\n", sManifest.c_str());
+        return false;
+    }
+    string sLine;
+    while (getline(manifest, sLine)) {
+        if (!sLine.empty() && sLine[sLine.size() - 1] == '\r') {
+            sLine.erase(sLine.size() - 1);
+        }
+        if (sLine.empty() || sLine[0] == '#') {
+            continue;
+        }
+        istringstream fields(sLine);
+        g5_eval_sample_t sample = {0};
+        string sImg;
+        if (!(fields >> sample.person >> sample.finger >> sample.sample) ||
+            !getline(fields >> ws, sImg)) {
+            printf("Bad manifest line: %s\n", sLine.c_str());
+            return false;
+        }
+        sample.image = LoadImage(mergeOpencv, sImg, w, h);
+        if (sample.image == NULL) {
+            printf("Load image file %s fail\n", sImg.c_str());
+            return false;
+        }
+        samples.push_back(sample);
+    }
+    return !samples.empty();
+}
+
+static void PrintFrrAtFar(const g5_eval_result_t& result, int far_ratio) {
+    int threshold = 0;
+    int frr = g5_eval_frr_at_far_ratio(&result, far_ratio, &threshold);
+    printf("FAR 1/%i: FRR = %i.%02i%%, threshold = %i%s\n", far_ratio, frr / 100, frr % 100,
+           threshold, result.nbr_of_impostor < far_ratio ? " (too few impostors)" : "");
+}
+
+// PBexe -eval <manifest> [threads] [all]
+// Runs the genuine and impostor protocols of the manifest and reports FRR at fixed FARs.
+// Impostors compare the first sample of each finger unless "all" is given. The score
+// histograms are written to scores.txt in PerfEval format.
+static int RunEval(int argc, char** argv) {
+    int w = 200, h = 200;
+    int nbr_of_threads = argc > 3 ? atoi(argv[3]) : 1;
+    g5_eval_impostor_protocol_t impostor_protocol =
+        argc > 4 && string(argv[4]) == "all" ? G5_EVAL_IMPOSTOR_ALL
+                                             : G5_EVAL_IMPOSTOR_FIRST_SAMPLE;
+    MergeOpencv mergeOpencv;
+    vector<g5_eval_sample_t> samples;
+
+    bool loaded = LoadManifest(mergeOpencv, argv[2], samples, w, h);
+    g5_eval_pair_t* pairs = NULL;
+    int nbr_of_pairs = 0;
+    if (loaded && g5_eval_create_protocol(&samples[0], (int)samples.size(), impostor_protocol,
+                                          &pairs, &nbr_of_pairs) != 0) {
+        printf("g5_eval_create_protocol fail\n");
+        loaded = false;
+    }
+    if (!loaded || nbr_of_pairs == 0) {
+        for (size_t i = 0; i < samples.size(); i++) {
+            PLAT_FREE(samples[i].image);
+        }
+        g5_eval_free_protocol(pairs);
+        return -1;
+    }
+
+    // every image is extracted once and shared by all workers
+    g5_template_cache_t* cache = g5_template_cache_create(0, (int)samples.size());
+    g5_eval_result_t result = {0};
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    int ret = g5_eval_run(&samples[0], w, h, pairs, nbr_of_pairs, NULL, nbr_of_threads, cache,
+                          &result);
+    double seconds =
+        chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    g5_template_cache_destroy(cache);
+
+    if (ret != 0) {
+        printf("g5_eval_run fail, ret = %i\n", ret);
+    } else {
+        printf("samples = %i, genuine = %i, impostor = %i, errors = %i, threads = %i, "
+               "time = %.3f s, comparisons/s = %.1f\n",
+               (int)samples.size(), result.nbr_of_genuine, result.nbr_of_impostor,
+               result.nbr_of_errors, nbr_of_threads, seconds,
+               seconds > 0 ? nbr_of_pairs / seconds : 0);
+
+        const pb_far_t fars[] = {PB_FAR_10K, PB_FAR_50K, PB_FAR_100K, PB_FAR_1M};
+        for (size_t i = 0; i < sizeof(fars) / sizeof(fars[0]); i++) {
+            PrintFrrAtFar(result, g5_eval_far_ratio(fars[i]));
+        }
+        histogram2Scores("scores.txt", result.genuine_stats->score_histogram,
+                         result.impostor_stats->score_histogram,
+                         PB_COMPARISON_MODE_HISTOGRAM_LENGTH);
+    }
+
+    g5_eval_result_free(&result);
+    g5_eval_free_protocol(pairs);
+    for (size_t i = 0; i < samples.size(); i++) {
+        PLAT_FREE(samples[i].image);
+    }
+    return ret == 0 ? 0 : -1;
+}
+
+// sModels is "all" or a comma separated list of model names, e.g. MODEL_A51,MODEL_A71. The
+// settings are those of the model_config.c profiles.
+static bool GetSweepModels(const string& sModels, vector<g5_sweep_model_t>& models) {
+    g5_sweep_model_t model;
+    if (sModels == "all") {
+        for (int i = 0; i < g5_sweep_nbr_of_models(); i++) {
+            if (g5_sweep_model_by_index(i, &model) == 0) {
+                models.push_back(model);
+            }
+        }
+        return !models.empty();
+    }
+    istringstream names(sModels);
+    string sName;
+    while (getline(names, sName, ',')) {
+        if (sName.empty()) {
+            continue;
+        }
+        if (g5_sweep_model_by_name(sName.c_str(), &model) != 0) {
+            printf("Unknown model %s\n", sName.c_str());
+            return false;
+        }
+        models.push_back(model);
+    }
+    return !models.empty();
+}
+
+// PBexe -sweep <manifest> <models> [threads] [all]
+// Runs the -eval protocols of the manifest under the settings of every model in models (see
+// GetSweepModels) and prints one FRR table per model. The images are decoded and the pairs
+// built once. Models with the same sensor type, resolution and radius are evaluated together,
+// and all runs share one template cache.
+static int RunSweep(int argc, char** argv) {
+    int w = 200, h = 200;
+    int nbr_of_threads = argc > 4 ? atoi(argv[4]) : 1;
+    g5_eval_impostor_protocol_t impostor_protocol =
+        argc > 5 && string(argv[5]) == "all" ? G5_EVAL_IMPOSTOR_ALL
+                                             : G5_EVAL_IMPOSTOR_FIRST_SAMPLE;
+    MergeOpencv mergeOpencv;
+    vector<g5_eval_sample_t> samples;
+    vector<g5_sweep_model_t> models;
+
+    bool loaded = GetSweepModels(argv[3], models) &&
+                  LoadManifest(mergeOpencv, argv[2], samples, w, h);
+    g5_eval_pair_t* pairs = NULL;
+    int nbr_of_pairs = 0;
+    if (loaded && g5_eval_create_protocol(&samples[0], (int)samples.size(), impostor_protocol,
+                                          &pairs, &nbr_of_pairs) != 0) {
+        printf("g5_eval_create_protocol fail\n");
+        loaded = false;
+    }
+    if (!loaded || nbr_of_pairs == 0) {
+        for (size_t i = 0; i < samples.size(); i++) {
+            PLAT_FREE(samples[i].image);
+        }
+        g5_eval_free_protocol(pairs);
+        return -1;
+    }
+
+    // keyed by the extraction settings, so every group extracts each image once
+    g5_template_cache_t* cache = g5_template_cache_create(0, 0);
+    g5_sweep_result_t result = {0};
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    int ret = g5_sweep_run(&samples[0], w, h, pairs, nbr_of_pairs, &models[0],
+                           (int)models.size(), nbr_of_threads, cache, &result);
+    double seconds =
+        chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    g5_template_cache_stats_t cache_stats = {0};
+    g5_template_cache_get_stats(cache, &cache_stats);
+    g5_template_cache_destroy(cache);
+
+    if (ret != 0) {
+        printf("g5_sweep_run fail, ret = %i\n", ret);
+    } else {
+        printf("samples = %i, pairs = %i, models = %i, groups = %i, threads = %i, "
+               "time = %.3f s, extractions = %llu, cache hits = %llu\n",
+               (int)samples.size(), nbr_of_pairs, (int)models.size(), result.nbr_of_groups,
+               nbr_of_threads, seconds, cache_stats.misses, cache_stats.hits);
+
+        const pb_far_t fars[] = {PB_FAR_10K, PB_FAR_50K, PB_FAR_100K, PB_FAR_1M};
+        for (size_t m = 0; m < models.size(); m++) {
+            const g5_eval_result_t* model_result = g5_sweep_model_result(&result, (int)m);
+            int group = result.model_group[m];
+            printf("\n%s: sensor_type = %i, resolution = %i, radius = %i, group = %i "
+                   "(%.3f s)\n",
+                   models[m].name, models[m].algo_info.sensor_type,
+                   models[m].algo_info.resolution, models[m].algo_info.radius, group,
+                   result.group_time_us[group] / 1000000.0);
+            printf("genuine = %i, impostor = %i, errors = %i\n", model_result->nbr_of_genuine,
+                   model_result->nbr_of_impostor, model_result->nbr_of_errors);
+            for (size_t i = 0; i < sizeof(fars) / sizeof(fars[0]); i++) {
+                PrintFrrAtFar(*model_result, g5_eval_far_ratio(fars[i]));
+            }
+            if (models[m].far_ratio > 0) {
+                printf("model ");
+                PrintFrrAtFar(*model_result, models[m].far_ratio);
+            }
+        }
+    }
+
+    g5_sweep_result_free(&result);
+    g5_eval_free_protocol(pairs);
+    for (size_t i = 0; i < samples.size(); i++) {
+        PLAT_FREE(samples[i].image);
+    }
+    return ret == 0 ? 0 : -1;
+}
+
+static bool SampleBefore(const g5_eval_sample_t& a, const g5_eval_sample_t& b) {
+    if (a.person != b.person) {
+        return a.person < b.person;
+    }
+    if (a.finger != b.finger) {
+        return a.finger < b.finger;
+    }
+    return a.sample < b.sample;
+}
+
+static void PrintLatency(const char* name, vector<long>& latency_us) {
+    if (latency_us.empty()) {
+        return;
+    }
+    double total_us = 0;
+    for (size_t i = 0; i < latency_us.size(); i++) {
+        total_us += latency_us[i];
+    }
+    sort(latency_us.begin(), latency_us.end());
+    size_t n = latency_us.size();
+    printf("%s latency: mean = %.3f ms, p50 = %.3f ms, p99 = %.3f ms, max = %.3f ms\n", name,
+           total_us / n / 1000, latency_us[n / 2] / 1000.0, latency_us[(n * 99) / 100] / 1000.0,
+           latency_us[n - 1] / 1000.0);
+}
+
+// PBexe -enroll <manifest> <store_dir> [threads]
+// Enrolls every finger of the manifest (samples in sample order) as one user with
+// enroll_v2 and writes the multitemplates to <store_dir>/p<person>_f<finger>.g5t. Users are
+// enrolled in parallel, one G5 context per thread. Per user results are written to
+// enroll.csv: status, percentage, added, used, template size, latency us, store us.
+static int RunEnroll(int argc, char** argv) {
+    int w = 200, h = 200;
+    int nbr_of_threads = argc > 4 ? atoi(argv[4]) : 1;
+    MergeOpencv mergeOpencv;
+    vector<g5_eval_sample_t> samples;
+
+    if (!LoadManifest(mergeOpencv, argv[2], samples, w, h)) {
+        for (size_t i = 0; i < samples.size(); i++) {
+            PLAT_FREE(samples[i].image);
+        }
+        return -1;
+    }
+    sort(samples.begin(), samples.end(), SampleBefore);
+
+    vector<unsigned char*> images(samples.size());
+    vector<string> ids;
+    vector<g5_enroll_user_t> users;
+    for (size_t i = 0; i < samples.size(); i++) {
+        images[i] = samples[i].image;
+        if (i == 0 || samples[i].person != samples[i - 1].person ||
+            samples[i].finger != samples[i - 1].finger) {
+            ostringstream id;
+            id << "p" << samples[i].person << "_f" << samples[i].finger;
+            ids.push_back(id.str());
+            g5_enroll_user_t user = {0};
+            user.images = &images[i];
+            users.push_back(user);
+        }
+        users.back().nbr_of_images++;
+    }
+    for (size_t i = 0; i < users.size(); i++) {
+        users[i].id = ids[i].c_str();
+    }
+
+    g5_template_store_t* store = g5_template_store_open(argv[3]);
+    if (store == NULL) {
+        printf("g5_template_store_open %s fail\n", argv[3]);
+        for (size_t i = 0; i < samples.size(); i++) {
+            PLAT_FREE(samples[i].image);
+        }
+        return -1;
+    }
+
+    g5_enroll_result_t result = {0};
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    int ret = g5_enroll_run(&users[0], (int)users.size(), w, h, NULL, nbr_of_threads, store,
+                            &result);
+    double seconds =
+        chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+    if (ret != 0) {
+        printf("g5_enroll_run fail, ret = %i\n", ret);
+    } else {
+        printf("users = %i, images = %i, enrolled = %i, errors = %i, threads = %i, "
+               "time = %.3f s, users/s = %.1f\n",
+               result.nbr_of_users, (int)samples.size(), result.nbr_of_enrolled,
+               result.nbr_of_errors, nbr_of_threads, seconds,
+               seconds > 0 ? result.nbr_of_users / seconds : 0);
+
+        vector<long> image_latency, user_latency, store_latency;
+        vector<int> rows(result.nbr_of_users * 7);
+        for (int i = 0; i < result.nbr_of_users; i++) {
+            const g5_enroll_user_result_t* user = &result.users[i];
+            for (int j = 0; j < user->nbr_of_used; j++) {
+                image_latency.push_back(user->image_latency_us[j]);
+            }
+            if (user->status == 0) {
+                user_latency.push_back(user->latency_us);
+                store_latency.push_back(user->store_latency_us);
+            }
+            int* row = &rows[i * 7];
+            row[0] = user->status;
+            row[1] = user->percentage;
+            row[2] = user->nbr_of_added;
+            row[3] = user->nbr_of_used;
+            row[4] = user->template_size;
+            row[5] = (int)user->latency_us;
+            row[6] = (int)user->store_latency_us;
+        }
+        PrintLatency("image", image_latency);
+        PrintLatency("user", user_latency);
+        PrintLatency("store", store_latency);
+        for (int i = 0; i < result.nbr_of_workers; i++) {
+            printf("worker %i: users = %i\n", i, result.users_per_worker[i]);
+        }
+        int2CSV("enroll.csv", &rows[0], 7, result.nbr_of_users);
+    }
+
+    g5_enroll_result_free(&result);
+    g5_template_store_close(store);
+    for (size_t i = 0; i < samples.size(); i++) {
+        PLAT_FREE(samples[i].image);
+    }
+    return ret == 0 ? 0 : -1;
+}
+
+struct PackContext {
+    MergeOpencv* mergeOpencv;
+    image_archive_writer_t* writer;
+    int w;
+    int h;
+    int nbr_of_added;
+    int nbr_of_failed;
+};
+
+static void PackImage(const char* path, const char* name, void* ctx) {
+    PackContext* pack = (PackContext*)ctx;
+    string sImg = path;
+    size_t dot = sImg.rfind('.');
+    string sExt = dot == string::npos ? "" : sImg.substr(dot);
+    transform(sExt.begin(), sExt.end(), sExt.begin(), ::tolower);
+    if (sExt != ".png" && sExt != ".bin" && sExt != ".raw") {
+        return;
+    }
+    int w = pack->w, h = pack->h;
+    unsigned char* pimg = LoadImage(*pack->mergeOpencv, sImg, w, h);
+    if (pimg == NULL || image_archive_add(pack->writer, name, pimg, w, h) != 0) {
+        printf("Pack image file %s fail\n", path);
+        pack->nbr_of_failed++;
+    } else {
+        pack->nbr_of_added++;
+    }
+    PLAT_FREE(pimg);
+}
+
+// PBexe -pack <image_dir> <archive> [w h]
+// Packs every .png/.bin/.raw image below image_dir into one archive, named by the path
+// relative to image_dir. Raw images are w x h (default 200 x 200). The archive can be given
+// instead of an image list to -batch, -identify and -rank.
+static int RunPack(int argc, char** argv) {
+    MergeOpencv mergeOpencv;
+    PackContext pack = {0};
+    pack.mergeOpencv = &mergeOpencv;
+    pack.w = argc > 5 ? atoi(argv[4]) : 200;
+    pack.h = argc > 5 ? atoi(argv[5]) : 200;
+    pack.writer = image_archive_create(argv[3]);
+    if (pack.writer == NULL) {
+        printf("Create image archive %s fail\n", argv[3]);
+        return -1;
+    }
+
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    int ret = image_archive_walk_dir(argv[2], PackImage, &pack);
+    int nbr_of_images = image_archive_finish(pack.writer);
+    double seconds =
+        chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    if (ret != 0 || nbr_of_images < 0) {
+        printf("Pack %s into %s fail\n", argv[2], argv[3]);
+        return -1;
+    }
+    printf("images = %i, failed = %i, time = %.3f s\n", nbr_of_images, pack.nbr_of_failed,
+           seconds);
+    return pack.nbr_of_failed == 0 ? 0 : -1;
+}
+
+static void ReleasePixels(void* pixels) {
+    free(pixels);
+}
+
+// Memref counterpart of LoadImage. Png pixels stay in the decoded cv::Mat and raw pixels in
+// the buffer they were read into; both are released through the pb_image memref hook.
+static pb_image_t* LoadPbImage(MergeOpencv& mergeOpencv, const string& sImg, int w, int h) {
+    if (sImg.find(".png") != std::string::npos) {
+        return mergeOpencv.ReadPngImage(sImg);
+    }
+    unsigned char* pimg = read_8bit_bin_file(sImg.c_str(), w, h);
+    if (pimg == NULL) {
+        return NULL;
+    }
+    pb_image_t* image = pb_image_create_mre((uint16_t)h, (uint16_t)w, 500, 500, pimg,
+                                            PB_IMPRESSION_TYPE_UNKNOWN, 0, 1, ReleasePixels, pimg);
+    if (image == NULL) {
+        PLAT_FREE(pimg);
+    }
+    return image;
+}
+
+// PBexe -ingest <image_list> [w h]
+// Compares every image against the next one, loading both images for each comparison as the
+// pair mode does, first through LoadImage (malloc + copy per image), then as memref
+// pb_image_t objects passed to g5_matcher_compare_images. Prints the bytes copied and the
+// time per comparison for both paths. An image archive is copied out of the mapping in the
+// first pass and referenced in place in the second.
+static int RunIngest(int argc, char** argv) {
+    int w = argc > 4 ? atoi(argv[3]) : 200;
+    int h = argc > 4 ? atoi(argv[4]) : 200;
+    MergeOpencv mergeOpencv;
+    vector<string> paths;
+    image_archive_t* archive = NULL;
+
+    const string sList = argv[2];
+    const string sExt = IMAGE_ARCHIVE_EXT;
+    if (sList.size() > sExt.size() &&
+        sList.compare(sList.size() - sExt.size(), sExt.size(), sExt) == 0) {
+        archive = image_archive_open(sList.c_str());
+        if (archive == NULL) {
+            printf("Open image archive %s fail\n", sList.c_str());
+            return -1;
+        }
+        paths.resize(image_archive_count(archive));
+    } else {
+        ifstream list(sList.c_str());
+        string sImg;
+        while (getline(list, sImg)) {
+            if (!sImg.empty() && sImg[sImg.size() - 1] == '\r') {
+                sImg.erase(sImg.size() - 1);
+            }
+            if (!sImg.empty()) {
+                paths.push_back(sImg);
+            }
+        }
+    }
+    int nbr_of_pairs = (int)paths.size() - 1;
+    if (nbr_of_pairs <= 0) {
+        printf("Need at least 2 images in %s\n", sList.c_str());
+        image_archive_close(archive);
+        return -1;
+    }
+
+    g5_matcher_t* matcher = g5_matcher_create(NULL);
+    if (matcher == NULL) {
+        image_archive_close(archive);
+        return -1;
+    }
+    vector<int> scores(nbr_of_pairs);
+    vector<bool> compared(nbr_of_pairs, false);  // by the copy path
+    int nbr_of_errors = 0;
+    int nbr_of_compare_errors = 0;
+
+    // Copy path
+    unsigned long long copy_bytes = 0;
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < nbr_of_pairs; i++) {
+        unsigned char* pimg[2] = {NULL, NULL};
+        int pw[2] = {w, w}, ph[2] = {h, h};
+        for (int j = 0; j < 2; j++) {
+            if (archive != NULL) {
+                unsigned char* pixels = image_archive_pixels(archive, i + j, &pw[j], &ph[j]);
+                pimg[j] = (unsigned char*)plat_alloc(pw[j] * ph[j]);
+                if (pimg[j] != NULL) {
+                    memcpy(pimg[j], pixels, pw[j] * ph[j]);
+                }
+            } else {
+                pimg[j] = LoadImage(mergeOpencv, paths[i + j], pw[j], ph[j]);
+            }
+            // png: cv::Mat to buffer, raw: file to buffer, archive: mapping to buffer
+            copy_bytes += pimg[j] != NULL ? pw[j] * ph[j] : 0;
+        }
+        int score = 0, rot = 0, dx = 0, dy = 0;
+        if (pimg[0] == NULL || pimg[1] == NULL || pw[0] != pw[1] || ph[0] != ph[1]) {
+            nbr_of_errors++;
+        } else {
+            int status =
+                g5_matcher_compare(matcher, pimg[0], pimg[1], pw[0], ph[0], &score, &rot, &dx, &dy);
+            compared[i] = g5_matcher_compare_succeeded(status) != 0;
+            if (!compared[i]) {
+                nbr_of_compare_errors++;
+            }
+        }
+        scores[i] = score;
+        PLAT_FREE(pimg[0]);
+        PLAT_FREE(pimg[1]);
+    }
+    double copy_ms =
+        chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+
+    // Memref path
+    unsigned long long memref_bytes = 0;
+    int nbr_of_mismatches = 0;
+    start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < nbr_of_pairs; i++) {
+        pb_image_t* image[2] = {NULL, NULL};
+        for (int j = 0; j < 2; j++) {
+            if (archive != NULL) {
+                int pw = 0, ph = 0;
+                unsigned char* pixels = image_archive_pixels(archive, i + j, &pw, &ph);
+                image[j] = pb_image_create_mre((uint16_t)ph, (uint16_t)pw, 500, 500, pixels,
+                                               PB_IMPRESSION_TYPE_UNKNOWN, 0, 1, NULL, NULL);
+            } else {
+                image[j] = LoadPbImage(mergeOpencv, paths[i + j], w, h);
+                // raw files are still read into a buffer, png pixels stay in the cv::Mat
+                if (image[j] != NULL && paths[i + j].find(".png") == string::npos) {
+                    memref_bytes += pb_image_get_nbr_of_pixels(image[j]);
+                }
+            }
+        }
+        int score = 0, rot = 0, dx = 0, dy = 0;
+        int status = g5_matcher_compare_images(matcher, image[0], image[1], &score, &rot, &dx, &dy);
+        bool ok = g5_matcher_compare_succeeded(status) != 0;
+        if (!ok) {
+            nbr_of_compare_errors++;
+        }
+        // A pair both paths failed on has no score to compare
+        if (ok != compared[i] || (ok && score != scores[i])) {
+            nbr_of_mismatches++;
+        }
+        pb_image_delete(image[0]);
+        pb_image_delete(image[1]);
+    }
+    double memref_ms =
+        chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+
+    printf("comparisons = %i, load errors = %i, compare errors = %i, score mismatches = %i\n",
+           nbr_of_pairs, nbr_of_errors, nbr_of_compare_errors, nbr_of_mismatches);
+    printf("copy:   bytes copied per comparison = %.0f, time per comparison = %.3f ms\n",
+           (double)copy_bytes / nbr_of_pairs, copy_ms / nbr_of_pairs);
+    printf("memref: bytes copied per comparison = %.0f, time per comparison = %.3f ms\n",
+           (double)memref_bytes / nbr_of_pairs, memref_ms / nbr_of_pairs);
+
+    g5_matcher_destroy(matcher);
+    image_archive_close(archive);
+    return 0;
+}
+
+static bool LoadPair(const vector<pair<string, string> >& pairs, size_t index, int w, int h,
+                     PrefetchItem& item) {
+    MergeOpencv mergeOpencv;
+    item.w = w;
+    item.h = h;
+    int w1 = w, h1 = h;
+    item.images.push_back(LoadImage(mergeOpencv, pairs[index].first, item.w, item.h));
+    item.images.push_back(LoadImage(mergeOpencv, pairs[index].second, w1, h1));
+    return item.images[0] != NULL && item.images[1] != NULL && w1 == item.w && h1 == item.h;
+}
+
+// PBexe -stream <pair_list> [match_threads] [io_threads] [depth]
+// Compares the image pairs of pair_list (two paths per line) on match_threads matcher
+// threads fed by io_threads loader threads through a queue of at most depth pairs
+// (default 1 match thread, 2 io threads, depth 16). io_threads 0 loads each pair in the
+// matcher thread, without overlap, as a baseline. Prints pairs/s, the queue depth seen by
+// the matchers and the time matchers and loaders stalled on an empty or full queue.
+// Per pair score, rot, dx and dy are written to stream.csv.
+static int RunStream(int argc, char** argv) {
+    int w = 200, h = 200;
+    int nbr_of_match_threads = max(argc > 3 ? atoi(argv[3]) : 1, 1);
+    int nbr_of_io_threads = max(argc > 4 ? atoi(argv[4]) : 2, 0);
+    size_t depth = (size_t)max(argc > 5 ? atoi(argv[5]) : 16, 1);
+
+    vector<pair<string, string> > pairs;
+    ifstream list(argv[2]);
+    if (!list) {
+        printf("Open pair list %s fail\n", argv[2]);
+        return -1;
+    }
+    string sLine;
+    while (getline(list, sLine)) {
+        istringstream fields(sLine);
+        string sImg0, sImg1;
+        if (fields >> sImg0 >> sImg1) {
+            pairs.push_back(make_pair(sImg0, sImg1));
+        }
+    }
+    if (pairs.empty()) {
+        printf("No pairs in %s\n", argv[2]);
+        return -1;
+    }
+
+    size_t nbr_of_pairs = pairs.size();
+    vector<int> results(nbr_of_pairs * 4);
+    vector<int> errors(nbr_of_match_threads);
+    ImagePrefetcher* prefetcher = NULL;
+    if (nbr_of_io_threads > 0) {
+        prefetcher = new ImagePrefetcher(
+            [&](size_t index, PrefetchItem& item) {
+                return LoadPair(pairs, index, w, h, item);
+            },
+            nbr_of_pairs, nbr_of_io_threads, depth);
+    }
+
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    size_t next_pair = 0;
+    mutex next_mutex;
+    vector<thread> matchers;
+    for (int t = 0; t < nbr_of_match_threads; t++) {
+        matchers.push_back(thread([&, t]() {
+            g5_trace_set_thread_name("matcher", t);
+            g5_matcher_t* matcher = g5_matcher_create(NULL);
+            for (;;) {
+                PrefetchItem item;
+                if (prefetcher != NULL) {
+                    if (!prefetcher->Pop(item)) {
+                        break;
+                    }
+                } else {
+                    {
+                        lock_guard<mutex> lock(next_mutex);
+                        if (next_pair >= nbr_of_pairs) {
+                            break;
+                        }
+                        item.index = next_pair++;
+                    }
+                    G5_TRACE_SET_PAIR((int)item.index);
+                    G5_TRACE_BEGIN("load");
+                    item.ok = LoadPair(pairs, item.index, w, h, item);
+                    G5_TRACE_END("load");
+                }
+                int* result = &results[item.index * 4];
+                if (matcher == NULL || !item.ok) {
+                    errors[t]++;
+                } else {
+                    int score = 0, rot = 0, dx = 0, dy = 0;
+                    G5_TRACE_SET_PAIR((int)item.index);
+                    // A failed pair keeps zeros in stream.csv, like a pair that did not load
+                    int status = g5_matcher_compare(matcher, item.images[0], item.images[1],
+                                                    item.w, item.h, &score, &rot, &dx, &dy);
+                    if (g5_matcher_compare_succeeded(status)) {
+                        result[0] = score;
+                        result[1] = rot;
+                        result[2] = dx;
+                        result[3] = dy;
+                    } else {
+                        errors[t]++;
+                    }
+                }
+                ImagePrefetcher::FreeItem(item);
+            }
+            g5_matcher_destroy(matcher);
+        }));
+    }
+    for (size_t t = 0; t < matchers.size(); t++) {
+        matchers[t].join();
+    }
+    double seconds =
+        chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+    int nbr_of_errors = 0;
+    for (int t = 0; t < nbr_of_match_threads; t++) {
+        nbr_of_errors += errors[t];
+    }
+    printf("pairs = %i, errors = %i, match threads = %i, io threads = %i, time = %.3f s, "
+           "pairs/s = %.1f\n",
+           (int)nbr_of_pairs, nbr_of_errors, nbr_of_match_threads, nbr_of_io_threads, seconds,
+           seconds > 0 ? nbr_of_pairs / seconds : 0);
+    if (prefetcher != NULL) {
+        PrefetchStats stats = prefetcher->GetStats();
+        printf("depth = %i, mean queue depth = %.2f, max queue depth = %i, empty pops = %i, "
+               "matcher stall = %.1f ms, loader stall = %.1f ms, load = %.1f ms\n",
+               (int)stats.depth, stats.mean_depth, (int)stats.max_depth, (int)stats.empty_pops,
+               stats.consumer_stall_ms, stats.producer_stall_ms, stats.load_ms);
+        delete prefetcher;
+    }
+    int2CSV("stream.csv", &results[0], 4, (int)nbr_of_pairs);
+    return nbr_of_errors == 0 ? 0 : -1;
+}
+
+struct OverlayPair {
+    string image0;
+    string image1;
+    bool has_result;
+    int result[4];  // score, rot, dx, dy
+};
+
+// PBexe -overlay <results> [out_dir] [threads] [writers] [png|jpg] [level] [cols] [rows]
+// Renders the alignment overlay of every pair in results and tiles the overlays into
+// contact sheets of cols x rows (default 6 x 4), written as out_dir/overlay_0000.png, ...
+// Each results line is <image0> <image1> [score rot dx dy]; pairs without a result are
+// compared first. threads render in parallel (default 4) while writers encode and write the
+// sheets in the background (default 2) at level (PNG compression 0-9 or JPEG quality,
+// default -1 for the OpenCV default).
+static int RunOverlay(int argc, char** argv) {
+    int w = 200, h = 200;
+    string sOutDir = argc > 3 ? argv[3] : ".";
+    int nbr_of_threads = max(argc > 4 ? atoi(argv[4]) : 4, 1);
+    int nbr_of_writers = max(argc > 5 ? atoi(argv[5]) : 2, 1);
+    string sExt = string(".") + (argc > 6 ? argv[6] : "png");
+    int level = argc > 7 ? atoi(argv[7]) : -1;
+    int cols = max(argc > 8 ? atoi(argv[8]) : 6, 1);
+    int rows = max(argc > 9 ? atoi(argv[9]) : 4, 1);
+
+    vector<OverlayPair> pairs;
+    ifstream results(argv[2]);
+    if (!results) {
+        printf("Open results %s fail\n", argv[2]);
+        return -1;
+    }
+    string sLine;
+    while (getline(results, sLine)) {
+        istringstream fields(sLine);
+        OverlayPair item;
+        if (fields >> item.image0 >> item.image1) {
+            item.has_result = !!(fields >> item.result[0] >> item.result[1] >> item.result[2] >>
+                                 item.result[3]);
+            pairs.push_back(item);
+        }
+    }
+    if (pairs.empty()) {
+        printf("No pairs in %s\n", argv[2]);
+        return -1;
+    }
+
+    size_t nbr_of_pairs = pairs.size();
+    ImageWriter writer(nbr_of_writers, 2 * (size_t)nbr_of_writers, level);
+    ContactSheet sheet(writer, sOutDir + "/overlay", sExt, nbr_of_pairs, cols, rows, 256);
+    vector<int> errors(nbr_of_threads);
+    vector<double> render_ms(nbr_of_threads);
+
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    size_t next_pair = 0;
+    mutex next_mutex;
+    vector<thread> renderers;
+    for (int t = 0; t < nbr_of_threads; t++) {
+        renderers.push_back(thread([&, t]() {
+            MergeOpencv mergeOpencv;
+            g5_matcher_t* matcher = NULL;
+            for (;;) {
+                size_t index;
+                {
+                    lock_guard<mutex> lock(next_mutex);
+                    if (next_pair >= nbr_of_pairs) {
+                        break;
+                    }
+                    index = next_pair++;
+                }
+                OverlayPair& item = pairs[index];
+                int w0 = w, h0 = h, w1 = w, h1 = h;
+                unsigned char* pimg0 = LoadImage(mergeOpencv, item.image0, w0, h0);
+                unsigned char* pimg1 = LoadImage(mergeOpencv, item.image1, w1, h1);
+                cv::Mat overlay;
+                if (pimg0 == NULL || pimg1 == NULL || w0 != w1 || h0 != h1) {
+                    errors[t]++;
+                } else {
+                    if (!item.has_result) {
+                        if (matcher == NULL) {
+                            matcher = g5_matcher_create(NULL);
+                        }
+                        if (matcher != NULL) {
+                            int status = g5_matcher_compare(
+                                matcher, pimg0, pimg1, w0, h0, &item.result[0], &item.result[1],
+                                &item.result[2], &item.result[3]);
+                            item.has_result = g5_matcher_compare_succeeded(status) != 0;
+                        }
+                    }
+                    if (item.has_result) {
+                        chrono::high_resolution_clock::time_point render_start =
+                            chrono::high_resolution_clock::now();
+                        overlay = mergeOpencv.RenderOverlay(pimg0, pimg1, w0, h0, item.result[0],
+                                                            item.result[1], item.result[2],
+                                                            item.result[3]);
+                        render_ms[t] += chrono::duration<double, milli>(
+                                            chrono::high_resolution_clock::now() - render_start)
+                                            .count();
+                    } else {
+                        errors[t]++;
+                    }
+                }
+                PLAT_FREE(pimg0);
+                PLAT_FREE(pimg1);
+                // Failed pairs keep their cell so the sheet layout follows the results file
+                sheet.Add(index, overlay,
+                          item.has_result
+                              ? cv::format("%d: %d,%d,%d,%d", (int)index, item.result[0],
+                                           item.result[1], item.result[2], item.result[3])
+                              : cv::format("%d: error", (int)index));
+            }
+            g5_matcher_destroy(matcher);
+        }));
+    }
+    for (size_t t = 0; t < renderers.size(); t++) {
+        renderers[t].join();
+    }
+    double render_seconds =
+        chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    writer.Flush();
+    double seconds =
+        chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+    int nbr_of_errors = 0;
+    double total_render_ms = 0;
+    for (int t = 0; t < nbr_of_threads; t++) {
+        nbr_of_errors += errors[t];
+        total_render_ms += render_ms[t];
+    }
+    ImageWriterStats stats = writer.GetStats();
+    printf("pairs = %i, errors = %i, sheets = %i, threads = %i, writers = %i, level = %i\n",
+           (int)nbr_of_pairs, nbr_of_errors, (int)sheet.GetNbrOfSheets(), nbr_of_threads,
+           nbr_of_writers, level);
+    printf("render = %.3f s, total = %.3f s, overlays/s = %.1f, render per overlay = %.2f ms\n",
+           render_seconds, seconds, seconds > 0 ? nbr_of_pairs / seconds : 0,
+           total_render_ms / nbr_of_pairs);
+    printf("written = %i, write errors = %i, bytes = %llu, encode = %.1f ms, write = %.1f ms, "
+           "renderer stall = %.1f ms, max queue depth = %i\n",
+           (int)stats.images, (int)stats.errors, stats.bytes, stats.encode_ms, stats.write_ms,
+           stats.producer_stall_ms, (int)stats.max_depth);
+    return stats.errors == 0 ? 0 : -1;
+}
+
+struct PoolBenchJob {
+    unsigned char** images;
+    int nbr_of_images;
+    int w;
+    int h;
+    int* scores;  // nbr_of_images x nbr_of_images, i < j only
+};
+
+// A failed compare leaves G5_BATCH_NOT_COMPUTED, as g5_batch_compare() does
+static void ComparePoolBenchPair(g5_matcher_t* matcher, const PoolBenchJob& job, int i, int j) {
+    int score = 0, rot = 0, dx = 0, dy = 0;
+    G5_TRACE_SET_PAIR(i * job.nbr_of_images + j);
+    int status = g5_matcher_compare(matcher, job.images[i], job.images[j], job.w, job.h, &score,
+                                    &rot, &dx, &dy);
+    job.scores[i * job.nbr_of_images + j] =
+        g5_matcher_compare_succeeded(status) ? score : G5_BATCH_NOT_COMPUTED;
+}
+
+static void CompareAllVsAllRow(g5_matcher_t* matcher, const PoolBenchJob& job, int i) {
+    for (int j = i + 1; j < job.nbr_of_images; j++) {
+        ComparePoolBenchPair(matcher, job, i, j);
+    }
+}
+
+static void* PoolBenchWorkerInit(void* ctx, int worker) {
+    (void)ctx;
+    (void)worker;
+    return g5_matcher_create(NULL);
+}
+
+static void PoolBenchWorkerExit(void* ctx, int worker, void* data) {
+    (void)ctx;
+    (void)worker;
+    g5_matcher_destroy((g5_matcher_t*)data);
+}
+
+static void PoolBenchRows(void* arg, int begin, int end) {
+    const PoolBenchJob& job = *(const PoolBenchJob*)arg;
+    // the matcher the worker created in PoolBenchWorkerInit
+    g5_matcher_t* matcher = (g5_matcher_t*)g5_pool_worker_data();
+    if (matcher == NULL) {
+        return;
+    }
+    for (int i = begin; i < end; i++) {
+        CompareAllVsAllRow(matcher, job, i);
+    }
+}
+
+static void PrintPoolBenchRun(const char* name, int nbr_of_pairs, double seconds,
+                              const vector<double>& busy_ms) {
+    double total_ms = 0, max_ms = 0;
+    for (size_t t = 0; t < busy_ms.size(); t++) {
+        total_ms += busy_ms[t];
+        max_ms = max(max_ms, busy_ms[t]);
+    }
+    double mean_ms = busy_ms.empty() ? 0 : total_ms / busy_ms.size();
+    printf("%-12s time = %.3f s, pairs/s = %.1f, busy mean = %.1f ms, busy max = %.1f ms, "
+           "imbalance = %.2f\n",
+           name, seconds, seconds > 0 ? nbr_of_pairs / seconds : 0, mean_ms, max_ms,
+           mean_ms > 0 ? max_ms / mean_ms : 0);
+}
+
+// PBexe -poolbench <image_list> [threads]
+// Compares all images against each other (i < j) three times on threads threads (default 4):
+// statically split by rows, statically split into equal pair counts, and on a g5_pool
+// work-stealing pool with one row per task. Row i holds n - 1 - i pairs and comparison costs
+// vary per image, so the static splits leave threads idle. Prints the time, the busy time per
+// thread and the max / mean imbalance of each run, and checks that the scores agree.
+static int RunPoolBench(int argc, char** argv) {
+    int w = 200, h = 200;
+    int nbr_of_threads = max(argc > 3 ? atoi(argv[3]) : 4, 1);
+    MergeOpencv mergeOpencv;
+    vector<unsigned char*> images;
+    image_archive_t* archive = NULL;
+
+    if (!LoadImageList(mergeOpencv, argv[2], images, w, h, archive)) {
+        FreeImageList(images, archive);
+        return -1;
+    }
+    int n = (int)images.size();
+    vector<pair<int, int> > pairs;
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            pairs.push_back(make_pair(i, j));
+        }
+    }
+    int nbr_of_pairs = (int)pairs.size();
+    printf("images = %i, pairs = %i, threads = %i\n", n, nbr_of_pairs, nbr_of_threads);
+
+    // 0: static rows, 1: static pairs, 2: pool
+    vector<int> scores[3];
+    for (int run = 0; run < 3; run++) {
+        scores[run].assign((size_t)n * n, 0);
+        PoolBenchJob job = {&images[0], n, w, h, &scores[run][0]};
+        vector<double> busy_ms(nbr_of_threads);
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        if (run < 2) {
+            vector<thread> workers;
+            for (int t = 0; t < nbr_of_threads; t++) {
+                workers.push_back(thread([&, t]() {
+                    g5_trace_set_thread_name(run == 0 ? "row worker" : "pair worker", t);
+                    g5_matcher_t* matcher = g5_matcher_create(NULL);
+                    if (matcher == NULL) {
+                        return;
+                    }
+                    chrono::high_resolution_clock::time_point busy_start =
+                        chrono::high_resolution_clock::now();
+                    if (run == 0) {
+                        for (int i = t * n / nbr_of_threads; i < (t + 1) * n / nbr_of_threads;
+                             i++) {
+                            CompareAllVsAllRow(matcher, job, i);
+                        }
+                    } else {
+                        int begin = (int)((long long)t * nbr_of_pairs / nbr_of_threads);
+                        int end = (int)((long long)(t + 1) * nbr_of_pairs / nbr_of_threads);
+                        for (int k = begin; k < end; k++) {
+                            ComparePoolBenchPair(matcher, job, pairs[k].first, pairs[k].second);
+                        }
+                    }
+                    busy_ms[t] = chrono::duration<double, milli>(
+                                     chrono::high_resolution_clock::now() - busy_start)
+                                     .count();
+                    g5_matcher_destroy(matcher);
+                }));
+            }
+            for (size_t t = 0; t < workers.size(); t++) {
+                workers[t].join();
+            }
+        } else {
+            g5_pool_t* pool =
+                g5_pool_create(nbr_of_threads, PoolBenchWorkerInit, PoolBenchWorkerExit, NULL);
+            if (pool == NULL) {
+                printf("g5_pool_create fail\n");
+                FreeImageList(images, archive);
+                return -1;
+            }
+            g5_pool_parallel_for(pool, 0, n, 1, PoolBenchRows, &job);
+            unsigned long long tasks = 0, steals = 0;
+            for (int t = 0; t < nbr_of_threads; t++) {
+                g5_pool_worker_stats_t stats;
+                g5_pool_get_worker_stats(pool, t, &stats);
+                busy_ms[t] = stats.busy_us / 1000.0;
+                tasks += stats.tasks;
+                steals += stats.steals;
+            }
+            g5_pool_destroy(pool);
+            printf("pool tasks = %llu, steals = %llu\n", tasks, steals);
+        }
+        double seconds =
+            chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        const char* names[3] = {"static rows", "static pairs", "pool"};
+        PrintPoolBenchRun(names[run], nbr_of_pairs, seconds, busy_ms);
+    }
+
+    int nbr_of_mismatches = 0;
+    for (int run = 1; run < 3; run++) {
+        if (scores[run] != scores[0]) {
+            nbr_of_mismatches++;
+        }
+    }
+    int nbr_of_failed = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            nbr_of_failed += scores[0][i * n + j] == G5_BATCH_NOT_COMPUTED;
+        }
+    }
+    printf("runs with different scores = %i, failed pairs = %i\n", nbr_of_mismatches,
+           nbr_of_failed);
+    FreeImageList(images, archive);
+    return nbr_of_mismatches == 0 && nbr_of_failed == 0 ? 0 : -1;
+}
+
+// read_bin_file() + normalize_int2UINT8() as they were before raw16: byte by byte swap
+// into an int per pixel, then the normalization over the int buffer.
+static void LegacyRaw16ToU8(const unsigned short* raw, int* tmp, unsigned char* out, int n) {
+    unsigned char SWAP[2];
+    for (int i = 0; i < n; i++) {
+        SWAP[0] = (raw[i] & 0xFF00) >> 8;
+        SWAP[1] = raw[i] & 0x00FF;
+        tmp[i] = ((SWAP[1] << 8) + SWAP[0]);
+    }
+    normalize_int2UINT8(tmp, out, n);
+}
+
+static int RunRaw16Bench(int argc, char** argv) {
+    int iterations = argc > 2 ? atoi(argv[2]) : 1000;
+    if (iterations <= 0) {
+        iterations = 1000;
+    }
+    // Sensor frame sizes, from the small swipe and area sensors to full frames
+    const int sizes[][2] = {{134, 188}, {176, 176}, {200, 200}, {240, 320}, {400, 400}};
+    const raw16_isa_t isas[] = {RAW16_ISA_SCALAR, RAW16_ISA_SSE2, RAW16_ISA_AVX2};
+    const char* isa_names[] = {"scalar", "sse2", "avx2"};
+    int nbr_of_mismatches = 0;
+
+    printf("size     legacy ns/px");
+    for (int k = 0; k < 3; k++) {
+        printf("  %6s ns/px", isa_names[k]);
+    }
+    printf("\n");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int w = sizes[s][0], h = sizes[s][1], n = w * h;
+        // Big endian 12-bit sensor data
+        vector<unsigned short> raw(n);
+        srand(1);
+        for (int i = 0; i < n; i++) {
+            unsigned short v = (unsigned short)(256 + rand() % 3840);
+            raw[i] = (unsigned short)((v << 8) | (v >> 8));
+        }
+        vector<int> tmp(n);
+        vector<unsigned char> expected(n);
+        vector<unsigned short> work(n);
+
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            LegacyRaw16ToU8(&raw[0], &tmp[0], &expected[0], n);
+        }
+        double legacy_ns = chrono::duration<double, nano>(
+                               chrono::high_resolution_clock::now() - start).count() /
+                           ((double)iterations * n);
+        printf("%3ix%-3i  %12.3f", w, h, legacy_ns);
+
+        for (int k = 0; k < 3; k++) {
+            if (raw16_set_isa(isas[k]) != isas[k]) {
+                printf("  %12s", "n/a");
+                continue;
+            }
+            // The copy stands in for the fread into the frame buffer
+            start = chrono::high_resolution_clock::now();
+            for (int it = 0; it < iterations; it++) {
+                memcpy(&work[0], &raw[0], n * sizeof(unsigned short));
+                raw16_swap_bytes(&work[0], n);
+                raw16_to_u8(&work[0], (unsigned char*)&work[0], n);
+            }
+            double ns = chrono::duration<double, nano>(
+                            chrono::high_resolution_clock::now() - start).count() /
+                        ((double)iterations * n);
+            if (memcmp(&work[0], &expected[0], n) != 0) {
+                nbr_of_mismatches++;
+            }
+            printf("  %12.3f", ns);
+        }
+        printf("\n");
+    }
+    raw16_set_isa(RAW16_ISA_AUTO);
+    printf("iterations = %i, output mismatches = %i\n", iterations, nbr_of_mismatches);
+    return nbr_of_mismatches == 0 ? 0 : -1;
+}
+
+// PBexe -tracebench [iterations]
+// Times one begin/end span of g5_trace and g5_latency with recording off and on,
+// against an empty loop, and prints ns per span. The trace of the on run is written
+// to tracebench.json.
+static int RunTraceBench(int argc, char** argv) {
+    int iterations = argc > 2 ? atoi(argv[2]) : 100000;
+    if (iterations <= 0) {
+        iterations = 100000;
+    }
+    volatile int sink = 0;
+    chrono::high_resolution_clock::time_point start;
+
+    start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = i;
+    }
+    double empty_ns =
+        chrono::duration<double, nano>(chrono::high_resolution_clock::now() - start).count() /
+        iterations;
+
+    start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = i;
+        G5_TRACE_SET_PAIR(i);
+        G5_TRACE_BEGIN("bench");
+        G5_TRACE_END("bench");
+    }
+    double trace_off_ns =
+        chrono::duration<double, nano>(chrono::high_resolution_clock::now() - start).count() /
+        iterations;
+
+    start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = i;
+        g5_latency_end(G5_STAGE_COMPARE, g5_latency_begin());
+    }
+    double latency_off_ns =
+        chrono::duration<double, nano>(chrono::high_resolution_clock::now() - start).count() /
+        iterations;
+
+    // Room for every event, so the on run measures recording and not dropping
+    if (g5_trace_start(2 * iterations + 2) != 0) {
+        printf("Tracing is already on\n");
+        return -1;
+    }
+    start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = i;
+        G5_TRACE_SET_PAIR(i);
+        G5_TRACE_BEGIN("bench");
+        G5_TRACE_END("bench");
+    }
+    double trace_on_ns =
+        chrono::duration<double, nano>(chrono::high_resolution_clock::now() - start).count() /
+        iterations;
+    g5_trace_stop("tracebench.json");
+
+    g5_latency_reset();
+    g5_latency_enable(1);
+    start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = i;
+        g5_latency_end(G5_STAGE_COMPARE, g5_latency_begin());
+    }
+    double latency_on_ns =
+        chrono::duration<double, nano>(chrono::high_resolution_clock::now() - start).count() /
+        iterations;
+    g5_latency_enable(0);
+    g5_latency_reset();
+
+    printf("iterations = %i, empty loop = %.2f ns\n", iterations, empty_ns);
+    printf("trace off = %.2f ns/span, trace on = %.2f ns/span\n", trace_off_ns - empty_ns,
+           trace_on_ns - empty_ns);
+    printf("latency off = %.2f ns/span, latency on = %.2f ns/span\n", latency_off_ns - empty_ns,
+           latency_on_ns - empty_ns);
+    (void)sink;
+    return 0;
+}
+
+static void PrintArenaStats(const char* name, const g5_arena_stats_t& stats, int nbr_of_pairs,
+                            double seconds) {
+    unsigned long long calls = stats.arena_allocs + stats.heap_allocs + stats.frees;
+    printf("%-6s arena allocs = %llu, heap allocs = %llu, frees = %llu, peak = %.1f KB, "
+           "arena peak = %.1f KB\n",
+           name, stats.arena_allocs, stats.heap_allocs, stats.frees, stats.peak_bytes / 1024.0,
+           stats.arena_peak_bytes / 1024.0);
+    printf("%-6s allocator = %.2f ms (%.1f ns per call), resets = %llu, retired = %llu, "
+           "promoted = %llu, compare = %.3f ms per pair\n",
+           name, stats.alloc_ns / 1e6, calls > 0 ? (double)stats.alloc_ns / calls : 0,
+           stats.resets, stats.retired, stats.promoted,
+           nbr_of_pairs > 0 ? seconds * 1000 / nbr_of_pairs : 0);
+}
+
+// PBexe -arenabench <image_list> [pairs]
+// Compares each image with the next one (default all n - 1 pairs) on one matcher, first
+// with pb_malloc on the heap and then on the g5_arena, and prints the allocation counts,
+// peak bytes and time spent in pb_malloc / pb_free of both runs. The scores must agree.
+static int RunArenaBench(int argc, char** argv) {
+    int w = 200, h = 200;
+    MergeOpencv mergeOpencv;
+    vector<unsigned char*> images;
+    image_archive_t* archive = NULL;
+
+    if (!LoadImageList(mergeOpencv, argv[2], images, w, h, archive) || images.size() < 2) {
+        printf("Need at least two images in %s\n", argv[2]);
+        FreeImageList(images, archive);
+        return -1;
+    }
+    int nbr_of_pairs = (int)images.size() - 1;
+    if (argc > 3 && atoi(argv[3]) > 0 && atoi(argv[3]) < nbr_of_pairs) {
+        nbr_of_pairs = atoi(argv[3]);
+    }
+    g5_matcher_t* matcher = g5_matcher_create(NULL);
+    if (matcher == NULL) {
+        FreeImageList(images, archive);
+        return -1;
+    }
+
+    vector<int> scores[2];
+    int nbr_of_failed[2] = {0, 0};
+    const char* names[2] = {"heap", "arena"};
+    for (int run = 0; run < 2; run++) {
+        scores[run].assign(nbr_of_pairs, 0);
+        g5_arena_configure(run == 1, 1);
+        g5_arena_reset_stats();
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < nbr_of_pairs; i++) {
+            int rot = 0, dx = 0, dy = 0;
+            int status = g5_matcher_compare(matcher, images[i], images[i + 1], w, h,
+                                            &scores[run][i], &rot, &dx, &dy);
+            if (!g5_matcher_compare_succeeded(status)) {
+                scores[run][i] = G5_BATCH_NOT_COMPUTED;
+                nbr_of_failed[run]++;
+            }
+        }
+        double seconds =
+            chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        g5_arena_stats_t stats;
+        g5_arena_get_stats(&stats);
+        PrintArenaStats(names[run], stats, nbr_of_pairs, seconds);
+    }
+    g5_arena_configure(0, 0);
+    g5_matcher_destroy(matcher);
+
+    int nbr_of_mismatches = 0;
+    for (int i = 0; i < nbr_of_pairs; i++) {
+        if (scores[0][i] != scores[1][i]) {
+            nbr_of_mismatches++;
+        }
+    }
+    printf("pairs = %i, failed = %i / %i, score mismatches = %i\n", nbr_of_pairs,
+           nbr_of_failed[0], nbr_of_failed[1], nbr_of_mismatches);
+    FreeImageList(images, archive);
+    return nbr_of_mismatches == 0 && nbr_of_failed[0] == 0 ? 0 : -1;
+}
+
+// Saves the decision data the last matcher of the default sensor type handed back to
+// store, unless it is the one loaded from it. A mode that creates no matcher leaves
+// none, then the default matcher is opened and closed once to get it. Releases *loaded,
+// the file may be mapped and cannot be replaced meanwhile.
+static bool SaveDecisionData(g5_decision_store_t* store, g5_decision_data_t** loaded) {
+    int sensor_type = g5_matcher_get_default_sensor_type();
+    unsigned char* data = NULL;
+    int len = 0;
+    g5_matcher_get_decision_data(&data, &len);
+    if (data == NULL && g5_matcher_open(NULL) == 0) {
+        g5_matcher_close();
+        g5_matcher_get_decision_data(&data, &len);
+    }
+    vector<unsigned char> copy;
+    if (data != NULL && len > 0) {
+        copy.assign(data, data + len);
+    }
+    // data may point into the mapping released here
+    g5_matcher_set_decision_data(NULL, 0);
+    int loaded_len = 0;
+    unsigned char* loaded_data = g5_decision_data_bytes(*loaded, &loaded_len);
+    bool unchanged = *loaded != NULL && loaded_len == (int)copy.size() &&
+                     memcmp(loaded_data, &copy[0], copy.size()) == 0;
+    g5_decision_data_release(*loaded);
+    *loaded = NULL;
+    if (copy.empty()) {
+        printf("No decision data to save\n");
+        return false;
+    }
+    if (unchanged) {
+        printf("decision data unchanged, %i bytes\n", (int)copy.size());
+        return true;
+    }
+    int ret = g5_decision_store_put(store, sensor_type, &copy[0], (int)copy.size());
+    if (ret != 0) {
+        printf("g5_decision_store_put fail, ret = %i\n", ret);
+        return false;
+    }
+    printf("decision data saved, %i bytes\n", (int)copy.size());
+    return true;
+}
+
+// PBexe -statebench <dir> <image0> <image1> [runs]
+// Stores the decision data of a cold start in dir, then measures the startup of the
+// default matcher and its first comparisons of image0 and image1 cold, warm from the
+// decision data read from dir and warm from the decision data mapped from dir, in turn
+// for each run (default 5), and prints the mean load, init and comparison times.
+static int RunStateBench(int argc, char** argv) {
+    int runs = argc > 5 && atoi(argv[5]) > 0 ? atoi(argv[5]) : 5;
+    int w = 200, h = 200;
+    MergeOpencv mergeOpencv;
+
+    unsigned char* pimg0 = LoadImage(mergeOpencv, argv[3], w, h);
+    unsigned char* pimg1 = pimg0 != NULL ? LoadImage(mergeOpencv, argv[4], w, h) : NULL;
+    if (pimg1 == NULL) {
+        printf("Load image fail\n");
+        PLAT_FREE(pimg0);
+        return -1;
+    }
+    g5_decision_store_t* store = g5_decision_store_open(argv[2]);
+    if (store == NULL) {
+        printf("g5_decision_store_open %s fail\n", argv[2]);
+        PLAT_FREE(pimg0);
+        PLAT_FREE(pimg1);
+        return -1;
+    }
+    int sensor_type = g5_matcher_get_default_sensor_type();
+
+    g5_matcher_set_decision_data(NULL, 0);
+    g5_decision_data_t* loaded = NULL;
+    if (!SaveDecisionData(store, &loaded)) {
+        g5_decision_store_close(store);
+        PLAT_FREE(pimg0);
+        PLAT_FREE(pimg1);
+        return -1;
+    }
+
+    const char* names[3] = {"cold", "read", "mmap"};
+    double totals[3][4] = {{0}};  // load, init, first and second comparison in ms
+    int scores[3] = {0};
+    int ret = 0;
+    for (int run = 0; run < runs && ret == 0; run++) {
+        for (int state = 0; state < 3 && ret == 0; state++) {
+            double ms[4];
+            chrono::high_resolution_clock::time_point start =
+                chrono::high_resolution_clock::now();
+            if (state > 0) {
+                ret = g5_decision_store_get(store, sensor_type, state == 2, &loaded);
+                if (ret != 0) {
+                    printf("g5_decision_store_get fail, ret = %i\n", ret);
+                    break;
+                }
+                int len = 0;
+                unsigned char* data = g5_decision_data_bytes(loaded, &len);
+                g5_matcher_set_decision_data(data, len);
+            }
+            ms[0] = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start)
+                        .count();
+            start = chrono::high_resolution_clock::now();
+            ret = g5_matcher_open(NULL);
+            ms[1] = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start)
+                        .count();
+            int status = 0;  // FP_OK until the first compare
+            for (int i = 2; i < 4 && ret == 0 && g5_matcher_compare_succeeded(status); i++) {
+                int rot = 0, dx = 0, dy = 0;
+                start = chrono::high_resolution_clock::now();
+                status = images_compare_(&pimg0, &pimg1, w, h, &scores[state], &rot, &dx, &dy);
+                ms[i] = chrono::duration<double, milli>(chrono::high_resolution_clock::now() -
+                                                        start).count();
+            }
+            g5_matcher_close();
+            // Every start is from the stored state, not from what the last one handed back
+            g5_matcher_set_decision_data(NULL, 0);
+            g5_decision_data_release(loaded);
+            loaded = NULL;
+            if (ret != 0) {
+                printf("g5_matcher_open fail, ret = %i\n", ret);
+                break;
+            }
+            if (!g5_matcher_compare_succeeded(status)) {
+                printf("images_compare_ fail, ret = %i\n", status);
+                ret = status;
+                break;
+            }
+            for (int i = 0; i < 4; i++) {
+                totals[state][i] += ms[i];
+            }
+        }
+    }
+    if (ret == 0) {
+        printf("%-6s %10s %10s %14s %14s %8s\n", "state", "load ms", "init ms",
+               "1st compare ms", "2nd compare ms", "score");
+        for (int state = 0; state < 3; state++) {
+            printf("%-6s %10.3f %10.3f %14.3f %14.3f %8i\n", names[state],
+                   totals[state][0] / runs, totals[state][1] / runs, totals[state][2] / runs,
+                   totals[state][3] / runs, scores[state]);
+        }
+    }
+    g5_decision_store_close(store);
+    PLAT_FREE(pimg0);
+    PLAT_FREE(pimg1);
+    return ret;
+}
+
+static int RunMode(int argc, char** argv) {
+    if (argc >= 3 && string(argv[1]) == "-batch") {
+        return RunBatch(argc, argv);
+    } else if (argc >= 4 && string(argv[1]) == "-identify") {
+        return RunIdentify(argc, argv);
+    } else if (argc >= 4 && string(argv[1]) == "-rank") {
+        return RunRank(argc, argv);
+    } else if (argc >= 3 && string(argv[1]) == "-eval") {
+        return RunEval(argc, argv);
+    } else if (argc >= 4 && string(argv[1]) == "-sweep") {
+        return RunSweep(argc, argv);
+    } else if (argc >= 4 && string(argv[1]) == "-enroll") {
+        return RunEnroll(argc, argv);
+    } else if (argc >= 4 && string(argv[1]) == "-pack") {
+        return RunPack(argc, argv);
+    } else if (argc >= 3 && string(argv[1]) == "-ingest") {
+        return RunIngest(argc, argv);
+    } else if (argc >= 3 && string(argv[1]) == "-stream") {
+        return RunStream(argc, argv);
+    } else if (argc >= 3 && string(argv[1]) == "-overlay") {
+        return RunOverlay(argc, argv);
+    } else if (argc >= 3 && string(argv[1]) == "-poolbench") {
+        return RunPoolBench(argc, argv);
+    } else if (argc >= 2 && argc <= 3 && string(argv[1]) == "-raw16bench") {
+        return RunRaw16Bench(argc, argv);
+    } else if (argc >= 2 && argc <= 3 && string(argv[1]) == "-tracebench") {
+        return RunTraceBench(argc, argv);
+    } else if (argc >= 3 && argc <= 4 && string(argv[1]) == "-arenabench") {
+        return RunArenaBench(argc, argv);
+    } else if (argc >= 5 && argc <= 6 && string(argv[1]) == "-statebench") {
+        return RunStateBench(argc, argv);
+    } else if (argc >= 3 && argc <= 5) {
         string sImg0 = *(argv + 1);
         string sImg1 = *(argv + 2);
         string sShow = "";
-        if (argc == 4) {
-            sShow = *(argv + 3);
+        // pimg0 before and after the comparison, only on request
+        dump_format_t dump = DUMP_NONE;
+        for (int i = 3; i < argc; i++) {
+            string sOpt = *(argv + i);
+            if (sOpt == "-csv") {
+                dump = DUMP_CSV;
+            } else if (sOpt == "-bin") {
+                dump = DUMP_BIN;
+            } else {
+                sShow = sOpt;
+            }
         }
 
         printf("image0 = %s\n", sImg0.c_str());
@@ -44,51 +1920,34 @@ int main(int argc, char** argv) {
         unsigned char* pimg1 = NULL;
         MergeOpencv mergeOpencv;
 
-        if (sImg0.find(".png") != std::string::npos) {
-            pimg0 = (unsigned char*)plat_alloc(w * h * sizeof(unsigned char));
-            if (pimg0 == NULL) {
-                printf("pimg0 == NULL\n");
-                return -1;
-            }
-            if (!mergeOpencv.ReadPng(sImg0, pimg0, w, h)) {
-                printf("ReadPng image0 file fail\n");
-                return -1;
-            };
-        } else {
-           pimg0 = read_8bit_bin_file(sImg0.c_str(), w, h);
-            if (pimg0 == NULL) {
-                printf("Load image0 file fail\n");
-                return -1;
-            }
+        pimg0 = LoadImage(mergeOpencv, sImg0, w, h);
+        if (pimg0 == NULL) {
+            printf("Load image0 file fail\n");
+            return -1;
+        }
+        pimg1 = LoadImage(mergeOpencv, sImg1, w, h);
+        if (pimg1 == NULL) {
+            printf("Load image1 file fail\n");
+            PLAT_FREE(pimg0);
+            return -1;
         }
 
-		if (sImg1.find(".png") != std::string::npos) {
-			pimg1 = (unsigned char*)plat_alloc(w * h * sizeof(unsigned char));
-			if (pimg1 == NULL) {
-				printf("pimg1 == NULL\n");
-				return -1;
-			}
-			if (!mergeOpencv.ReadPng(sImg1, pimg1, w, h)) {
-				printf("ReadPng image1 file fail\n");
-				return -1;
-			};
-		}
-		else {
-			pimg1 = read_8bit_bin_file(sImg1.c_str(), w, h);
-			if (pimg1 == NULL) {
-				printf("Load image1 file fail\n");
-				return -1;
-			}
-		}
-
-        U82CSV("pimg0.csv", pimg0, w, h);
+        dump_u8(dump, "pimg0", pimg0, w, h);
 
         int match_score = 0, rot = 0, dx = 0, dy = 0;
-        images_compare_(&pimg0, &pimg1, w, h, &match_score, &rot, &dx, &dy);
+        g5_matcher_open(NULL);
+        int status = images_compare_(&pimg0, &pimg1, w, h, &match_score, &rot, &dx, &dy);
+        g5_matcher_close();
+        if (!g5_matcher_compare_succeeded(status)) {
+            printf("images_compare_ fail, ret = %i\n", status);
+            PLAT_FREE(pimg0);
+            PLAT_FREE(pimg1);
+            return -1;
+        }
         printf("w = %i, h = %i, match_score = %i, rot = %i, dx = %i, dy = %i\n", w, h, match_score,
                rot, dx, dy);
 
-        U82CSV("pimg0_.csv", pimg0, w, h);
+        dump_u8(dump, "pimg0_", pimg0, w, h);
 
         if (sShow == "s" || sShow == "-s" || sShow == "S" || sShow == "-S") {
             mergeOpencv.Merge(pimg0, pimg1, w, h, match_score, rot, dx, dy);
@@ -101,3 +1960,171 @@ int main(int argc, char** argv) {
     }
     return 0;
 }
+
+static void PrintMemReport(const g5_mem_report_t& report) {
+    printf("mem threads = %i, allocs = %llu, frees = %llu, live = %.1f KB, "
+           "max thread peak = %.1f KB, sum of thread peaks = %.1f KB\n",
+           report.threads, report.allocs, report.frees, report.live_bytes / 1024.0,
+           report.max_thread_peak / 1024.0, report.sum_thread_peaks / 1024.0);
+    if (report.untracked > 0) {
+        printf("mem untracked allocs = %llu (more than %i threads)\n", report.untracked,
+               G5_MEM_MAX_THREADS);
+    }
+    printf("%-20s %10s %10s %12s %12s\n", "stage", "allocs", "frees", "MB", "peak live KB");
+    for (int i = 0; i < G5_MEM_NBR_OF_STAGES; i++) {
+        const g5_mem_stage_stats_t& stage = report.stages[i];
+        if (stage.allocs == 0 && stage.frees == 0) {
+            continue;
+        }
+        printf("%-20s %10llu %10llu %12.2f %12.1f\n",
+               i == G5_MEM_STAGE_OTHER ? "other" : g5_latency_stage_name((g5_stage_t)i),
+               stage.allocs, stage.frees, stage.bytes / (1024.0 * 1024.0),
+               stage.peak_live_bytes / 1024.0);
+        // Allocations per size class, e.g. <=64:120 is 120 blocks of 33 to 64 bytes
+        ostringstream classes;
+        for (int k = 0; k < G5_MEM_SIZE_CLASSES; k++) {
+            if (stage.size_classes[k] == 0) {
+                continue;
+            }
+            size_t limit = g5_mem_size_class_limit(k);
+            if (limit == 0) {
+                classes << " >" << g5_mem_size_class_limit(k - 1) / 1024 << "K";
+            } else if (limit < 1024) {
+                classes << " <=" << limit;
+            } else {
+                classes << " <=" << limit / 1024 << "K";
+            }
+            classes << ":" << stage.size_classes[k];
+        }
+        printf("%-20s%s\n", "", classes.str().c_str());
+    }
+}
+
+// PBexe -log <file> <mode and arguments>
+// Runs the mode with the asynchronous logger, matcher logs go to file through per-thread
+// rings instead of being written on the matcher threads.
+// PBexe -mem <mode and arguments>
+// Counts the pb_malloc and plat_alloc blocks of the matcher per stage and thread and
+// prints the merged counts, peaks and size classes after the mode.
+// PBexe -state|-state-mmap <dir> <mode and arguments>
+// Starts the matchers of the mode from the decision data stored in dir for the default
+// sensor type, read into memory or mapped, and saves the decision data the matchers hand
+// back after the mode, so the next run starts warm.
+// PBexe -arena <mode and arguments>
+// Serves the pb_malloc allocations of each comparison from the per-thread g5_arena.
+// Handles the -log, -latency, -trace, -mem, -state and -arena prefixes, which may be
+// combined, then runs the mode.
+static int RunPrefixed(int argc, char** argv) {
+    if (argc >= 3 && string(argv[1]) == "-log") {
+        if (plat_log_async_start(argv[2], 0) != 0) {
+            printf("Open log file %s fail\n", argv[2]);
+            return -1;
+        }
+        argv[2] = argv[0];
+        int ret = RunPrefixed(argc - 2, argv + 2);
+        plat_log_async_stop();
+        plat_log_async_stats_t stats;
+        plat_log_async_get_stats(&stats);
+        printf("log records = %llu, dropped = %llu, threads = %i\n", stats.written,
+               stats.dropped, stats.rings);
+        return ret;
+    }
+    if (argc >= 3 && (string(argv[1]) == "-latency" || string(argv[1]) == "-latency-tsc")) {
+        const char* json_path = argv[2];
+        if (string(argv[1]) == "-latency-tsc" &&
+            g5_latency_set_clock(G5_LATENCY_CLOCK_TSC) != G5_LATENCY_CLOCK_TSC) {
+            printf("No invariant TSC, using the monotonic clock\n");
+        }
+        g5_latency_reset();
+        g5_latency_enable(1);
+        argv[2] = argv[0];
+        int ret = RunPrefixed(argc - 2, argv + 2);
+        g5_latency_enable(0);
+        printf("%-20s %10s %10s %10s %10s %10s %10s\n", "stage", "count", "p50 us", "p90 us",
+               "p99 us", "p99.9 us", "max us");
+        for (int i = 0; i < G5_STAGE_COUNT; i++) {
+            g5_latency_summary_t summary;
+            g5_latency_get_summary((g5_stage_t)i, &summary);
+            printf("%-20s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                   g5_latency_stage_name((g5_stage_t)i), summary.count, summary.p50_us,
+                   summary.p90_us, summary.p99_us, summary.p999_us, summary.max_us);
+        }
+        if (g5_latency_write_json(json_path) != 0) {
+            printf("Write %s fail\n", json_path);
+            return ret != 0 ? ret : -1;
+        }
+        return ret;
+    }
+    if (argc >= 3 && string(argv[1]) == "-trace") {
+        const char* json_path = argv[2];
+        if (g5_trace_start(0) != 0) {
+            printf("Start trace fail\n");
+            return -1;
+        }
+        g5_trace_set_thread_name("main", -1);
+        argv[2] = argv[0];
+        int ret = RunPrefixed(argc - 2, argv + 2);
+        if (g5_trace_stop(json_path) != 0) {
+            printf("Write %s fail\n", json_path);
+            return ret != 0 ? ret : -1;
+        }
+        g5_trace_stats_t stats;
+        g5_trace_get_stats(&stats);
+        printf("trace events = %llu, dropped = %llu, threads = %i\n", stats.events,
+               stats.dropped, stats.threads);
+        return ret;
+    }
+    if (argc >= 2 && string(argv[1]) == "-mem") {
+        g5_mem_reset();
+        g5_mem_enable(1);
+        argv[1] = argv[0];
+        int ret = RunPrefixed(argc - 1, argv + 1);
+        g5_mem_enable(0);
+        g5_mem_report_t report;
+        g5_mem_get_report(&report);
+        PrintMemReport(report);
+        return ret;
+    }
+    if (argc >= 2 && string(argv[1]) == "-arena") {
+        g5_arena_configure(1, 0);
+        argv[1] = argv[0];
+        int ret = RunPrefixed(argc - 1, argv + 1);
+        g5_arena_configure(0, 0);
+        return ret;
+    }
+    if (argc >= 3 && (string(argv[1]) == "-state" || string(argv[1]) == "-state-mmap")) {
+        bool map = string(argv[1]) == "-state-mmap";
+        g5_decision_store_t* store = g5_decision_store_open(argv[2]);
+        if (store == NULL) {
+            printf("g5_decision_store_open %s fail\n", argv[2]);
+            return -1;
+        }
+        int sensor_type = g5_matcher_get_default_sensor_type();
+        g5_decision_data_t* loaded = NULL;
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        int status = g5_decision_store_get(store, sensor_type, map, &loaded);
+        double load_ms =
+            chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        if (status == 0) {
+            int len = 0;
+            unsigned char* data = g5_decision_data_bytes(loaded, &len);
+            g5_matcher_set_decision_data(data, len);
+            printf("decision data warm, %i bytes %s in %.3f ms\n", len, map ? "mapped" : "read",
+                   load_ms);
+        } else {
+            printf("decision data cold, g5_decision_store_get ret = %i\n", status);
+        }
+        argv[2] = argv[0];
+        int ret = RunPrefixed(argc - 2, argv + 2);
+        if (!SaveDecisionData(store, &loaded) && ret == 0) {
+            ret = -1;
+        }
+        g5_decision_store_close(store);
+        return ret;
+    }
+    return RunMode(argc, argv);
+}
+
+int main(int argc, char** argv) {
+    return RunPrefixed(argc, argv);
+}
@@ -1,5 +1,9 @@
 #include "merge_opencv.h"
 
+#include <cfloat>
+
+#include "../g5matcher/pb_image.h"
+
 #include "opencv2/opencv.hpp"
 
 using namespace std;
@@ -22,14 +26,121 @@ void MergeOpencv::CalculateRotationSize(int nSrcWidth, int nSrcHeight, int degre
     if (nRotatedHeight < nSrcHeight) nRotatedHeight = nSrcHeight;
 }
 
+// Bounding box of the non-zero pixels of an 8-bit image, empty if there are none
+static Rect NonZeroBounds(const Mat& img) {
+    int minX = img.cols, minY = img.rows, maxX = -1, maxY = -1;
+    for (int y = 0; y < img.rows; y++) {
+        const uchar* data = img.ptr<uchar>(y);
+        int x0 = 0, x1 = img.cols - 1;
+        while (x0 <= x1 && data[x0] == 0) x0++;
+        if (x0 > x1) continue;
+        while (data[x1] == 0) x1--;
+        if (x0 < minX) minX = x0;
+        if (x1 > maxX) maxX = x1;
+        if (minY > y) minY = y;
+        maxY = y;
+    }
+    return maxX < 0 ? Rect() : Rect(minX, minY, maxX + 1 - minX, maxY + 1 - minY);
+}
+
+// Copy the part of src (placed at pos) that falls into crop to dst, whose origin is at
+// crop.tl() - (border, border)
+static void CopyCropped(const Mat& src, Point pos, Rect crop, int border, Mat& dst) {
+    Rect r = Rect(pos, src.size()) & crop;
+    if (r.area() > 0) {
+        src(r - pos).copyTo(dst(r - crop.tl() + Point(border, border)));
+    }
+}
+
+// Rotate matT, placed at (offsetX, offsetY) of a szRotationWidth x szRotationHeight canvas,
+// by degree around that point. Only the region the template lands in is warped; it is
+// returned in imgWarped with its canvas position in ptWarped.
+static void WarpTemplate(const Mat& matT, int offsetX, int offsetY, double degree,
+                         int szRotationWidth, int szRotationHeight, Mat& imgWarped,
+                         Point& ptWarped) {
+    Mat r = getRotationMatrix2D(Point2f(offsetX, offsetY), degree, 1.0);
+
+    // Destination region of the template and the 1 pixel the interpolation reaches
+    // around it, plus a margin for the fixed point rounding
+    double minX = DBL_MAX, minY = DBL_MAX, maxX = -DBL_MAX, maxY = -DBL_MAX;
+    const double corners[4][2] = {{offsetX - 1., offsetY - 1.},
+                                  {offsetX + matT.cols + 0., offsetY - 1.},
+                                  {offsetX - 1., offsetY + matT.rows + 0.},
+                                  {offsetX + matT.cols + 0., offsetY + matT.rows + 0.}};
+    for (int i = 0; i < 4; i++) {
+        double x = r.at<double>(0, 0) * corners[i][0] + r.at<double>(0, 1) * corners[i][1] +
+                   r.at<double>(0, 2);
+        double y = r.at<double>(1, 0) * corners[i][0] + r.at<double>(1, 1) * corners[i][1] +
+                   r.at<double>(1, 2);
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+    Rect roi = Rect(Point(cvFloor(minX) - 2, cvFloor(minY) - 2),
+                    Point(cvCeil(maxX) + 3, cvCeil(maxY) + 3)) &
+               Rect(0, 0, szRotationWidth, szRotationHeight);
+
+    // Inverse map as warpAffine computes it
+    double M[6];
+    memcpy(M, r.ptr<double>(), sizeof(M));
+    double D = M[0] * M[4] - M[1] * M[3];
+    D = D != 0 ? 1. / D : 0;
+    double A11 = M[4] * D, A22 = M[0] * D;
+    M[0] = A11;
+    M[1] *= -D;
+    M[3] *= -D;
+    M[4] = A22;
+    double b1 = -M[0] * M[2] - M[1] * M[5];
+    double b2 = -M[3] * M[2] - M[4] * M[5];
+    M[2] = b1;
+    M[5] = b2;
+
+    // Fixed point source coordinates of the region, computed from the absolute canvas
+    // coordinates exactly like warpAffine does for INTER_LINEAR, then moved from the
+    // canvas to matT. The interpolation itself is left to remap, which is what
+    // warpAffine runs on its coordinates, so the pixels match a full canvas warp.
+    const int AB_BITS = 10, AB_SCALE = 1 << AB_BITS;
+    const int round_delta = AB_SCALE / INTER_TAB_SIZE / 2;
+    Mat mapXY(roi.height, roi.width, CV_16SC2);
+    Mat mapA(roi.height, roi.width, CV_16UC1);
+    for (int y = 0; y < roi.height; y++) {
+        short* xy = mapXY.ptr<short>(y);
+        ushort* a = mapA.ptr<ushort>(y);
+        int X0 = saturate_cast<int>((M[1] * (roi.y + y) + M[2]) * AB_SCALE) + round_delta;
+        int Y0 = saturate_cast<int>((M[4] * (roi.y + y) + M[5]) * AB_SCALE) + round_delta;
+        for (int x = 0; x < roi.width; x++) {
+            int X = (X0 + saturate_cast<int>(M[0] * (roi.x + x) * AB_SCALE)) >>
+                    (AB_BITS - INTER_BITS);
+            int Y = (Y0 + saturate_cast<int>(M[3] * (roi.x + x) * AB_SCALE)) >>
+                    (AB_BITS - INTER_BITS);
+            xy[x * 2] = saturate_cast<short>((X >> INTER_BITS) - offsetX);
+            xy[x * 2 + 1] = saturate_cast<short>((Y >> INTER_BITS) - offsetY);
+            a[x] = (ushort)((Y & (INTER_TAB_SIZE - 1)) * INTER_TAB_SIZE +
+                            (X & (INTER_TAB_SIZE - 1)));
+        }
+    }
+    // The canvas around the template is 0, as the constant border of matT
+    remap(matT, imgWarped, mapXY, mapA, INTER_LINEAR, BORDER_CONSTANT, Scalar(0));
+    ptWarped = roi.tl();
+}
+
 void MergeOpencv::Merge(unsigned char* imgT, unsigned char* imgv, int width, int height,
                         int iMmatch_score, int nRot, int nDx, int nDy) {
-    const int img_size = height * width;
-    Mat matT(height, width, CV_8UC1, Scalar(0));
-    memcpy((unsigned char*)matT.ptr(), imgT, img_size * sizeof(unsigned char));
-    Mat matV(height, width, CV_8UC1, Scalar(0));
-    memcpy((unsigned char*)matV.ptr(), imgv, img_size * sizeof(unsigned char));
+    Mat matOut = RenderOverlay(imgT, imgv, width, height, iMmatch_score, nRot, nDx, nDy);
+    if (!matOut.empty()) {
+        imwrite("merge.png", matOut);
+    }
+}
+
+Mat MergeOpencv::RenderOverlay(const unsigned char* imgT, const unsigned char* imgv, int width,
+                               int height, int iMmatch_score, int nRot, int nDx, int nDy) {
+    // Wrap the caller's buffers, they are only read
+    Mat matT(height, width, CV_8UC1, (void*)imgT);
+    Mat matV(height, width, CV_8UC1, (void*)imgv);
 
+    // Layout of the merged canvas: the template rotated around the center of a 2x
+    // canvas, offset by (nDx, nDy) against the verify image at the center
     double degree = -nRot;  // * 180.0 / 128
     int szBigHeight = height * 2;
     int szBigWidth = width * 2;
@@ -37,77 +148,43 @@ void MergeOpencv::Merge(unsigned char* imgT, unsigned char* imgv, int width, int
     CalculateRotationSize(szBigWidth, szBigHeight, degree, szRotationWidth, szRotationHeight);
     int offsetX = szRotationWidth / 2;
     int offsetY = szRotationHeight / 2;
-    Mat imgRot(szRotationHeight, szRotationWidth, CV_8UC1, Scalar(0));
-    matT.copyTo(imgRot(Rect(offsetX, offsetY, matT.cols, matT.rows)));
 
-    // rotate
-    Point2f ptCenter(offsetX, offsetY);
-    Mat r = getRotationMatrix2D(ptCenter, degree, 1.0);
-    Mat imgRotDst;
-    warpAffine(imgRot, imgRotDst, r, Size(szRotationWidth, szRotationHeight));
-
-    // convert to color image
-    Mat imgColorT;  // green
-    cvtColor(imgRotDst, imgColorT, cv::COLOR_GRAY2BGR);
-    for (int y = 0; y < szRotationHeight; y++) {
-        Vec3b* data = imgColorT.ptr<Vec3b>(y);
-        for (int x = 0; x < szRotationWidth; x++) {
-            data[x][0] = 0;
-            data[x][2] = 0;
-        }
-    }
-    Mat imgColorV;  // red
-    cvtColor(matV, imgColorV, cv::COLOR_GRAY2BGR);
-    for (int y = 0; y < matV.rows; y++) {
-        Vec3b* data = imgColorV.ptr<Vec3b>(y);
-        for (int x = 0; x < matV.cols; x++) {
-            data[x][0] = 0;
-            data[x][1] = 0;
-        }
+    // Green
+    Mat imgWarped;
+    Point ptWarped;
+    WarpTemplate(matT, offsetX, offsetY, degree, szRotationWidth, szRotationHeight, imgWarped,
+                 ptWarped);
+    Point posT = ptWarped + Point(nDx > 0 ? nDx : 0, nDy > 0 ? nDy : 0);
+    // Red
+    Point posV(nDx < 0 ? -nDx + offsetX : offsetX, nDy < 0 ? -nDy + offsetY : offsetY);
+
+    // crop to the pixels where G or R is not 0
+    Rect boundsT = NonZeroBounds(imgWarped);
+    Rect boundsV = NonZeroBounds(matV);
+    Rect crop;
+    if (boundsT.area() > 0 && boundsV.area() > 0) {
+        crop = (boundsT + posT) | (boundsV + posV);
+    } else if (boundsT.area() > 0) {
+        crop = boundsT + posT;
+    } else if (boundsV.area() > 0) {
+        crop = boundsV + posV;
+    } else {
+        return Mat();  // nothing to draw
     }
 
-    // merge images
-    int nMergedHeight = szRotationHeight + abs(nDy);
-    int nMergedWidth = szRotationWidth + abs(nDx);
-    Mat imgTmp1(nMergedHeight, nMergedWidth, CV_8UC3, Scalar(0));
-    imgColorT.copyTo(
-        imgTmp1(Rect(nDx > 0 ? nDx : 0, nDy > 0 ? nDy : 0, imgColorT.cols, imgColorT.rows)));
-    Mat imgTmp2(nMergedHeight, nMergedWidth, CV_8UC3, Scalar(0));
-    imgColorV.copyTo(
-        imgTmp2(Rect(nDx < 0 ? -nDx + offsetX : offsetX, nDy < 0 ? -nDy + offsetY : offsetY,
-                     imgColorV.cols, imgColorV.rows)));
-    int nPos = 5;
-    double alpha = (nPos <= 5) ? 1.0 : 1 - (nPos - 5) / 5.0;
-    double beta = (nPos >= 5) ? 1.0 : nPos / 5.0;
+    // merge planes into the cropped image with a 2 pixel letterbox
+    const int border = 2;
+    Size szOut(crop.width + 2 * border, crop.height + 2 * border);
+    Mat planes[3] = {Mat::zeros(szOut, CV_8UC1), Mat::zeros(szOut, CV_8UC1),
+                     Mat::zeros(szOut, CV_8UC1)};
+    CopyCropped(imgWarped, posT, crop, border, planes[1]);
+    CopyCropped(matV, posV, crop, border, planes[2]);
     Mat matOut;
-    addWeighted(imgTmp1, alpha, imgTmp2, beta, 0.0, matOut);
-	
-	// crop
-	int minX = nMergedWidth;
-	int minY = nMergedHeight;
-	int maxX = 0;
-	int maxY = 0;
-	for (int y = 0; y < nMergedHeight; y++) {
-		Vec3b* data = matOut.ptr<Vec3b>(y);
-		for (int x = 0; x < nMergedWidth; x++) {
-			if (data[x][1] > 0 || data[x][2] > 0 /*|| data[x][0] > 0*/)  // G or R not 0
-			{
-				if (x < minX) minX = x;
-				if (x > maxX) maxX = x;
-				if (y < minY) minY = y;
-				if (y > maxY) maxY = y;
-			}
-		}
-	}
-	matOut = matOut(Rect(minX, minY, maxX + 1 - minX, maxY + 1 - minY));
-	// add letterbox
-	Mat matRes(matOut.rows + 4, matOut.cols + 4, CV_8UC3, Scalar(0, 0, 0));
-	matOut.copyTo(matRes(Rect(2, 2, matOut.cols, matOut.rows)));
-	matOut = matRes;
+    merge(planes, 3, matOut);
 
     cv::String cvStrRange = cv::format("%d,%d,%d,%d", iMmatch_score, nRot, nDx, nDy);
     putText(matOut, cvStrRange, Point(20, 20), FONT_HERSHEY_SIMPLEX, 0.5, Scalar(255, 255, 255));
-	    imwrite("merge.png", matOut);
+    return matOut;
 }
 
 bool MergeOpencv::ReadPng(string sImgPath, unsigned char* img, int& width, int& height) {
@@ -127,3 +204,28 @@ bool MergeOpencv::ReadPng(string sImgPath, unsigned char* img, int& width, int&
 
     return true;
 }
+
+static void ReleaseMat(void* mat) {
+    delete (Mat*)mat;
+}
+
+pb_image_t* MergeOpencv::ReadPngImage(string sImgPath) {
+    // for long file name
+    char fn_long[1024];
+    sprintf_s(fn_long, 1024, "\\\\?\\%s", sImgPath.c_str());
+    Mat* matImg = new Mat(imread(sImgPath.c_str(), IMREAD_GRAYSCALE));
+    if (matImg->empty()) {
+        *matImg = imread(fn_long, IMREAD_GRAYSCALE);
+    }
+    if (matImg->empty() || !matImg->isContinuous()) {
+        delete matImg;
+        return NULL;
+    }
+    pb_image_t* image = pb_image_create_mre(
+        (uint16_t)matImg->rows, (uint16_t)matImg->cols, 500, 500, matImg->data,
+        PB_IMPRESSION_TYPE_UNKNOWN, 0, 1, ReleaseMat, matImg);
+    if (image == NULL) {
+        delete matImg;
+    }
+    return image;
+}
@@ -3,6 +3,9 @@
 
 #include <string>
 
+#include "../g5matcher/pb_image_t.h"
+#include "opencv2/core.hpp"
+
 class MergeOpencv {
    public:
     MergeOpencv();
@@ -10,9 +13,19 @@ class MergeOpencv {
 
 	bool ReadPng(std::string sImgPath, unsigned char* img, int& width, int& height);
 
+    // Decodes the png into a cv::Mat and wraps the Mat pixels as a memref pb_image_t, no
+    // copy. The Mat is released by pb_image_delete(). Returns NULL on failure.
+    pb_image_t* ReadPngImage(std::string sImgPath);
+
     void Merge(unsigned char* imgT, unsigned char* imgv, int width, int height, int iMmatch_score,
                int nRot, int nDx, int nDy);
 
+    // The overlay Merge() writes to merge.png: imgT rotated and shifted by the alignment in
+    // green over imgv in red, cropped and annotated with score, rot, dx and dy. Returns a
+    // BGR image, empty when both images are black. Thread-safe.
+    cv::Mat RenderOverlay(const unsigned char* imgT, const unsigned char* imgv, int width,
+                          int height, int iMmatch_score, int nRot, int nDx, int nDy);
+
    private:
     void CalculateRotationSize(int nSrcWidth, int nSrcHeight, int degree, int& nRotatedWidth,
                                int& nRotatedHeight);
@@ -0,0 +1,409 @@
+#include "raw16.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../g5matcher/EgisAlgorithmApiV2.h"
+#include "fileio.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define RAW16_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && _MSC_VER >= 1800 && (defined(_M_X64) || defined(_M_IX86))
+#define RAW16_HAVE_AVX2
+#define RAW16_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RAW16_HAVE_AVX2
+#define RAW16_TARGET_AVX2 __attribute__((target("avx2")))
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#define RAW16_MAX_PATH 1024
+
+static raw16_isa_t g_isa = RAW16_ISA_AUTO;
+
+/* Scalar */
+
+static void swap_scalar(unsigned short *p, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        p[i] = (unsigned short)((p[i] << 8) | (p[i] >> 8));
+    }
+}
+
+static void min_max_scalar(const unsigned short *p, int n, int *min, int *max) {
+    int i;
+    for (i = 0; i < n; i++) {
+        if (p[i] < *min) *min = p[i];
+        if (p[i] > *max) *max = p[i];
+    }
+}
+
+static void scale_scalar(const unsigned short *src, unsigned char *dst, int n, int min,
+                         int range) {
+    int i;
+    for (i = 0; i < n; i++) {
+        dst[i] = (unsigned char)((255 * (src[i] - min)) / range);
+    }
+}
+
+static void truncate_scalar(const unsigned short *src, unsigned char *dst, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        dst[i] = (unsigned char)src[i];
+    }
+}
+
+/*
+ * The vector scaling computes q = (255 * (v - min)) / range in float and corrects q
+ * by one where the float quotient rounded across an integer. Both 255 * (v - min)
+ * and (q + 1) * range stay below 2^24, so the correction is exact and the result
+ * matches the integer division of the scalar code.
+ */
+
+#ifdef RAW16_HAVE_SSE2
+
+static void swap_sse2(unsigned short *p, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i *)(p + i), v);
+    }
+    swap_scalar(p + i, n - i);
+}
+
+static void min_max_sse2(const unsigned short *p, int n, int *min, int *max) {
+    // SSE2 only has signed 16-bit min/max, flip the sign bit around them
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    __m128i vmin = _mm_set1_epi16(0x7FFF);
+    __m128i vmax = _mm_set1_epi16((short)0x8000);
+    unsigned short lanes[8];
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(p + i)), bias);
+        vmin = _mm_min_epi16(vmin, v);
+        vmax = _mm_max_epi16(vmax, v);
+    }
+    if (i > 0) {
+        _mm_storeu_si128((__m128i *)lanes, _mm_xor_si128(vmin, bias));
+        min_max_scalar(lanes, 8, min, max);
+        _mm_storeu_si128((__m128i *)lanes, _mm_xor_si128(vmax, bias));
+        min_max_scalar(lanes, 8, min, max);
+    }
+    min_max_scalar(p + i, n - i, min, max);
+}
+
+static __m128i scale4_sse2(__m128i d, __m128 range, __m128 inv_range) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 num = _mm_mul_ps(_mm_cvtepi32_ps(d), _mm_set1_ps(255.0f));
+    __m128 q = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(num, inv_range)));
+    q = _mm_add_ps(q, _mm_and_ps(_mm_cmple_ps(_mm_mul_ps(_mm_add_ps(q, one), range), num), one));
+    q = _mm_sub_ps(q, _mm_and_ps(_mm_cmpgt_ps(_mm_mul_ps(q, range), num), one));
+    return _mm_cvttps_epi32(q);
+}
+
+static void scale_sse2(const unsigned short *src, unsigned char *dst, int n, int min,
+                       int range) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vmin = _mm_set1_epi16((short)min);
+    const __m128 vrange = _mm_set1_ps((float)range);
+    const __m128 inv_range = _mm_set1_ps(1.0f / range);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // v - min fits 16 bits unsigned, widen to 32 bits for the float conversion
+        __m128i d0 = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)(src + i)), vmin);
+        __m128i d1 = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)(src + i + 8)), vmin);
+        __m128i q0 = _mm_packs_epi32(scale4_sse2(_mm_unpacklo_epi16(d0, zero), vrange, inv_range),
+                                     scale4_sse2(_mm_unpackhi_epi16(d0, zero), vrange, inv_range));
+        __m128i q1 = _mm_packs_epi32(scale4_sse2(_mm_unpacklo_epi16(d1, zero), vrange, inv_range),
+                                     scale4_sse2(_mm_unpackhi_epi16(d1, zero), vrange, inv_range));
+        // src and dst may alias, all 32 source bytes are loaded before the store
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(q0, q1));
+    }
+    scale_scalar(src + i, dst + i, n - i, min, range);
+}
+
+static void truncate_sse2(const unsigned short *src, unsigned char *dst, int n) {
+    const __m128i mask = _mm_set1_epi16(0xFF);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i)), mask);
+        __m128i v1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i + 8)), mask);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(v0, v1));
+    }
+    truncate_scalar(src + i, dst + i, n - i);
+}
+
+#endif
+
+#ifdef RAW16_HAVE_AVX2
+
+static int avx2_supported(void) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return 0;
+    }
+    __cpuid(info, 1);
+    // OSXSAVE and AVX, then the OS must save the YMM state
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 ||
+        (_xgetbv(0) & 6) != 6) {
+        return 0;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+RAW16_TARGET_AVX2 static void swap_avx2(unsigned short *p, int n) {
+    const __m256i shuffle = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                             1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        _mm256_storeu_si256((__m256i *)(p + i), _mm256_shuffle_epi8(v, shuffle));
+    }
+    swap_scalar(p + i, n - i);
+}
+
+RAW16_TARGET_AVX2 static void min_max_avx2(const unsigned short *p, int n, int *min,
+                                           int *max) {
+    __m256i vmin = _mm256_set1_epi16((short)0xFFFF);
+    __m256i vmax = _mm256_setzero_si256();
+    unsigned short lanes[16];
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        vmin = _mm256_min_epu16(vmin, v);
+        vmax = _mm256_max_epu16(vmax, v);
+    }
+    if (i > 0) {
+        _mm256_storeu_si256((__m256i *)lanes, vmin);
+        min_max_scalar(lanes, 16, min, max);
+        _mm256_storeu_si256((__m256i *)lanes, vmax);
+        min_max_scalar(lanes, 16, min, max);
+    }
+    min_max_scalar(p + i, n - i, min, max);
+}
+
+RAW16_TARGET_AVX2 static __m256i scale8_avx2(__m256i d, __m256 range, __m256 inv_range) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 num = _mm256_mul_ps(_mm256_cvtepi32_ps(d), _mm256_set1_ps(255.0f));
+    __m256 q = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_mul_ps(num, inv_range)));
+    q = _mm256_add_ps(
+        q, _mm256_and_ps(_mm256_cmp_ps(_mm256_mul_ps(_mm256_add_ps(q, one), range), num,
+                                       _CMP_LE_OQ),
+                         one));
+    q = _mm256_sub_ps(
+        q, _mm256_and_ps(_mm256_cmp_ps(_mm256_mul_ps(q, range), num, _CMP_GT_OQ), one));
+    return _mm256_cvttps_epi32(q);
+}
+
+RAW16_TARGET_AVX2 static void scale_avx2(const unsigned short *src, unsigned char *dst, int n,
+                                         int min, int range) {
+    const __m256i vmin = _mm256_set1_epi16((short)min);
+    const __m256 vrange = _mm256_set1_ps((float)range);
+    const __m256 inv_range = _mm256_set1_ps(1.0f / range);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i d0 = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i *)(src + i)), vmin);
+        __m256i d1 = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i *)(src + i + 16)), vmin);
+        __m256i q0 = scale8_avx2(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(d0)), vrange,
+                                 inv_range);
+        __m256i q1 = scale8_avx2(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(d0, 1)), vrange,
+                                 inv_range);
+        __m256i q2 = scale8_avx2(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(d1)), vrange,
+                                 inv_range);
+        __m256i q3 = scale8_avx2(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(d1, 1)), vrange,
+                                 inv_range);
+        // The packs work per 128-bit lane, restore the pixel order afterwards
+        __m256i w01 = _mm256_permute4x64_epi64(_mm256_packs_epi32(q0, q1), 0xD8);
+        __m256i w23 = _mm256_permute4x64_epi64(_mm256_packs_epi32(q2, q3), 0xD8);
+        __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(w01, w23), 0xD8);
+        // src and dst may alias, all 64 source bytes are loaded before the store
+        _mm256_storeu_si256((__m256i *)(dst + i), b);
+    }
+    scale_scalar(src + i, dst + i, n - i, min, range);
+}
+
+#endif
+
+raw16_isa_t raw16_set_isa(raw16_isa_t isa) {
+    raw16_isa_t best = RAW16_ISA_SCALAR;
+#ifdef RAW16_HAVE_SSE2
+    best = RAW16_ISA_SSE2;
+#endif
+#ifdef RAW16_HAVE_AVX2
+    if (avx2_supported()) {
+        best = RAW16_ISA_AVX2;
+    }
+#endif
+    g_isa = isa == RAW16_ISA_AUTO || isa > best ? best : isa;
+    return g_isa;
+}
+
+static raw16_isa_t current_isa(void) {
+    if (g_isa == RAW16_ISA_AUTO) {
+        raw16_set_isa(RAW16_ISA_AUTO);
+    }
+    return g_isa;
+}
+
+void raw16_swap_bytes(unsigned short *pixels, int nbr_of_pixels) {
+    switch (current_isa()) {
+#ifdef RAW16_HAVE_AVX2
+        case RAW16_ISA_AVX2:
+            swap_avx2(pixels, nbr_of_pixels);
+            return;
+#endif
+#ifdef RAW16_HAVE_SSE2
+        case RAW16_ISA_SSE2:
+            swap_sse2(pixels, nbr_of_pixels);
+            return;
+#endif
+        default:
+            swap_scalar(pixels, nbr_of_pixels);
+    }
+}
+
+void raw16_to_u8(const unsigned short *src, unsigned char *dst, int nbr_of_pixels) {
+    raw16_isa_t isa = current_isa();
+    int min = 0xFFFF, max = 0;
+    if (nbr_of_pixels <= 0) {
+        return;
+    }
+#ifdef RAW16_HAVE_AVX2
+    if (isa == RAW16_ISA_AVX2) {
+        min_max_avx2(src, nbr_of_pixels, &min, &max);
+    } else
+#endif
+#ifdef RAW16_HAVE_SSE2
+        if (isa >= RAW16_ISA_SSE2) {
+        min_max_sse2(src, nbr_of_pixels, &min, &max);
+    } else
+#endif
+    {
+        min_max_scalar(src, nbr_of_pixels, &min, &max);
+    }
+
+    if ((min == 0 && max == 255) || min == max) {
+#ifdef RAW16_HAVE_SSE2
+        if (isa >= RAW16_ISA_SSE2) {
+            truncate_sse2(src, dst, nbr_of_pixels);
+            return;
+        }
+#endif
+        truncate_scalar(src, dst, nbr_of_pixels);
+        return;
+    }
+#ifdef RAW16_HAVE_AVX2
+    if (isa == RAW16_ISA_AVX2) {
+        scale_avx2(src, dst, nbr_of_pixels, min, max - min);
+        return;
+    }
+#endif
+#ifdef RAW16_HAVE_SSE2
+    if (isa >= RAW16_ISA_SSE2) {
+        scale_sse2(src, dst, nbr_of_pixels, min, max - min);
+        return;
+    }
+#endif
+    scale_scalar(src, dst, nbr_of_pixels, min, max - min);
+}
+
+// Reads the frame into a new buffer and swaps it to host order
+static unsigned short *read_frame(const char *fn, int width, int height, int head_size,
+                                  int endian) {
+    FILE *f = NULL;
+    size_t n = (size_t)width * height, read;
+    unsigned short *pixels;
+    char fn_long[RAW16_MAX_PATH];
+
+    if (fn == NULL || width <= 0 || height <= 0 || head_size < 0) {
+        return NULL;
+    }
+    pixels = (unsigned short *)malloc(n * sizeof(unsigned short));
+    if (pixels == NULL) {
+        return NULL;
+    }
+    // for long file name
+#ifdef _MSC_VER
+    if (fopen_s(&f, fn, "rb") != 0) {
+        sprintf_s(fn_long, RAW16_MAX_PATH, "\\\\?\\%s", fn);
+        fopen_s(&f, fn_long, "rb");
+    }
+#else
+    f = fopen(fn, "rb");
+    (void)fn_long;
+#endif
+    if (f == NULL) {
+        free(pixels);
+        return NULL;
+    }
+    // Skip the header instead of reading it into a temporary buffer
+    if (fseek(f, (long)head_size * (long)sizeof(unsigned short), SEEK_SET) != 0) {
+        fclose(f);
+        free(pixels);
+        return NULL;
+    }
+    // A short file leaves the tail zero, as the calloc'ed temporaries did before
+    read = fread(pixels, sizeof(unsigned short), n, f);
+    memset(pixels + read, 0, (n - read) * sizeof(unsigned short));
+    fclose(f);
+    if (endian == BIG_ENDIAN) {
+        raw16_swap_bytes(pixels, (int)n);
+    }
+    return pixels;
+}
+
+int raw16_read(const char *fn, int width, int height, int head_size, int endian,
+               struct image_16bit *image) {
+    unsigned short *pixels;
+    if (image == NULL) {
+        return -1;
+    }
+    pixels = read_frame(fn, width, height, head_size, endian);
+    if (pixels == NULL) {
+        return -1;
+    }
+    memset(image, 0, sizeof(struct image_16bit));
+    image->pixels = pixels;
+    image->width = width;
+    image->height = height;
+    image->class = FP_IMAGE_TYPE_NORMAL;
+    image->full_width = width;
+    image->full_height = height;
+    return 0;
+}
+
+void raw16_free(struct image_16bit *image) {
+    if (image == NULL) {
+        return;
+    }
+    free(image->pixels);
+    image->pixels = NULL;
+}
+
+unsigned char *raw16_read_u8(const char *fn, int width, int height, int head_size,
+                             int endian) {
+    unsigned short *pixels = read_frame(fn, width, height, head_size, endian);
+    unsigned char *img;
+    if (pixels == NULL) {
+        return NULL;
+    }
+    // Convert over the 16-bit buffer, then give back its upper half
+    raw16_to_u8(pixels, (unsigned char *)pixels, width * height);
+    img = (unsigned char *)realloc(pixels, (size_t)width * height);
+    return img != NULL ? img : (unsigned char *)pixels;
+}
@@ -0,0 +1,70 @@
+#ifndef RAW16_H_
+#define RAW16_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 16-bit raw sensor data ingest.
+ *
+ * Frames are read straight into their final 16-bit buffer and byte-swapped in
+ * place; the 8-bit conversion writes over the same buffer. The per pixel loops
+ * have SSE2 and AVX2 versions picked at run time, with a scalar fallback.
+ */
+
+/** struct image_16bit of EgisAlgorithmApiV2.h, which C++ cannot include. */
+struct image_16bit;
+
+typedef enum raw16_isa {
+    RAW16_ISA_AUTO = 0,  // best supported
+    RAW16_ISA_SCALAR,
+    RAW16_ISA_SSE2,
+    RAW16_ISA_AVX2,
+} raw16_isa_t;
+
+/**
+ * Select the instruction set of the conversions, e.g. to benchmark them. Not
+ * thread-safe, call before starting workers.
+ *
+ * @return
+ *  the instruction set in use, isa or a lower one if isa is not supported.
+ */
+raw16_isa_t raw16_set_isa(raw16_isa_t isa);
+
+/** Swap the bytes of nbr_of_pixels pixels in place. */
+void raw16_swap_bytes(unsigned short *pixels, int nbr_of_pixels);
+
+/**
+ * Stretch the min..max range of src to 0..255 like normalize_int2UINT8 (pixels
+ * are truncated instead when the range is 0..255 already or flat). dst may be
+ * the same buffer as src.
+ */
+void raw16_to_u8(const unsigned short *src, unsigned char *dst,
+                 int nbr_of_pixels);
+
+/**
+ * Read a width x height 16-bit frame following head_size 16-bit header words
+ * into image (class FP_IMAGE_TYPE_NORMAL, no mask). BIG_ENDIAN frames are
+ * swapped to host order.
+ *
+ * @return
+ *  0, or -1 if the file could not be read. Release with raw16_free().
+ */
+int raw16_read(const char *fn, int width, int height, int head_size, int endian,
+               struct image_16bit *image);
+
+void raw16_free(struct image_16bit *image);
+
+/**
+ * Read a frame as raw16_read() and return it normalized to 8 bits, in a
+ * malloc'd width * height buffer. NULL if the file could not be read.
+ */
+unsigned char *raw16_read_u8(const char *fn, int width, int height,
+                             int head_size, int endian);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
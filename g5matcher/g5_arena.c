@@ -0,0 +1,316 @@
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+typedef unsigned char BYTE;
+#include "g5_arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "g5_latency.h"
+#include "g5_mem.h"
+#include "plat_log.h"
+
+// Chunks and the arena itself are not counted by g5_mem, their blocks are
+#ifndef plat_alloc
+#define plat_alloc(fmt) malloc(fmt)
+#endif
+
+#ifndef plat_free
+#define plat_free(x) free(x)
+#endif
+
+#ifdef _MSC_VER
+#define ARENA_THREAD_LOCAL __declspec(thread)
+#define ARENA_LOAD(p) InterlockedCompareExchange((volatile LONG*)(p), 0, 0)
+#define ARENA_INC(p) InterlockedIncrement((volatile LONG*)(p))
+#define ARENA_DEC(p) InterlockedDecrement((volatile LONG*)(p))
+#else
+#define ARENA_THREAD_LOCAL __thread
+#define ARENA_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define ARENA_INC(p) __sync_add_and_fetch((p), 1)
+#define ARENA_DEC(p) __sync_sub_and_fetch((p), 1)
+#endif
+
+// Blocks are 16-byte aligned like malloc on x64 and start with a header naming their
+// chunk and size, so pb_free knows where a block comes from and how many bytes it returns.
+#define ARENA_ALIGN 16
+#define ARENA_HEADER ARENA_ALIGN
+#define ARENA_MAX_BLOCK (G5_ARENA_CHUNK_SIZE / 4)
+
+// At the start of each chunk allocation, the blocks follow aligned.
+typedef struct arena_chunk {
+    volatile long refs;  // live blocks, plus one while the chunk belongs to an arena
+    unsigned char* data;
+} arena_chunk_t;
+
+typedef struct arena_header {
+    arena_chunk_t* chunk;  // NULL for a heap block
+    size_t size;           // bytes of the block, header included
+} arena_header_t;
+
+typedef struct thread_arena {
+    arena_chunk_t* chunks[G5_ARENA_MAX_CHUNKS];
+    int nbr_of_chunks;
+    int current;    // chunk the next block is bumped from
+    size_t offset;  // in the current chunk
+    size_t used;    // arena bytes handed out since the last reset, over all chunks
+    int depth;      // nesting of the open scopes
+    size_t live_bytes;  // arena and heap bytes live through pb_malloc
+    g5_arena_stats_t stats;
+} thread_arena_t;
+
+static int g_use_arena = 0;
+static int g_collect_stats = 0;
+
+static ARENA_THREAD_LOCAL thread_arena_t* tls_arena = NULL;
+
+static thread_arena_t* get_thread_arena(void) {
+    if (tls_arena == NULL) {
+        tls_arena = (thread_arena_t*)plat_alloc(sizeof(thread_arena_t));
+        if (tls_arena != NULL) {
+            memset(tls_arena, 0, sizeof(thread_arena_t));
+        }
+    }
+    return tls_arena;
+}
+
+static arena_header_t* block_header(void* ptr) {
+    return (arena_header_t*)((unsigned char*)ptr - ARENA_HEADER);
+}
+
+static void chunk_unref(arena_chunk_t* chunk) {
+    if (ARENA_DEC(&chunk->refs) == 0) {
+        plat_free(chunk);
+    }
+}
+
+static arena_chunk_t* chunk_create(void) {
+    arena_chunk_t* chunk =
+        (arena_chunk_t*)plat_alloc(sizeof(arena_chunk_t) + ARENA_ALIGN + G5_ARENA_CHUNK_SIZE);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    chunk->refs = 1;
+    chunk->data = (unsigned char*)(((size_t)(chunk + 1) + ARENA_ALIGN - 1) &
+                                   ~(size_t)(ARENA_ALIGN - 1));
+    return chunk;
+}
+
+static void* arena_bump(thread_arena_t* arena, size_t size) {
+    size_t need = ARENA_HEADER + ((size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1));
+    arena_chunk_t* chunk;
+    arena_header_t* header;
+
+    if (arena->nbr_of_chunks == 0 || arena->offset + need > G5_ARENA_CHUNK_SIZE) {
+        int next = arena->nbr_of_chunks == 0 ? 0 : arena->current + 1;
+        if (next == arena->nbr_of_chunks) {
+            if (next == G5_ARENA_MAX_CHUNKS || (chunk = chunk_create()) == NULL) {
+                return NULL;
+            }
+            arena->chunks[arena->nbr_of_chunks++] = chunk;
+        }
+        arena->current = next;
+        arena->offset = 0;
+    }
+    chunk = arena->chunks[arena->current];
+    header = (arena_header_t*)(chunk->data + arena->offset);
+    header->chunk = chunk;
+    header->size = need;
+    // Only the owning thread adds references, a racing free only lowers them
+    ARENA_INC(&chunk->refs);
+    arena->offset += need;
+    arena->used += need;
+    if (arena->used > arena->stats.arena_peak_bytes) {
+        arena->stats.arena_peak_bytes = arena->used;
+    }
+    return (unsigned char*)header + ARENA_HEADER;
+}
+
+static void* heap_alloc(size_t size) {
+    arena_header_t* header = (arena_header_t*)g5_mem_malloc(ARENA_HEADER + size);
+    if (header == NULL) {
+        return NULL;
+    }
+    header->chunk = NULL;
+    header->size = ARENA_HEADER + size;
+    return (unsigned char*)header + ARENA_HEADER;
+}
+
+static void add_live_bytes(thread_arena_t* arena, size_t bytes) {
+    arena->live_bytes += bytes;
+    if (arena->live_bytes > arena->stats.peak_bytes) {
+        arena->stats.peak_bytes = arena->live_bytes;
+    }
+}
+
+static void sub_live_bytes(thread_arena_t* arena, size_t bytes) {
+    // Blocks allocated before the counters were reset or on another thread are not in
+    // live_bytes
+    arena->live_bytes = arena->live_bytes > bytes ? arena->live_bytes - bytes : 0;
+}
+
+void g5_arena_configure(int use_arena, int collect_stats) {
+    g_use_arena = use_arena != 0;
+    g_collect_stats = collect_stats != 0;
+}
+
+void g5_arena_begin(void) {
+    thread_arena_t* arena;
+    if (!g_use_arena || (arena = get_thread_arena()) == NULL) {
+        return;
+    }
+    arena->depth++;
+}
+
+void g5_arena_end(void) {
+    thread_arena_t* arena = tls_arena;
+    int i, kept = 0;
+    if (arena == NULL || arena->depth == 0) {
+        return;
+    }
+    if (--arena->depth > 0) {
+        return;
+    }
+    // A chunk down to the arena's own reference has no live block and no thread can
+    // add one, the others are left to their last pb_free
+    for (i = 0; i < arena->nbr_of_chunks; i++) {
+        arena_chunk_t* chunk = arena->chunks[i];
+        if (ARENA_LOAD(&chunk->refs) == 1) {
+            arena->chunks[kept++] = chunk;
+        } else {
+            chunk_unref(chunk);
+            arena->stats.retired++;
+        }
+    }
+    arena->nbr_of_chunks = kept;
+    arena->current = 0;
+    arena->offset = 0;
+    arena->used = 0;
+    arena->stats.resets++;
+}
+
+void* g5_arena_malloc(size_t size) {
+    thread_arena_t* arena;
+    unsigned long long start = 0;
+    void* ptr = NULL;
+
+    if (!g_use_arena && !g_collect_stats) {
+        return heap_alloc(size);
+    }
+    arena = get_thread_arena();
+    if (arena == NULL) {
+        return heap_alloc(size);
+    }
+    if (g_collect_stats) {
+        start = g5_latency_now_ns();
+    }
+    if (g_use_arena && arena->depth > 0 && size <= ARENA_MAX_BLOCK) {
+        ptr = arena_bump(arena, size);
+        if (ptr != NULL) {
+            size_t need = block_header(ptr)->size;
+            arena->stats.arena_allocs++;
+            add_live_bytes(arena, need);
+            g5_mem_on_alloc(need);
+        }
+    }
+    if (ptr == NULL) {
+        ptr = heap_alloc(size);
+        if (ptr != NULL) {
+            arena->stats.heap_allocs++;
+            add_live_bytes(arena, block_header(ptr)->size);
+        }
+    }
+    if (g_collect_stats) {
+        arena->stats.alloc_ns += (long long)(g5_latency_now_ns() - start);
+    }
+    return ptr;
+}
+
+void g5_arena_free(void* ptr) {
+    thread_arena_t* arena = tls_arena;
+    arena_header_t* header;
+    unsigned long long start = 0;
+
+    if (ptr == NULL) {
+        return;
+    }
+    header = block_header(ptr);
+    if (arena != NULL && g_collect_stats) {
+        start = g5_latency_now_ns();
+    }
+    if (arena != NULL) {
+        arena->stats.frees++;
+        sub_live_bytes(arena, header->size);
+    }
+    if (header->chunk != NULL) {
+        g5_mem_on_free(header->size);
+        chunk_unref(header->chunk);
+    } else {
+        g5_mem_free(header);
+    }
+    if (arena != NULL && g_collect_stats) {
+        arena->stats.alloc_ns += (long long)(g5_latency_now_ns() - start);
+    }
+}
+
+void* g5_arena_promote(void* ptr, size_t size) {
+    thread_arena_t* arena = tls_arena;
+    arena_header_t* header;
+    void* copy;
+
+    if (ptr == NULL) {
+        return NULL;
+    }
+    header = block_header(ptr);
+    if (header->chunk == NULL) {
+        // A heap block already is a malloc block, the data moves over the header. It
+        // leaves the pb_malloc accounting here.
+        if (arena != NULL) {
+            sub_live_bytes(arena, header->size);
+        }
+        memmove(header, ptr, size);
+        return header;
+    }
+    copy = g5_mem_malloc(size);
+    if (copy != NULL) {
+        memcpy(copy, ptr, size);
+        if (arena != NULL) {
+            arena->stats.promoted++;
+        }
+    } else {
+        ex_log(LOG_ERROR, "g5_arena_promote: out of memory for %d bytes", (int)size);
+    }
+    g5_arena_free(ptr);
+    return copy;
+}
+
+void g5_arena_get_stats(g5_arena_stats_t* stats) {
+    if (tls_arena != NULL) {
+        *stats = tls_arena->stats;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
+
+void g5_arena_reset_stats(void) {
+    thread_arena_t* arena = tls_arena;
+    if (arena != NULL) {
+        memset(&arena->stats, 0, sizeof(arena->stats));
+        arena->live_bytes = 0;
+    }
+}
+
+void g5_arena_release(void) {
+    thread_arena_t* arena = tls_arena;
+    int i;
+    if (arena == NULL || arena->depth > 0) {
+        return;
+    }
+    for (i = 0; i < arena->nbr_of_chunks; i++) {
+        chunk_unref(arena->chunks[i]);
+    }
+    plat_free(arena);
+    tls_arena = NULL;
+}
@@ -0,0 +1,93 @@
+#ifndef G5_ARENA_H_
+#define G5_ARENA_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Per-thread arena behind pb_malloc / pb_free, the allocation hook of the BMF library.
+ *
+ * A comparison makes many short-lived allocations inside the library. While the arena
+ * is on, pb_malloc inside a scope (g5_arena_begin() .. g5_arena_end(), one comparison)
+ * bumps a pointer in a chunk owned by the calling thread. When the outermost scope
+ * ends, the chunks without live blocks are reset and the next comparison reuses them.
+ *
+ * Every pb_malloc block, arena or heap, starts with a header naming its chunk (none for
+ * a heap block), so pb_free takes any block on any thread and in either mode. A chunk
+ * counts its live blocks; one that still has live blocks when the scope ends is retired
+ * from the arena and freed by whichever thread frees its last block, the arena goes on
+ * with fresh chunks. Templates returned by extraction are copied out with
+ * g5_arena_promote() as the callers free them with g5_matcher_free_template(). Outside
+ * a scope, for blocks larger than a quarter chunk and when all chunks are in use,
+ * pb_malloc falls back to malloc. Arena and heap blocks alike are counted by g5_mem
+ * when it is enabled.
+ *
+ * The arena is off unless g5_arena_configure() turns it on (PBexe -arena). A thread
+ * that used it calls g5_arena_release() before it ends, g5_matcher_destroy() does.
+ */
+
+#define G5_ARENA_CHUNK_SIZE (1024 * 1024)
+#define G5_ARENA_MAX_CHUNKS 16
+
+typedef struct g5_arena_stats {
+    unsigned long long arena_allocs;     // blocks served from the arena
+    unsigned long long heap_allocs;      // blocks served by malloc
+    unsigned long long frees;            // pb_free calls with a block
+    unsigned long long promoted;         // blocks copied out of the arena by promote
+    unsigned long long resets;           // outermost scopes ended
+    unsigned long long retired;          // chunks retired with blocks still live
+    size_t peak_bytes;                   // peak of the bytes live through pb_malloc
+    size_t arena_peak_bytes;             // peak of the arena bytes in use, headers included
+    long long alloc_ns;                  // time in pb_malloc and pb_free, with timing on
+} g5_arena_stats_t;
+
+/**
+ * Select what pb_malloc does from now on. With both off (the default) pb_malloc is
+ * malloc with the block header in front. Change it only while no comparison is running.
+ *
+ * @param use_arena
+ *  serve the allocations inside a scope from the arena
+ * @param collect_stats
+ *  count the allocations of each thread, see g5_arena_get_stats(), and time them
+ */
+void g5_arena_configure(int use_arena, int collect_stats);
+
+/** Open a scope on the calling thread, scopes nest. */
+void g5_arena_begin(void);
+
+/** Close a scope; the outermost one resets the free chunks and retires the others. */
+void g5_arena_end(void);
+
+void* g5_arena_malloc(size_t size);
+void g5_arena_free(void* ptr);
+
+/**
+ * Turn a pb_malloc block that leaves the library into a plain malloc block.
+ *
+ * @return
+ *  a block freed with g5_mem_free() holding the first size bytes of ptr, ptr is freed.
+ *  NULL if out of memory, ptr is freed then too.
+ */
+void* g5_arena_promote(void* ptr, size_t size);
+
+/**
+ * Counters of the calling thread since the last g5_arena_reset_stats() on it. A block
+ * freed on another thread counts on the freeing thread.
+ */
+void g5_arena_get_stats(g5_arena_stats_t* stats);
+void g5_arena_reset_stats(void);
+
+/**
+ * Drop the chunks and counters of the calling thread, outside any scope. Chunks with
+ * live blocks are freed with their last block.
+ */
+void g5_arena_release(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,239 @@
+typedef unsigned char BYTE;
+#include "g5_batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "EgisAlgorithmApiV2.h"
+#include "g5_trace.h"
+#include "plat_log.h"
+#include "plat_thread.h"
+
+#ifndef plat_alloc
+#define plat_alloc(fmt) malloc(fmt)
+#endif
+
+#ifndef PLAT_FREE
+#define PLAT_FREE(x) \
+    if (x != NULL) { \
+        free(x);     \
+        x = NULL;    \
+    }
+#endif
+
+#define BATCH_MAX_THREADS 256
+// Columns handed out to a worker at a time
+#define BATCH_BLOCK_COLS 32
+
+typedef struct batch_job {
+    unsigned char** probes;
+    unsigned char** gallery;
+    int symmetric;
+    int w;
+    int h;
+    struct algo_info* algo_info;
+    g5_template_cache_t* cache;
+    g5_batch_result_t* result;
+    int blocks_per_row;
+    int nbr_of_tasks;
+    int next_task;
+    mutex_handle_t task_mutex;
+} batch_job_t;
+
+typedef struct batch_worker {
+    batch_job_t* job;
+    int index;
+    int nbr_of_failed;
+    thread_handle_t thread;
+    thread_param_t param;
+} batch_worker_t;
+
+// Returns the next task index, or -1 when all tasks are taken
+static int next_task(batch_job_t* job) {
+    int task = -1;
+    plat_mutex_lock(job->task_mutex);
+    if (job->next_task < job->nbr_of_tasks) {
+        task = job->next_task++;
+    }
+    plat_mutex_unlock(job->task_mutex);
+    return task;
+}
+
+static void run_task(batch_worker_t* worker, g5_matcher_t* matcher, int task, int* nbr_of_pairs) {
+    batch_job_t* job = worker->job;
+    g5_batch_result_t* result = job->result;
+    int i = task / job->blocks_per_row;
+    int j = (task % job->blocks_per_row) * BATCH_BLOCK_COLS;
+    int j_end = j + BATCH_BLOCK_COLS;
+    unsigned char** cols = job->symmetric ? job->probes : job->gallery;
+
+    if (j_end > result->cols) {
+        j_end = result->cols;
+    }
+    if (job->symmetric && j <= i) {
+        j = i + 1;
+    }
+    for (; j < j_end; j++) {
+        int cell = i * result->cols + j;
+        int score = 0, rot = 0, dx = 0, dy = 0;
+        int status;
+        G5_TRACE_SET_PAIR(cell);
+        status = g5_matcher_compare(matcher, job->probes[i], cols[j], job->w, job->h, &score,
+                                    &rot, &dx, &dy);
+        result->status[cell] = status;
+        if (g5_matcher_compare_succeeded(status)) {
+            result->score[cell] = score;
+            result->rot[cell] = rot;
+            result->dx[cell] = dx;
+            result->dy[cell] = dy;
+        } else {
+            worker->nbr_of_failed++;
+        }
+        (*nbr_of_pairs)++;
+    }
+}
+
+static int batch_worker_routine(void* arg) {
+    batch_worker_t* worker = (batch_worker_t*)((thread_param_t*)arg)->params;
+    batch_job_t* job = worker->job;
+    int nbr_of_pairs = 0;
+    int task;
+
+    g5_trace_set_thread_name("batch worker", worker->index);
+    g5_matcher_t* matcher = g5_matcher_create(job->algo_info);
+    if (matcher == NULL) {
+        // The other workers take its tasks
+        ex_log(LOG_ERROR, "batch worker %d: g5_matcher_create failed", worker->index);
+        return FP_ERR;
+    }
+    g5_matcher_set_template_cache(matcher, job->cache);
+
+    while ((task = next_task(job)) >= 0) {
+        run_task(worker, matcher, task, &nbr_of_pairs);
+    }
+
+    g5_matcher_destroy(matcher);
+    job->result->pairs_per_worker[worker->index] = nbr_of_pairs;
+    return FP_OK;
+}
+
+static int result_alloc(g5_batch_result_t* result, int rows, int cols, int nbr_of_workers) {
+    int i, cells = rows * cols;
+    memset(result, 0, sizeof(g5_batch_result_t));
+    result->rows = rows;
+    result->cols = cols;
+    result->nbr_of_workers = nbr_of_workers;
+    result->score = (int*)plat_alloc(cells * sizeof(int));
+    result->rot = (int*)plat_alloc(cells * sizeof(int));
+    result->dx = (int*)plat_alloc(cells * sizeof(int));
+    result->dy = (int*)plat_alloc(cells * sizeof(int));
+    result->status = (int*)plat_alloc(cells * sizeof(int));
+    result->pairs_per_worker = (int*)plat_alloc(nbr_of_workers * sizeof(int));
+    if (result->score == NULL || result->rot == NULL || result->dx == NULL || result->dy == NULL ||
+        result->status == NULL || result->pairs_per_worker == NULL) {
+        g5_batch_result_free(result);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    for (i = 0; i < cells; i++) {
+        result->score[i] = G5_BATCH_NOT_COMPUTED;
+        result->status[i] = G5_BATCH_NOT_COMPUTED;
+    }
+    memset(result->rot, 0, cells * sizeof(int));
+    memset(result->dx, 0, cells * sizeof(int));
+    memset(result->dy, 0, cells * sizeof(int));
+    memset(result->pairs_per_worker, 0, nbr_of_workers * sizeof(int));
+    return FP_OK;
+}
+
+int g5_batch_compare(unsigned char** probes, int nbr_of_probes, unsigned char** gallery,
+                     int nbr_of_gallery, int w, int h, struct algo_info* algo_info,
+                     int nbr_of_threads, g5_template_cache_t* cache, g5_batch_result_t* result) {
+    batch_job_t job;
+    batch_worker_t* workers;
+    int i, ret, nbr_of_pairs = 0, expected_pairs;
+
+    if (probes == NULL || result == NULL || nbr_of_probes <= 0 ||
+        (gallery != NULL && nbr_of_gallery <= 0)) {
+        return FP_NULL_DATA;
+    }
+    if (nbr_of_threads <= 0) {
+        nbr_of_threads = 1;
+    }
+    if (nbr_of_threads > BATCH_MAX_THREADS) {
+        nbr_of_threads = BATCH_MAX_THREADS;
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.probes = probes;
+    job.gallery = gallery;
+    job.symmetric = gallery == NULL;
+    job.w = w;
+    job.h = h;
+    job.algo_info = algo_info;
+    job.cache = cache;
+    job.result = result;
+
+    ret = result_alloc(result, nbr_of_probes, job.symmetric ? nbr_of_probes : nbr_of_gallery,
+                       nbr_of_threads);
+    if (ret != FP_OK) {
+        return ret;
+    }
+    job.blocks_per_row = (result->cols + BATCH_BLOCK_COLS - 1) / BATCH_BLOCK_COLS;
+    job.nbr_of_tasks = result->rows * job.blocks_per_row;
+    if (plat_mutex_create(&job.task_mutex) != THREAD_RES_OK) {
+        g5_batch_result_free(result);
+        return FP_ERR;
+    }
+
+    workers = (batch_worker_t*)plat_alloc(nbr_of_threads * sizeof(batch_worker_t));
+    if (workers == NULL) {
+        plat_mutex_release(&job.task_mutex);
+        g5_batch_result_free(result);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    memset(workers, 0, nbr_of_threads * sizeof(batch_worker_t));
+
+    for (i = 0; i < nbr_of_threads; i++) {
+        workers[i].job = &job;
+        workers[i].index = i;
+        workers[i].param.params = &workers[i];
+        if (plat_thread_create_ex(&workers[i].thread, (void*)batch_worker_routine,
+                                  &workers[i].param) != THREAD_RES_OK) {
+            // The threads already running pick up the remaining tasks
+            ex_log(LOG_ERROR, "g5_batch_compare: only %d of %d workers started", i,
+                   nbr_of_threads);
+            break;
+        }
+    }
+    for (i = 0; i < nbr_of_threads; i++) {
+        plat_thread_release(&workers[i].thread);
+        result->nbr_of_failed += workers[i].nbr_of_failed;
+        nbr_of_pairs += result->pairs_per_worker[i];
+    }
+
+    PLAT_FREE(workers);
+    plat_mutex_release(&job.task_mutex);
+    // Any running worker takes tasks until none are left, so pairs are only missing when
+    // no worker started or created its matcher
+    expected_pairs = job.symmetric ? result->rows * (result->rows - 1) / 2
+                                   : result->rows * result->cols;
+    if (nbr_of_pairs < expected_pairs) {
+        ex_log(LOG_ERROR, "g5_batch_compare: %d of %d pairs compared", nbr_of_pairs,
+               expected_pairs);
+        return FP_ERR;
+    }
+    return FP_OK;
+}
+
+void g5_batch_result_free(g5_batch_result_t* result) {
+    if (result == NULL) {
+        return;
+    }
+    PLAT_FREE(result->score);
+    PLAT_FREE(result->rot);
+    PLAT_FREE(result->dx);
+    PLAT_FREE(result->dy);
+    PLAT_FREE(result->status);
+    PLAT_FREE(result->pairs_per_worker);
+}
@@ -0,0 +1,67 @@
+#ifndef G5_BATCH_H_
+#define G5_BATCH_H_
+
+#include "g5_match.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define G5_BATCH_NOT_COMPUTED (-1)
+
+/**
+ * Score matrices of a batch comparison, row-major with nbr_of_probes rows and
+ * nbr_of_gallery (or nbr_of_probes for all-vs-all) columns. Allocated by
+ * g5_batch_compare(), freed by g5_batch_result_free().
+ *
+ * status holds what g5_matcher_compare() returned for each pair. A pair whose compare
+ * failed keeps score G5_BATCH_NOT_COMPUTED and alignment 0, its error code is only in
+ * status.
+ */
+typedef struct g5_batch_result {
+    int rows;
+    int cols;
+    int* score;
+    int* rot;
+    int* dx;
+    int* dy;
+    /** g5_matcher_compare() status, G5_BATCH_NOT_COMPUTED for the cells not compared. */
+    int* status;
+    /** Pairs whose compare returned an FP_* error code. */
+    int nbr_of_failed;
+    /** Number of comparisons made by each worker thread, failed ones included. */
+    int* pairs_per_worker;
+    int nbr_of_workers;
+} g5_batch_result_t;
+
+/**
+ * g5_batch_compare
+ *
+ * Compares every probe (row) against every gallery image (column) on a pool of worker
+ * threads, each worker owning its own g5_matcher_t.
+ *
+ * @param gallery
+ *  NULL for a symmetric all-vs-all run over probes; only the cells i < j are computed,
+ *  the other cells are set to G5_BATCH_NOT_COMPUTED / 0.
+ * @param algo_info
+ *  matcher configuration for every worker, NULL for the defaults.
+ * @param nbr_of_threads
+ *  number of worker threads, <= 0 for one.
+ * @param cache
+ *  optional template cache shared by the workers, may be NULL.
+ * @return
+ *  FP_OK once every pair was compared, even if some compares failed (see
+ *  result->nbr_of_failed). FP_ERR if pairs were left because no worker could create a
+ *  matcher, or another FP_* error code.
+ */
+int g5_batch_compare(unsigned char** probes, int nbr_of_probes, unsigned char** gallery,
+                     int nbr_of_gallery, int w, int h, struct algo_info* algo_info,
+                     int nbr_of_threads, g5_template_cache_t* cache, g5_batch_result_t* result);
+
+void g5_batch_result_free(g5_batch_result_t* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
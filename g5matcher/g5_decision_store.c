@@ -0,0 +1,328 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+typedef unsigned char BYTE;
+#include "g5_decision_store.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "EgisAlgorithmApiV2.h"
+#include "g5_mem.h"
+#include "pb_crc32.h"
+#include "plat_file.h"
+#include "plat_log.h"
+
+#ifndef plat_alloc
+#define plat_alloc(fmt) g5_mem_malloc(fmt)
+#endif
+
+#ifndef PLAT_FREE
+#define PLAT_FREE(x)    \
+    if (x != NULL) {    \
+        g5_mem_free(x); \
+        x = NULL;       \
+    }
+#endif
+
+#define DECISION_STORE_MAGIC 0x44443547  // "G5DD"
+// Version 1 also keyed the data by a model name
+#define DECISION_STORE_VERSION 2
+// magic, version, sensor type, data size, CRC-32, reserved; the data starts on a 64 byte
+// boundary of the mapping
+#define DECISION_STORE_HEADER_SIZE 64
+
+struct g5_decision_store {
+    char dir[PATH_MAX];
+};
+
+struct g5_decision_data {
+    unsigned char* base;  // the whole file, header included
+    size_t size;
+    int mapped;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static int make_path(const g5_decision_store_t* store, int sensor_type, const char* suffix,
+                     char* path) {
+    int len;
+#ifdef _MSC_VER
+    len = sprintf_s(path, PATH_MAX, "%s\\sensor_%d%s%s", store->dir, sensor_type,
+                    G5_DECISION_STORE_EXT, suffix);
+#else
+    len = snprintf(path, PATH_MAX, "%s/sensor_%d%s%s", store->dir, sensor_type,
+                   G5_DECISION_STORE_EXT, suffix);
+#endif
+    return len > 0 && len < PATH_MAX ? FP_OK : FP_ERR;
+}
+
+static int replace_file(const char* from, const char* to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+    return rename(from, to);
+#endif
+}
+
+g5_decision_store_t* g5_decision_store_open(const char* dir) {
+    g5_decision_store_t* store;
+    size_t len;
+    if (dir == NULL) {
+        return NULL;
+    }
+    len = strlen(dir);
+    if (len == 0 || len >= PATH_MAX) {
+        return NULL;
+    }
+    store = (g5_decision_store_t*)plat_alloc(sizeof(g5_decision_store_t));
+    if (store == NULL) {
+        return NULL;
+    }
+    memcpy(store->dir, dir, len + 1);
+    // Paths are built with a separator of their own
+    while (len > 1 && (store->dir[len - 1] == '/' || store->dir[len - 1] == '\\')) {
+        store->dir[--len] = '\0';
+    }
+    return store;
+}
+
+void g5_decision_store_close(g5_decision_store_t* store) {
+    PLAT_FREE(store);
+}
+
+int g5_decision_store_put(g5_decision_store_t* store, int sensor_type,
+                          const unsigned char* data, int data_len) {
+    char path[PATH_MAX];
+    char tmp_path[PATH_MAX];
+    unsigned char header[DECISION_STORE_HEADER_SIZE];
+    FILE* file;
+    int ret;
+
+    if (store == NULL || data == NULL || data_len <= 0) {
+        return FP_NULL_DATA;
+    }
+    if ((ret = make_path(store, sensor_type, "", path)) != FP_OK ||
+        (ret = make_path(store, sensor_type, ".tmp", tmp_path)) != FP_OK) {
+        return ret;
+    }
+    memset(header, 0, sizeof(header));
+    put_u32(header, DECISION_STORE_MAGIC);
+    put_u32(header + 4, DECISION_STORE_VERSION);
+    put_u32(header + 8, (uint32_t)sensor_type);
+    put_u32(header + 12, (uint32_t)data_len);
+    put_u32(header + 16, pb_crc32(data, (uint32_t)data_len));
+
+    // Header and data are written as they are, without a copy of the data
+    file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        ex_log(LOG_ERROR, "g5_decision_store_put: failed to create %s", tmp_path);
+        return FP_ERR;
+    }
+    ret = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+          fwrite(data, 1, data_len, file) == (size_t)data_len;
+    if (fclose(file) != 0 || !ret || replace_file(tmp_path, path) != 0) {
+        ex_log(LOG_ERROR, "g5_decision_store_put: failed to write %s", path);
+        remove(tmp_path);
+        return FP_ERR;
+    }
+    return FP_OK;
+}
+
+static int read_file(const char* path, g5_decision_data_t* data) {
+    FILE* file = fopen(path, "rb");
+    long size;
+    if (file == NULL) {
+        return FP_NULL_DATA;
+    }
+    if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 ||
+        fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return FP_ERR;
+    }
+    if (size < DECISION_STORE_HEADER_SIZE ||
+        size > DECISION_STORE_HEADER_SIZE + G5_DECISION_STORE_MAX_SIZE) {
+        fclose(file);
+        return FP_INVALID_FORMAT;
+    }
+    data->base = (unsigned char*)plat_alloc(size);
+    if (data->base == NULL) {
+        fclose(file);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    data->size = (size_t)size;
+    if (fread(data->base, 1, data->size, file) != data->size) {
+        fclose(file);
+        return FP_ERR;
+    }
+    fclose(file);
+    return FP_OK;
+}
+
+static int map_file(const char* path, g5_decision_data_t* data) {
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    data->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, NULL);
+    if (data->file == INVALID_HANDLE_VALUE) {
+        data->file = NULL;
+        return FP_NULL_DATA;
+    }
+    if (!GetFileSizeEx(data->file, &size)) {
+        return FP_ERR;
+    }
+    if (size.QuadPart < DECISION_STORE_HEADER_SIZE ||
+        size.QuadPart > DECISION_STORE_HEADER_SIZE + G5_DECISION_STORE_MAX_SIZE) {
+        return FP_INVALID_FORMAT;
+    }
+    data->size = (size_t)size.QuadPart;
+    // Copy-on-write, the G5 API takes non-const decision data
+    data->mapping = CreateFileMappingA(data->file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (data->mapping == NULL) {
+        return FP_ERR;
+    }
+    data->base = (unsigned char*)MapViewOfFile(data->mapping, FILE_MAP_COPY, 0, 0, 0);
+#else
+    struct stat st;
+    void* base;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return FP_NULL_DATA;
+    }
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return FP_ERR;
+    }
+    if (st.st_size < DECISION_STORE_HEADER_SIZE ||
+        st.st_size > DECISION_STORE_HEADER_SIZE + G5_DECISION_STORE_MAX_SIZE) {
+        close(fd);
+        return FP_INVALID_FORMAT;
+    }
+    data->size = (size_t)st.st_size;
+    // Copy-on-write, the G5 API takes non-const decision data
+    base = mmap(NULL, data->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    data->base = base != MAP_FAILED ? (unsigned char*)base : NULL;
+#endif
+    if (data->base == NULL) {
+        return FP_ERR;
+    }
+    data->mapped = 1;
+    return FP_OK;
+}
+
+static int validate(const g5_decision_data_t* data, int sensor_type) {
+    const unsigned char* header = data->base;
+    uint32_t size = get_u32(header + 12);
+
+    return get_u32(header) == DECISION_STORE_MAGIC &&
+           get_u32(header + 4) == DECISION_STORE_VERSION &&
+           get_u32(header + 8) == (uint32_t)sensor_type &&
+           size > 0 && size == data->size - DECISION_STORE_HEADER_SIZE &&
+           pb_crc32(header + DECISION_STORE_HEADER_SIZE, size) == get_u32(header + 16);
+}
+
+int g5_decision_store_get(g5_decision_store_t* store, int sensor_type, int map,
+                          g5_decision_data_t** data) {
+    char path[PATH_MAX];
+    g5_decision_data_t* loaded;
+    int ret;
+
+    if (store == NULL || data == NULL) {
+        return FP_NULL_DATA;
+    }
+    *data = NULL;
+    ret = make_path(store, sensor_type, "", path);
+    if (ret != FP_OK) {
+        return ret;
+    }
+    loaded = (g5_decision_data_t*)plat_alloc(sizeof(g5_decision_data_t));
+    if (loaded == NULL) {
+        return FP_ALLOC_MEM_FAIL;
+    }
+    memset(loaded, 0, sizeof(g5_decision_data_t));
+    ret = map ? map_file(path, loaded) : read_file(path, loaded);
+    if (ret == FP_OK && !validate(loaded, sensor_type)) {
+        ex_log(LOG_ERROR, "g5_decision_store_get: %s is not valid decision data", path);
+        ret = FP_INVALID_FORMAT;
+    }
+    if (ret != FP_OK) {
+        g5_decision_data_release(loaded);
+        return ret;
+    }
+    *data = loaded;
+    return FP_OK;
+}
+
+int g5_decision_store_remove(g5_decision_store_t* store, int sensor_type) {
+    char path[PATH_MAX];
+    int ret;
+    if (store == NULL) {
+        return FP_NULL_DATA;
+    }
+    ret = make_path(store, sensor_type, "", path);
+    if (ret != FP_OK) {
+        return ret;
+    }
+    return plat_remove_file(path) == PLAT_FILE_REMOVE_SUCCESS ? FP_OK : FP_ERR;
+}
+
+unsigned char* g5_decision_data_bytes(g5_decision_data_t* data, int* data_len) {
+    if (data == NULL) {
+        *data_len = 0;
+        return NULL;
+    }
+    *data_len = (int)(data->size - DECISION_STORE_HEADER_SIZE);
+    return data->base + DECISION_STORE_HEADER_SIZE;
+}
+
+int g5_decision_data_is_mapped(const g5_decision_data_t* data) {
+    return data != NULL && data->mapped;
+}
+
+void g5_decision_data_release(g5_decision_data_t* data) {
+    if (data == NULL) {
+        return;
+    }
+#ifdef _WIN32
+    if (data->base != NULL && data->mapped) {
+        UnmapViewOfFile(data->base);
+    }
+    if (data->mapping != NULL) {
+        CloseHandle(data->mapping);
+    }
+    if (data->file != NULL) {
+        CloseHandle(data->file);
+    }
+#else
+    if (data->base != NULL && data->mapped) {
+        munmap(data->base, data->size);
+    }
+#endif
+    if (!data->mapped) {
+        PLAT_FREE(data->base);
+    }
+    PLAT_FREE(data);
+}
@@ -0,0 +1,83 @@
+#ifndef G5_DECISION_STORE_H_
+#define G5_DECISION_STORE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Directory of G5 decision data, the learned state algorithm_uninitialization_v2 hands
+ * back and algorithm_initialization_v2 starts from, one file per sensor type, the key the
+ * G5 context is initialized with.
+ *
+ * A file holds a 64 byte header (magic, version, sensor type, data size and CRC-32 of the
+ * data) followed by the data, so a truncated or corrupt file, or one written for another
+ * sensor type, is rejected on load and the matcher starts cold. Files
+ * are written to a temporary name and renamed, a crash while saving keeps the old state.
+ *
+ * The data can be read into the heap or mapped copy-on-write: algorithm_initialization_v2
+ * takes non-const data, writes to the mapping stay private to the process and never
+ * reach the file.
+ */
+typedef struct g5_decision_store g5_decision_store_t;
+typedef struct g5_decision_data g5_decision_data_t;
+
+#define G5_DECISION_STORE_EXT ".g5d"
+/** Largest decision data accepted on load. */
+#define G5_DECISION_STORE_MAX_SIZE (64 * 1024 * 1024)
+
+/**
+ * g5_decision_store_open
+ *
+ * @param dir
+ *  existing directory to store the decision data in.
+ * @return
+ *  the store, or NULL on failure.
+ */
+g5_decision_store_t* g5_decision_store_open(const char* dir);
+
+void g5_decision_store_close(g5_decision_store_t* store);
+
+/**
+ * Write the decision data of sensor_type, replacing any previous one. The file must not
+ * be mapped by g5_decision_store_get() meanwhile.
+ *
+ * @return
+ *  FP_OK or an FP_* error code.
+ */
+int g5_decision_store_put(g5_decision_store_t* store, int sensor_type,
+                          const unsigned char* data, int data_len);
+
+/**
+ * Load the decision data of sensor_type.
+ *
+ * @param map
+ *  map the file instead of reading it into the heap.
+ * @param data
+ *  set to the loaded data, released with g5_decision_data_release().
+ * @return
+ *  FP_OK, FP_NULL_DATA if there is no decision data for the key, FP_INVALID_FORMAT if
+ *  the file is not valid for the key, or an FP_* error code.
+ */
+int g5_decision_store_get(g5_decision_store_t* store, int sensor_type, int map,
+                          g5_decision_data_t** data);
+
+int g5_decision_store_remove(g5_decision_store_t* store, int sensor_type);
+
+/**
+ * @return
+ *  the decision data, valid until g5_decision_data_release(). Non-const as
+ *  algorithm_initialization_v2 takes it so.
+ */
+unsigned char* g5_decision_data_bytes(g5_decision_data_t* data, int* data_len);
+
+/** @return non-zero if the data is a mapping of the file. */
+int g5_decision_data_is_mapped(const g5_decision_data_t* data);
+
+void g5_decision_data_release(g5_decision_data_t* data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,262 @@
+typedef unsigned char BYTE;
+#include "g5_enroll.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "EgisAlgorithmApiV2.h"
+#include "pb_timestamp.h"
+#include "plat_log.h"
+#include "plat_thread.h"
+
+#ifndef plat_alloc
+#define plat_alloc(fmt) malloc(fmt)
+#endif
+
+#ifndef PLAT_FREE
+#define PLAT_FREE(x) \
+    if (x != NULL) { \
+        free(x);     \
+        x = NULL;    \
+    }
+#endif
+
+#define ENROLL_MAX_THREADS 256
+
+typedef struct enroll_job {
+    const g5_enroll_user_t* users;
+    int nbr_of_users;
+    int w;
+    int h;
+    struct algo_info* algo_info;
+    g5_template_store_t* store;
+    g5_enroll_result_t* result;
+    int next_user;
+    mutex_handle_t user_mutex;
+} enroll_job_t;
+
+typedef struct enroll_worker {
+    enroll_job_t* job;
+    int index;
+    thread_handle_t thread;
+    thread_param_t param;
+} enroll_worker_t;
+
+static long elapsed_us(const pb_timestamp_t* start, const pb_timestamp_t* end) {
+    return (end->sec - start->sec) * 1000000L + (end->usec - start->usec);
+}
+
+static int next_user(enroll_job_t* job) {
+    int user = -1;
+    plat_mutex_lock(job->user_mutex);
+    if (job->next_user < job->nbr_of_users) {
+        user = job->next_user++;
+    }
+    plat_mutex_unlock(job->user_mutex);
+    return user;
+}
+
+static void enroll_user(g5_matcher_t* matcher, enroll_job_t* job, int index) {
+    const g5_enroll_user_t* user = &job->users[index];
+    g5_enroll_user_result_t* user_result = &job->result->users[index];
+    g5_enroll_progress_t progress = {0};
+    unsigned char* temp = NULL;
+    int temp_size = 0;
+    pb_timestamp_t start, image_start, end;
+    int i, status;
+
+    pb_timestamp_now(&start);
+    status = g5_matcher_enroll_begin(matcher);
+    if (status != FP_OK) {
+        user_result->status = status;
+        return;
+    }
+    for (i = 0; i < user->nbr_of_images; i++) {
+        pb_timestamp_now(&image_start);
+        status = g5_matcher_enroll_add(matcher, user->images[i], job->w, job->h, &progress);
+        pb_timestamp_now(&end);
+        user_result->image_latency_us[i] = elapsed_us(&image_start, &end);
+        user_result->nbr_of_used++;
+        if (status != FP_OK) {
+            // A rejected image is skipped, the next one may still be accepted
+            ex_log(LOG_ERROR, "enroll %s: image %d rejected (%d)", user->id, i, status);
+        }
+        if (progress.percentage >= 100) {
+            break;
+        }
+    }
+    status = g5_matcher_enroll_finish(matcher, &temp, &temp_size);
+    pb_timestamp_now(&end);
+    user_result->latency_us = elapsed_us(&start, &end);
+    user_result->percentage = progress.percentage;
+    user_result->nbr_of_added = progress.count;
+    if (status != FP_OK) {
+        user_result->status = status;
+        return;
+    }
+    user_result->template_size = temp_size;
+
+    if (job->store != NULL) {
+        pb_timestamp_now(&start);
+        status = g5_template_store_put(job->store, user->id, temp, temp_size);
+        pb_timestamp_now(&end);
+        user_result->store_latency_us = elapsed_us(&start, &end);
+    }
+    user_result->status = status;
+    g5_matcher_free_template(temp);
+}
+
+static int enroll_worker_routine(void* arg) {
+    enroll_worker_t* worker = (enroll_worker_t*)((thread_param_t*)arg)->params;
+    enroll_job_t* job = worker->job;
+    int index;
+
+    g5_matcher_t* matcher = g5_matcher_create(job->algo_info);
+    if (matcher == NULL) {
+        ex_log(LOG_ERROR, "enroll worker %d: g5_matcher_create failed", worker->index);
+        return FP_ERR;
+    }
+    while ((index = next_user(job)) >= 0) {
+        enroll_user(matcher, job, index);
+        job->result->users_per_worker[worker->index]++;
+    }
+    g5_matcher_destroy(matcher);
+    return FP_OK;
+}
+
+static int result_alloc(g5_enroll_result_t* result, const g5_enroll_user_t* users,
+                        int nbr_of_users, int nbr_of_workers) {
+    long* image_latency;
+    int nbr_of_images = 0;
+    int i;
+
+    memset(result, 0, sizeof(g5_enroll_result_t));
+    for (i = 0; i < nbr_of_users; i++) {
+        nbr_of_images += users[i].nbr_of_images > 0 ? users[i].nbr_of_images : 0;
+    }
+    result->users =
+        (g5_enroll_user_result_t*)plat_alloc(nbr_of_users * sizeof(g5_enroll_user_result_t));
+    result->users_per_worker = (int*)plat_alloc(nbr_of_workers * sizeof(int));
+    // One latency block for all users, users[0].image_latency_us owns it
+    image_latency = (long*)plat_alloc((nbr_of_images > 0 ? nbr_of_images : 1) * sizeof(long));
+    if (result->users == NULL || result->users_per_worker == NULL || image_latency == NULL) {
+        // Freed here, users[0] does not own image_latency yet
+        PLAT_FREE(image_latency);
+        PLAT_FREE(result->users);
+        PLAT_FREE(result->users_per_worker);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    memset(result->users, 0, nbr_of_users * sizeof(g5_enroll_user_result_t));
+    memset(result->users_per_worker, 0, nbr_of_workers * sizeof(int));
+    memset(image_latency, 0, (nbr_of_images > 0 ? nbr_of_images : 1) * sizeof(long));
+    for (i = 0; i < nbr_of_users; i++) {
+        result->users[i].status = FP_STATE_ERR;  // until a worker has processed the user
+        result->users[i].image_latency_us = image_latency;
+        image_latency += users[i].nbr_of_images > 0 ? users[i].nbr_of_images : 0;
+    }
+    result->nbr_of_users = nbr_of_users;
+    result->nbr_of_workers = nbr_of_workers;
+    return FP_OK;
+}
+
+int g5_enroll_run(const g5_enroll_user_t* users, int nbr_of_users, int w, int h,
+                  struct algo_info* algo_info, int nbr_of_threads, g5_template_store_t* store,
+                  g5_enroll_result_t* result) {
+    enroll_job_t job;
+    enroll_worker_t* workers;
+    int nbr_of_started = 0;
+    int nbr_of_processed = 0;
+    int ret;
+    int i;
+
+    if (users == NULL || result == NULL || nbr_of_users <= 0) {
+        return FP_NULL_DATA;
+    }
+    for (i = 0; i < nbr_of_users; i++) {
+        if (users[i].id == NULL || (users[i].images == NULL && users[i].nbr_of_images > 0)) {
+            return FP_NULL_DATA;
+        }
+    }
+    if (nbr_of_threads <= 0) {
+        nbr_of_threads = 1;
+    }
+    if (nbr_of_threads > ENROLL_MAX_THREADS) {
+        nbr_of_threads = ENROLL_MAX_THREADS;
+    }
+    if (nbr_of_threads > nbr_of_users) {
+        nbr_of_threads = nbr_of_users;
+    }
+    ret = result_alloc(result, users, nbr_of_users, nbr_of_threads);
+    if (ret != FP_OK) {
+        return ret;
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.users = users;
+    job.nbr_of_users = nbr_of_users;
+    job.w = w;
+    job.h = h;
+    job.algo_info = algo_info;
+    job.store = store;
+    job.result = result;
+    if (plat_mutex_create(&job.user_mutex) != THREAD_RES_OK) {
+        g5_enroll_result_free(result);
+        return FP_ERR;
+    }
+
+    workers = (enroll_worker_t*)plat_alloc(nbr_of_threads * sizeof(enroll_worker_t));
+    if (workers == NULL) {
+        plat_mutex_release(&job.user_mutex);
+        g5_enroll_result_free(result);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    memset(workers, 0, nbr_of_threads * sizeof(enroll_worker_t));
+
+    for (i = 0; i < nbr_of_threads; i++) {
+        workers[i].job = &job;
+        workers[i].index = i;
+        workers[i].param.params = &workers[i];
+        if (plat_thread_create_ex(&workers[i].thread, (void*)enroll_worker_routine,
+                                  &workers[i].param) != THREAD_RES_OK) {
+            break;
+        }
+        nbr_of_started++;
+    }
+    if (nbr_of_started < nbr_of_threads) {
+        // The threads already running pick up the remaining users
+        ex_log(LOG_ERROR, "g5_enroll_run: only %d of %d workers started", nbr_of_started,
+               nbr_of_threads);
+    }
+    for (i = 0; i < nbr_of_started; i++) {
+        plat_thread_release(&workers[i].thread);
+    }
+
+    for (i = 0; i < nbr_of_threads; i++) {
+        nbr_of_processed += result->users_per_worker[i];
+    }
+    for (i = 0; i < nbr_of_users; i++) {
+        if (result->users[i].status == FP_OK) {
+            result->nbr_of_enrolled++;
+        } else {
+            result->nbr_of_errors++;
+        }
+    }
+    // Users are left over only if every worker failed to create its matcher
+    ret = nbr_of_processed == nbr_of_users ? FP_OK : FP_ERR;
+
+    PLAT_FREE(workers);
+    plat_mutex_release(&job.user_mutex);
+    return ret;
+}
+
+void g5_enroll_result_free(g5_enroll_result_t* result) {
+    if (result == NULL) {
+        return;
+    }
+    if (result->users != NULL && result->nbr_of_users > 0) {
+        PLAT_FREE(result->users[0].image_latency_us);
+    }
+    PLAT_FREE(result->users);
+    PLAT_FREE(result->users_per_worker);
+    memset(result, 0, sizeof(g5_enroll_result_t));
+}
@@ -0,0 +1,75 @@
+#ifndef G5_ENROLL_H_
+#define G5_ENROLL_H_
+
+#include "g5_match.h"
+#include "g5_template_store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Batch enrollment.
+ *
+ * Users are enrolled in parallel, each worker owning a g5_matcher_t and thereby its
+ * own G5 context. A user's images are added with enroll_v2 until the multitemplate
+ * is complete (g_max_enroll_count images) or the images run out, then the
+ * multitemplate is written to the template store.
+ */
+
+typedef struct g5_enroll_user {
+    const char* id;  // template store key
+    unsigned char** images;
+    int nbr_of_images;
+} g5_enroll_user_t;
+
+typedef struct g5_enroll_user_result {
+    int status;  // FP_OK when the multitemplate was stored
+    int percentage;
+    int nbr_of_added;   // images added to the multitemplate
+    int nbr_of_used;    // images passed to enroll_v2, the rest were not needed
+    int template_size;
+    long latency_us;        // enroll_init_v2 up to get_enroll_template_v2
+    long store_latency_us;  // writing the template to the store
+    /** enroll_v2 latency of each image, nbr_of_images entries, 0 for unused images. */
+    long* image_latency_us;
+} g5_enroll_user_result_t;
+
+typedef struct g5_enroll_result {
+    g5_enroll_user_result_t* users;  // in the order of the users passed in
+    int nbr_of_users;
+    int nbr_of_enrolled;
+    int nbr_of_errors;
+    /** Number of users enrolled by each worker thread. */
+    int* users_per_worker;
+    int nbr_of_workers;
+} g5_enroll_result_t;
+
+/**
+ * g5_enroll_run
+ *
+ * @param users
+ *  users with w x h 8-bit images.
+ * @param algo_info
+ *  matcher configuration for every worker, NULL for the defaults.
+ * @param nbr_of_threads
+ *  number of worker threads, <= 0 for one.
+ * @param store
+ *  receives the multitemplates, may be NULL to only measure the enrollment.
+ * @param result
+ *  receives the per user results, free with g5_enroll_result_free().
+ * @return
+ *  FP_OK when every user was processed (see the per user status), or an FP_* error
+ *  code.
+ */
+int g5_enroll_run(const g5_enroll_user_t* users, int nbr_of_users, int w, int h,
+                  struct algo_info* algo_info, int nbr_of_threads, g5_template_store_t* store,
+                  g5_enroll_result_t* result);
+
+void g5_enroll_result_free(g5_enroll_result_t* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
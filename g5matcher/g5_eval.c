@@ -0,0 +1,383 @@
+typedef unsigned char BYTE;
+#include "g5_eval.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "EgisAlgorithmApiV2.h"
+#include "plat_log.h"
+#include "plat_thread.h"
+
+#ifndef plat_alloc
+#define plat_alloc(fmt) malloc(fmt)
+#endif
+
+#ifndef PLAT_FREE
+#define PLAT_FREE(x) \
+    if (x != NULL) { \
+        free(x);     \
+        x = NULL;    \
+    }
+#endif
+
+#define EVAL_MAX_THREADS 256
+// Pairs handed out to a worker at a time
+#define EVAL_BLOCK_PAIRS 64
+
+typedef struct eval_job {
+    const g5_eval_sample_t* samples;
+    int w;
+    int h;
+    const g5_eval_pair_t* pairs;
+    int nbr_of_pairs;
+    struct algo_info* algo_info;
+    g5_template_cache_t* cache;
+    int next_pair;
+    mutex_handle_t pair_mutex;
+} eval_job_t;
+
+typedef struct eval_worker {
+    eval_job_t* job;
+    int index;
+    thread_handle_t thread;
+    thread_param_t param;
+    g5_eval_result_t stats;  // thread-local histograms
+} eval_worker_t;
+
+// Sort key of a sample, samples of the same finger end up next to each other
+typedef struct eval_sample_key {
+    int person;
+    int finger;
+    int sample;
+    int index;
+} eval_sample_key_t;
+
+static int same_finger(const eval_sample_key_t* a, const eval_sample_key_t* b) {
+    return a->person == b->person && a->finger == b->finger;
+}
+
+static int compare_sample_key(const void* a, const void* b) {
+    const eval_sample_key_t* ka = (const eval_sample_key_t*)a;
+    const eval_sample_key_t* kb = (const eval_sample_key_t*)b;
+    if (ka->person != kb->person) {
+        return ka->person < kb->person ? -1 : 1;
+    }
+    if (ka->finger != kb->finger) {
+        return ka->finger < kb->finger ? -1 : 1;
+    }
+    if (ka->sample != kb->sample) {
+        return ka->sample < kb->sample ? -1 : 1;
+    }
+    return ka->index < kb->index ? -1 : 1;
+}
+
+static int add_pair(g5_eval_pair_t** pairs, int* nbr_of_pairs, int* capacity, int enroll,
+                    int verify, int genuine) {
+    if (*nbr_of_pairs == *capacity) {
+        int new_capacity = *capacity > 0 ? *capacity * 2 : 1024;
+        g5_eval_pair_t* new_pairs =
+            (g5_eval_pair_t*)realloc(*pairs, new_capacity * sizeof(g5_eval_pair_t));
+        if (new_pairs == NULL) {
+            return FP_ALLOC_MEM_FAIL;
+        }
+        *pairs = new_pairs;
+        *capacity = new_capacity;
+    }
+    (*pairs)[*nbr_of_pairs].enroll = enroll;
+    (*pairs)[*nbr_of_pairs].verify = verify;
+    (*pairs)[*nbr_of_pairs].genuine = genuine;
+    (*nbr_of_pairs)++;
+    return FP_OK;
+}
+
+int g5_eval_create_protocol(const g5_eval_sample_t* samples, int nbr_of_samples,
+                            g5_eval_impostor_protocol_t impostor_protocol,
+                            g5_eval_pair_t** pairs, int* nbr_of_pairs) {
+    eval_sample_key_t* order;
+    int capacity = 0;
+    int ret = FP_OK;
+    int i, j;
+
+    if (samples == NULL || pairs == NULL || nbr_of_pairs == NULL || nbr_of_samples <= 0) {
+        return FP_NULL_DATA;
+    }
+    *pairs = NULL;
+    *nbr_of_pairs = 0;
+
+    // Group the samples by finger, ordered by sample number
+    order = (eval_sample_key_t*)plat_alloc(nbr_of_samples * sizeof(eval_sample_key_t));
+    if (order == NULL) {
+        return FP_ALLOC_MEM_FAIL;
+    }
+    for (i = 0; i < nbr_of_samples; i++) {
+        order[i].person = samples[i].person;
+        order[i].finger = samples[i].finger;
+        order[i].sample = samples[i].sample;
+        order[i].index = i;
+    }
+    qsort(order, nbr_of_samples, sizeof(eval_sample_key_t), compare_sample_key);
+
+    // Genuine: all pairs within a finger
+    for (i = 0; i < nbr_of_samples && ret == FP_OK; i++) {
+        for (j = i + 1; j < nbr_of_samples && ret == FP_OK; j++) {
+            if (!same_finger(&order[i], &order[j])) {
+                break;
+            }
+            ret = add_pair(pairs, nbr_of_pairs, &capacity, order[i].index, order[j].index, 1);
+        }
+    }
+
+    // Impostor: pairs across fingers
+    for (i = 0; i < nbr_of_samples && ret == FP_OK; i++) {
+        if (impostor_protocol == G5_EVAL_IMPOSTOR_FIRST_SAMPLE && i > 0 &&
+            same_finger(&order[i - 1], &order[i])) {
+            continue;
+        }
+        for (j = i + 1; j < nbr_of_samples && ret == FP_OK; j++) {
+            if (same_finger(&order[i], &order[j])) {
+                continue;
+            }
+            if (impostor_protocol == G5_EVAL_IMPOSTOR_FIRST_SAMPLE &&
+                same_finger(&order[j - 1], &order[j])) {
+                continue;
+            }
+            ret = add_pair(pairs, nbr_of_pairs, &capacity, order[i].index, order[j].index, 0);
+        }
+    }
+
+    PLAT_FREE(order);
+    if (ret != FP_OK) {
+        PLAT_FREE(*pairs);
+        *nbr_of_pairs = 0;
+    }
+    return ret;
+}
+
+void g5_eval_free_protocol(g5_eval_pair_t* pairs) {
+    PLAT_FREE(pairs);
+}
+
+static int result_alloc(g5_eval_result_t* result) {
+    memset(result, 0, sizeof(g5_eval_result_t));
+    result->genuine_stats =
+        (pb_comparison_mode_stats_t*)plat_alloc(sizeof(pb_comparison_mode_stats_t));
+    result->impostor_stats =
+        (pb_comparison_mode_stats_t*)plat_alloc(sizeof(pb_comparison_mode_stats_t));
+    if (result->genuine_stats == NULL || result->impostor_stats == NULL) {
+        g5_eval_result_free(result);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    memset(result->genuine_stats, 0, sizeof(pb_comparison_mode_stats_t));
+    memset(result->impostor_stats, 0, sizeof(pb_comparison_mode_stats_t));
+    return FP_OK;
+}
+
+static void result_merge(g5_eval_result_t* result, const g5_eval_result_t* part) {
+    int32_t* genuine = result->genuine_stats->score_histogram;
+    int32_t* impostor = result->impostor_stats->score_histogram;
+    int i;
+    for (i = 0; i < PB_COMPARISON_MODE_HISTOGRAM_LENGTH; i++) {
+        genuine[i] += part->genuine_stats->score_histogram[i];
+        impostor[i] += part->impostor_stats->score_histogram[i];
+    }
+    result->nbr_of_genuine += part->nbr_of_genuine;
+    result->nbr_of_impostor += part->nbr_of_impostor;
+    result->nbr_of_errors += part->nbr_of_errors;
+}
+
+// Returns the first pair of the next block, or -1 when all pairs are taken
+static int next_block(eval_job_t* job) {
+    int first = -1;
+    plat_mutex_lock(job->pair_mutex);
+    if (job->next_pair < job->nbr_of_pairs) {
+        first = job->next_pair;
+        job->next_pair += EVAL_BLOCK_PAIRS;
+    }
+    plat_mutex_unlock(job->pair_mutex);
+    return first;
+}
+
+static int eval_worker_routine(void* arg) {
+    eval_worker_t* worker = (eval_worker_t*)((thread_param_t*)arg)->params;
+    eval_job_t* job = worker->job;
+    g5_eval_result_t* stats = &worker->stats;
+    int first;
+
+    g5_matcher_t* matcher = g5_matcher_create(job->algo_info);
+    if (matcher == NULL) {
+        ex_log(LOG_ERROR, "eval worker %d: g5_matcher_create failed", worker->index);
+        return FP_ERR;
+    }
+    g5_matcher_set_template_cache(matcher, job->cache);
+
+    while ((first = next_block(job)) >= 0) {
+        int end = first + EVAL_BLOCK_PAIRS;
+        int i;
+        if (end > job->nbr_of_pairs) {
+            end = job->nbr_of_pairs;
+        }
+        for (i = first; i < end; i++) {
+            const g5_eval_pair_t* pair = &job->pairs[i];
+            int score = 0, rot = 0, dx = 0, dy = 0;
+            int status = g5_matcher_compare(matcher, job->samples[pair->enroll].image,
+                                            job->samples[pair->verify].image, job->w, job->h,
+                                            &score, &rot, &dx, &dy);
+            if (status != FP_MATCHOK && status != FP_MATCHFAIL && status != FP_OK) {
+                stats->nbr_of_errors++;
+                continue;
+            }
+            if (score < 0) {
+                score = 0;
+            } else if (score >= PB_COMPARISON_MODE_HISTOGRAM_LENGTH) {
+                score = PB_COMPARISON_MODE_HISTOGRAM_LENGTH - 1;
+            }
+            if (pair->genuine) {
+                stats->genuine_stats->score_histogram[score]++;
+                stats->nbr_of_genuine++;
+            } else {
+                stats->impostor_stats->score_histogram[score]++;
+                stats->nbr_of_impostor++;
+            }
+        }
+    }
+
+    g5_matcher_destroy(matcher);
+    return FP_OK;
+}
+
+int g5_eval_run(const g5_eval_sample_t* samples, int w, int h, const g5_eval_pair_t* pairs,
+                int nbr_of_pairs, struct algo_info* algo_info, int nbr_of_threads,
+                g5_template_cache_t* cache, g5_eval_result_t* result) {
+    eval_job_t job;
+    eval_worker_t* workers;
+    int nbr_of_started = 0;
+    int ret = FP_OK;
+    int i;
+
+    if (samples == NULL || pairs == NULL || result == NULL || nbr_of_pairs <= 0) {
+        return FP_NULL_DATA;
+    }
+    if (nbr_of_threads <= 0) {
+        nbr_of_threads = 1;
+    }
+    if (nbr_of_threads > EVAL_MAX_THREADS) {
+        nbr_of_threads = EVAL_MAX_THREADS;
+    }
+    ret = result_alloc(result);
+    if (ret != FP_OK) {
+        return ret;
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.samples = samples;
+    job.w = w;
+    job.h = h;
+    job.pairs = pairs;
+    job.nbr_of_pairs = nbr_of_pairs;
+    job.algo_info = algo_info;
+    job.cache = cache;
+    if (plat_mutex_create(&job.pair_mutex) != THREAD_RES_OK) {
+        g5_eval_result_free(result);
+        return FP_ERR;
+    }
+
+    workers = (eval_worker_t*)plat_alloc(nbr_of_threads * sizeof(eval_worker_t));
+    if (workers == NULL) {
+        plat_mutex_release(&job.pair_mutex);
+        g5_eval_result_free(result);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    memset(workers, 0, nbr_of_threads * sizeof(eval_worker_t));
+
+    for (i = 0; i < nbr_of_threads; i++) {
+        workers[i].job = &job;
+        workers[i].index = i;
+        workers[i].param.params = &workers[i];
+        if (result_alloc(&workers[i].stats) != FP_OK) {
+            break;
+        }
+        if (plat_thread_create_ex(&workers[i].thread, (void*)eval_worker_routine,
+                                  &workers[i].param) != THREAD_RES_OK) {
+            g5_eval_result_free(&workers[i].stats);
+            break;
+        }
+        nbr_of_started++;
+    }
+    if (nbr_of_started < nbr_of_threads) {
+        // The threads already running pick up the remaining pairs
+        ex_log(LOG_ERROR, "g5_eval_run: only %d of %d workers started", nbr_of_started,
+               nbr_of_threads);
+    }
+
+    for (i = 0; i < nbr_of_started; i++) {
+        plat_thread_release(&workers[i].thread);
+        result_merge(result, &workers[i].stats);
+        g5_eval_result_free(&workers[i].stats);
+    }
+    // Pairs are left over only if every worker failed to create its matcher
+    if (result->nbr_of_genuine + result->nbr_of_impostor + result->nbr_of_errors != nbr_of_pairs) {
+        ret = FP_ERR;
+    }
+
+    PLAT_FREE(workers);
+    plat_mutex_release(&job.pair_mutex);
+    return ret;
+}
+
+void g5_eval_result_free(g5_eval_result_t* result) {
+    if (result == NULL) {
+        return;
+    }
+    PLAT_FREE(result->genuine_stats);
+    PLAT_FREE(result->impostor_stats);
+}
+
+// PB_FAR_X enumerates 1, 2, 5, 10, 20, 50, ... as 0, 1, 2, 3, 4, 5, ...
+int g5_eval_far_ratio(pb_far_t far) {
+    static const int steps[3] = {1, 2, 5};
+    int ratio = 1;
+    unsigned int i;
+    if (far >= PB_FAR_Inf) {
+        far = PB_FAR_1000M;
+    }
+    for (i = 0; i < far / 3; i++) {
+        ratio *= 10;
+    }
+    return ratio * steps[far % 3];
+}
+
+int g5_eval_frr_at_far(const g5_eval_result_t* result, pb_far_t far, int* threshold) {
+    return g5_eval_frr_at_far_ratio(result, g5_eval_far_ratio(far), threshold);
+}
+
+int g5_eval_frr_at_far_ratio(const g5_eval_result_t* result, int far_ratio, int* threshold) {
+    const int32_t* genuine;
+    const int32_t* impostor;
+    unsigned long long ratio = (unsigned long long)(far_ratio > 0 ? far_ratio : 1);
+    unsigned long long accepted = 0;
+    long long rejected = 0;
+    int t = PB_COMPARISON_MODE_HISTOGRAM_LENGTH;
+    int s;
+
+    if (result == NULL || result->genuine_stats == NULL || result->nbr_of_genuine <= 0) {
+        return -1;
+    }
+    genuine = result->genuine_stats->score_histogram;
+    impostor = result->impostor_stats->score_histogram;
+
+    // Lowest threshold whose impostor accept rate stays within 1/ratio
+    for (s = PB_COMPARISON_MODE_HISTOGRAM_LENGTH - 1; s >= 0; s--) {
+        if ((accepted + impostor[s]) * ratio > (unsigned long long)result->nbr_of_impostor) {
+            break;
+        }
+        accepted += impostor[s];
+        t = s;
+    }
+    for (s = 0; s < t; s++) {
+        rejected += genuine[s];
+    }
+    if (threshold != NULL) {
+        *threshold = t;
+    }
+    return (int)((rejected * 10000 + result->nbr_of_genuine / 2) / result->nbr_of_genuine);
+}
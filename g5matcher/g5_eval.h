@@ -0,0 +1,119 @@
+#ifndef G5_EVAL_H_
+#define G5_EVAL_H_
+
+#include "g5_match.h"
+#include "pb_algorithm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Genuine / impostor evaluation.
+ *
+ * A dataset is a list of samples identified by person, finger and sample number. A
+ * protocol lists the comparisons to run, g5_eval_run() runs them on a worker pool
+ * and collects the scores into genuine and impostor histograms shaped like
+ * pb_comparison_mode_stats_t, from which FRR at a given FAR is read.
+ */
+
+typedef struct g5_eval_sample {
+    int person;
+    int finger;
+    int sample;
+    unsigned char* image;
+} g5_eval_sample_t;
+
+typedef enum g5_eval_impostor_protocol {
+    /** First sample of each finger against the first sample of every other finger. */
+    G5_EVAL_IMPOSTOR_FIRST_SAMPLE,
+    /** Every sample against every sample of every other finger. */
+    G5_EVAL_IMPOSTOR_ALL,
+} g5_eval_impostor_protocol_t;
+
+typedef struct g5_eval_pair {
+    int enroll;  // sample index
+    int verify;  // sample index
+    int genuine;
+} g5_eval_pair_t;
+
+typedef struct g5_eval_result {
+    pb_comparison_mode_stats_t* genuine_stats;
+    pb_comparison_mode_stats_t* impostor_stats;
+    int nbr_of_genuine;
+    int nbr_of_impostor;
+    int nbr_of_errors;  // comparisons that returned an error, not in the histograms
+} g5_eval_result_t;
+
+/**
+ * g5_eval_create_protocol
+ *
+ * Genuine pairs are all sample pairs (lower sample number enrolled) of the same
+ * person and finger. Different fingers of the same person are impostors.
+ *
+ * @param pairs
+ *  receives the pair list, genuine pairs first. Free with g5_eval_free_protocol().
+ * @return
+ *  FP_OK or an FP_* error code.
+ */
+int g5_eval_create_protocol(const g5_eval_sample_t* samples, int nbr_of_samples,
+                            g5_eval_impostor_protocol_t impostor_protocol,
+                            g5_eval_pair_t** pairs, int* nbr_of_pairs);
+
+void g5_eval_free_protocol(g5_eval_pair_t* pairs);
+
+/**
+ * g5_eval_run
+ *
+ * Compare all pairs with nbr_of_threads workers. Each worker owns a g5_matcher_t and
+ * its own histograms, which are merged into result when all workers are done.
+ *
+ * @param samples
+ *  w x h 8-bit images indexed by the pairs.
+ * @param algo_info
+ *  matcher configuration, NULL keeps the defaults.
+ * @param cache
+ *  optional template cache shared by the workers, lets every image be extracted once.
+ * @param result
+ *  receives the histograms, free with g5_eval_result_free().
+ * @return
+ *  FP_OK or an FP_* error code.
+ */
+int g5_eval_run(const g5_eval_sample_t* samples, int w, int h, const g5_eval_pair_t* pairs,
+                int nbr_of_pairs, struct algo_info* algo_info, int nbr_of_threads,
+                g5_template_cache_t* cache, g5_eval_result_t* result);
+
+void g5_eval_result_free(g5_eval_result_t* result);
+
+/**
+ * @return
+ *  X of the FAR 1/X that PB_FAR_X stands for.
+ */
+int g5_eval_far_ratio(pb_far_t far);
+
+/**
+ * FRR at far, with the score threshold taken from the impostor histogram (a pair is
+ * accepted when score >= threshold). The FRR is represented with 2 decimal digits
+ * like pb_comparison_mode_stats_get_frr_at_far(), that is, 459 is 4.59%.
+ *
+ * Below nbr_of_impostor = X the FAR cannot be resolved and the threshold only
+ * rejects all seen impostors.
+ *
+ * @param threshold
+ *  receives the threshold, may be NULL.
+ * @return
+ *  the FRR, or -1 without genuine scores.
+ */
+int g5_eval_frr_at_far(const g5_eval_result_t* result, pb_far_t far, int* threshold);
+
+/**
+ * g5_eval_frr_at_far() for an arbitrary FAR 1/far_ratio, e.g. the FAR ratio a model
+ * configures with set_accuracy_level_v2.
+ */
+int g5_eval_frr_at_far_ratio(const g5_eval_result_t* result, int far_ratio, int* threshold);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
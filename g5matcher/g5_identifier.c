@@ -0,0 +1,537 @@
+typedef unsigned char BYTE;
+#include "g5_identifier.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "EgisAlgorithmApiV2.h"
+#include "g5_eval.h"
+#include "pb_alignment.h"
+#include "pb_finger.h"
+#include "pb_template.h"
+#include "plat_log.h"
+#include "plat_thread.h"
+
+#ifndef plat_alloc
+#define plat_alloc(fmt) malloc(fmt)
+#endif
+
+#ifndef PLAT_FREE
+#define PLAT_FREE(x) \
+    if (x != NULL) { \
+        free(x);     \
+        x = NULL;    \
+    }
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#define IDENTIFIER_MAX_SCORE 0xFFFF
+
+typedef struct identifier_candidate {
+    int index;
+    int score;
+    int rot;
+    int dx;
+    int dy;
+} identifier_candidate_t;
+
+struct identifier_context;
+
+typedef struct identifier_worker {
+    struct identifier_context* context;
+    int index;
+    g5_matcher_t* matcher;
+    thread_handle_t thread;
+    thread_param_t param;
+    semaphore_handle_t start;
+    identifier_candidate_t* candidates;  // best first
+    int nbr_of_candidates;
+    int max_candidates;
+} identifier_worker_t;
+
+typedef struct identifier_context {
+    mutex_handle_t mutex;  // one call at a time
+    identifier_worker_t* workers;
+    int nbr_of_workers;
+    semaphore_handle_t done;
+    int quit;
+
+    // enrolled gallery
+    pb_template_t** templates;
+    pb_finger_t** fingers;
+    void** references;
+    int nbr_of_templates;
+    int capacity;
+
+    // current identification
+    const unsigned char* probe;
+    int probe_size;
+    const pb_finger_t* filter;
+    int rank;
+    int accepted_only;
+    int far_ratio;
+} identifier_context_t;
+
+// Binary radians [0, 255] from the degrees [-180, 180] of g5_matcher_verify_templates
+static uint8_t rotation_from_degrees(int rot) {
+    return (uint8_t)(((rot + 360) % 360) * 256 / 360);
+}
+
+static int finger_in_filter(const pb_finger_t* finger, const pb_finger_t* filter) {
+    if (filter == NULL) {
+        return TRUE;
+    }
+    if (pb_finger_get_user_id(finger) != pb_finger_get_user_id(filter)) {
+        return FALSE;
+    }
+    return pb_finger_get_position(filter) == PB_FINGER_POSITION_UNKNOWN ||
+           pb_finger_get_position(filter) == pb_finger_get_position(finger);
+}
+
+// Insert into the best-first list, keeping at most rank candidates
+static void candidate_insert(identifier_candidate_t* list, int* count, int rank,
+                             const identifier_candidate_t* candidate) {
+    int i = *count;
+    if (i == rank) {
+        if (list[rank - 1].score >= candidate->score) {
+            return;
+        }
+        i = rank - 1;
+    } else {
+        (*count)++;
+    }
+    while (i > 0 && list[i - 1].score < candidate->score) {
+        list[i] = list[i - 1];
+        i--;
+    }
+    list[i] = *candidate;
+}
+
+// Match the probe against the worker's share of the gallery
+static void identifier_scan(identifier_worker_t* worker) {
+    identifier_context_t* context = worker->context;
+    int nbr_of_workers = context->nbr_of_workers;
+    int share = (context->nbr_of_templates + nbr_of_workers - 1) / nbr_of_workers;
+    int i = worker->index * share;
+    int end = i + share;
+    if (end > context->nbr_of_templates) {
+        end = context->nbr_of_templates;
+    }
+
+    worker->nbr_of_candidates = 0;
+    if (context->accepted_only) {
+        g5_matcher_set_far_ratio(worker->matcher, context->far_ratio);
+    }
+    for (; i < end; i++) {
+        const pb_template_t* enrolled = context->templates[i];
+        identifier_candidate_t candidate;
+        int status;
+
+        if (!finger_in_filter(context->fingers[i], context->filter)) {
+            continue;
+        }
+        candidate.index = i;
+        status = g5_matcher_verify_templates(
+            worker->matcher, pb_template_get_data(enrolled), pb_template_get_data_size(enrolled),
+            context->probe, context->probe_size, &candidate.score, &candidate.rot, &candidate.dx,
+            &candidate.dy);
+        if (status != FP_MATCHOK && (context->accepted_only || status != FP_MATCHFAIL)) {
+            continue;
+        }
+        candidate_insert(worker->candidates, &worker->nbr_of_candidates, context->rank,
+                         &candidate);
+    }
+}
+
+static int identifier_worker_routine(void* arg) {
+    identifier_worker_t* worker = (identifier_worker_t*)((thread_param_t*)arg)->params;
+    identifier_context_t* context = worker->context;
+
+    for (;;) {
+        plat_semaphore_wait(worker->start, -1);
+        if (context->quit) {
+            break;
+        }
+        identifier_scan(worker);
+        plat_semaphore_post(context->done);
+    }
+    // On this thread, so that it releases the pb_malloc arena of the thread
+    g5_matcher_destroy(worker->matcher);
+    worker->matcher = NULL;
+    return 0;
+}
+
+/*
+ * Run the current identification on all workers and merge their candidates into
+ * merged (rank entries). Returns the number of merged candidates.
+ */
+static int identifier_run(identifier_context_t* context, identifier_candidate_t* merged) {
+    int count = 0;
+    int i, j;
+
+    for (i = 1; i < context->nbr_of_workers; i++) {
+        plat_semaphore_post(context->workers[i].start);
+    }
+    identifier_scan(&context->workers[0]);
+    for (i = 1; i < context->nbr_of_workers; i++) {
+        plat_semaphore_wait(context->done, -1);
+    }
+
+    for (i = 0; i < context->nbr_of_workers; i++) {
+        identifier_worker_t* worker = &context->workers[i];
+        for (j = 0; j < worker->nbr_of_candidates; j++) {
+            candidate_insert(merged, &count, context->rank, &worker->candidates[j]);
+        }
+    }
+    return count;
+}
+
+static pb_rc_t identifier_prepare(identifier_context_t* context, const pb_template_t* template_,
+                                  const pb_finger_t* filter, int rank) {
+    int i;
+    if (template_ == NULL || rank <= 0) {
+        return PB_RC_INVALID_PARAMETER;
+    }
+    if (pb_template_get_type(template_) != G5_TEMPLATE_TYPE) {
+        return PB_RC_WRONG_DATA_FORMAT;
+    }
+    for (i = 0; i < context->nbr_of_workers; i++) {
+        identifier_worker_t* worker = &context->workers[i];
+        if (worker->max_candidates >= rank) {
+            continue;
+        }
+        PLAT_FREE(worker->candidates);
+        worker->max_candidates = 0;
+        worker->candidates =
+            (identifier_candidate_t*)plat_alloc(rank * sizeof(identifier_candidate_t));
+        if (worker->candidates == NULL) {
+            return PB_RC_MEMORY_ALLOCATION_FAILED;
+        }
+        worker->max_candidates = rank;
+    }
+    context->probe = pb_template_get_data(template_);
+    context->probe_size = pb_template_get_data_size(template_);
+    context->filter = filter;
+    context->rank = rank;
+    return PB_RC_OK;
+}
+
+static pb_rc_t identifier_add_templates(pb_identifier_t* identifier, pb_template_t* templates[],
+                                        pb_finger_t* fingers[], void* references[],
+                                        uint16_t nbr_of_fingers) {
+    identifier_context_t* context = (identifier_context_t*)pb_identifier_get_context(identifier);
+    int i;
+
+    if (templates == NULL || fingers == NULL) {
+        return PB_RC_INVALID_PARAMETER;
+    }
+    for (i = 0; i < nbr_of_fingers; i++) {
+        if (templates[i] == NULL || fingers[i] == NULL ||
+            pb_template_get_type(templates[i]) != G5_TEMPLATE_TYPE) {
+            return PB_RC_WRONG_DATA_FORMAT;
+        }
+    }
+
+    plat_mutex_lock(context->mutex);
+    if (context->nbr_of_templates + nbr_of_fingers > context->capacity) {
+        int capacity = context->capacity > 0 ? context->capacity : 64;
+        pb_template_t** new_templates;
+        pb_finger_t** new_fingers;
+        void** new_references;
+        while (capacity < context->nbr_of_templates + nbr_of_fingers) {
+            capacity *= 2;
+        }
+        new_templates =
+            (pb_template_t**)realloc(context->templates, capacity * sizeof(pb_template_t*));
+        if (new_templates != NULL) {
+            context->templates = new_templates;
+        }
+        new_fingers = (pb_finger_t**)realloc(context->fingers, capacity * sizeof(pb_finger_t*));
+        if (new_fingers != NULL) {
+            context->fingers = new_fingers;
+        }
+        new_references = (void**)realloc(context->references, capacity * sizeof(void*));
+        if (new_references != NULL) {
+            context->references = new_references;
+        }
+        if (new_templates == NULL || new_fingers == NULL || new_references == NULL) {
+            plat_mutex_unlock(context->mutex);
+            return PB_RC_MEMORY_ALLOCATION_FAILED;
+        }
+        context->capacity = capacity;
+    }
+    for (i = 0; i < nbr_of_fingers; i++) {
+        int index = context->nbr_of_templates++;
+        context->templates[index] = pb_template_retain(templates[i]);
+        context->fingers[index] = pb_finger_retain(fingers[i]);
+        context->references[index] = references != NULL ? references[i] : NULL;
+    }
+    plat_mutex_unlock(context->mutex);
+    return PB_RC_OK;
+}
+
+static void identifier_remove_at(identifier_context_t* context, int index) {
+    int last = context->nbr_of_templates - 1;
+    pb_template_delete(context->templates[index]);
+    pb_finger_delete(context->fingers[index]);
+    memmove(&context->templates[index], &context->templates[index + 1],
+            (last - index) * sizeof(pb_template_t*));
+    memmove(&context->fingers[index], &context->fingers[index + 1],
+            (last - index) * sizeof(pb_finger_t*));
+    memmove(&context->references[index], &context->references[index + 1],
+            (last - index) * sizeof(void*));
+    context->nbr_of_templates = last;
+}
+
+static pb_rc_t identifier_remove_templates(pb_identifier_t* identifier,
+                                           const pb_finger_t* fingers[],
+                                           uint16_t nbr_of_fingers) {
+    identifier_context_t* context = (identifier_context_t*)pb_identifier_get_context(identifier);
+    int i, j;
+
+    if (fingers == NULL) {
+        return PB_RC_INVALID_PARAMETER;
+    }
+    plat_mutex_lock(context->mutex);
+    for (i = 0; i < nbr_of_fingers; i++) {
+        for (j = context->nbr_of_templates - 1; j >= 0; j--) {
+            if (pb_finger_is_copy(context->fingers[j], fingers[i])) {
+                identifier_remove_at(context, j);
+            }
+        }
+    }
+    plat_mutex_unlock(context->mutex);
+    return PB_RC_OK;
+}
+
+static void remove_all_templates(identifier_context_t* context) {
+    int i;
+    for (i = 0; i < context->nbr_of_templates; i++) {
+        pb_template_delete(context->templates[i]);
+        pb_finger_delete(context->fingers[i]);
+    }
+    context->nbr_of_templates = 0;
+}
+
+static pb_rc_t identifier_remove_all_templates(pb_identifier_t* identifier) {
+    identifier_context_t* context = (identifier_context_t*)pb_identifier_get_context(identifier);
+    plat_mutex_lock(context->mutex);
+    remove_all_templates(context);
+    plat_mutex_unlock(context->mutex);
+    return PB_RC_OK;
+}
+
+static pb_rc_t identifier_identify_template(pb_identifier_t* identifier,
+                                            const pb_template_t* template_,
+                                            const pb_finger_t* finger,
+                                            pb_fpir_t false_positive_identification_rate,
+                                            pb_finger_t** identified_finger, void** reference,
+                                            pb_alignment_t** alignment) {
+    identifier_context_t* context = (identifier_context_t*)pb_identifier_get_context(identifier);
+    identifier_candidate_t best;
+    pb_rc_t rc;
+
+    if (identified_finger == NULL) {
+        return PB_RC_INVALID_PARAMETER;
+    }
+    *identified_finger = NULL;
+    if (reference != NULL) {
+        *reference = NULL;
+    }
+    if (alignment != NULL) {
+        *alignment = NULL;
+    }
+
+    plat_mutex_lock(context->mutex);
+    rc = identifier_prepare(context, template_, finger, 1);
+    if (rc == PB_RC_OK) {
+        context->accepted_only = TRUE;
+        context->far_ratio = g5_eval_far_ratio(pb_identifier_fpir_to_far(
+            false_positive_identification_rate, context->nbr_of_templates));
+        if (identifier_run(context, &best) > 0) {
+            *identified_finger = pb_finger_retain(context->fingers[best.index]);
+            if (reference != NULL) {
+                *reference = context->references[best.index];
+            }
+            if (alignment != NULL) {
+                *alignment =
+                    pb_alignment_create(best.dx, best.dy, rotation_from_degrees(best.rot));
+            }
+        }
+    }
+    plat_mutex_unlock(context->mutex);
+    return rc;
+}
+
+static pb_rc_t identifier_identify_template_rank(pb_identifier_t* identifier,
+                                                 const pb_template_t* template_,
+                                                 const pb_finger_t* finger, uint8_t rank,
+                                                 pb_finger_t* identified_fingers[],
+                                                 uint16_t scores[], void* references[],
+                                                 pb_alignment_t* alignments[]) {
+    identifier_context_t* context = (identifier_context_t*)pb_identifier_get_context(identifier);
+    identifier_candidate_t* merged;
+    int count = 0;
+    int i;
+    pb_rc_t rc;
+
+    if (identified_fingers == NULL || rank == 0) {
+        return PB_RC_INVALID_PARAMETER;
+    }
+    merged = (identifier_candidate_t*)plat_alloc(rank * sizeof(identifier_candidate_t));
+    if (merged == NULL) {
+        return PB_RC_MEMORY_ALLOCATION_FAILED;
+    }
+
+    plat_mutex_lock(context->mutex);
+    rc = identifier_prepare(context, template_, finger, rank);
+    if (rc == PB_RC_OK) {
+        context->accepted_only = FALSE;
+        count = identifier_run(context, merged);
+    }
+    for (i = 0; i < rank; i++) {
+        const identifier_candidate_t* candidate = &merged[i];
+        int found = i < count;
+        int score = found ? candidate->score : 0;
+        if (score > IDENTIFIER_MAX_SCORE) {
+            score = IDENTIFIER_MAX_SCORE;
+        } else if (score < 0) {
+            score = 0;
+        }
+        identified_fingers[i] = found ? pb_finger_retain(context->fingers[candidate->index]) : NULL;
+        if (scores != NULL) {
+            scores[i] = (uint16_t)score;
+        }
+        if (references != NULL) {
+            references[i] = found ? context->references[candidate->index] : NULL;
+        }
+        if (alignments != NULL) {
+            alignments[i] = found ? pb_alignment_create(candidate->dx, candidate->dy,
+                                                        rotation_from_degrees(candidate->rot))
+                                  : NULL;
+        }
+    }
+    plat_mutex_unlock(context->mutex);
+
+    PLAT_FREE(merged);
+    return rc;
+}
+
+static pb_rc_t identifier_register_listener(pb_identifier_t* identifier,
+                                            pb_identifierI_listener_fn_t* listener,
+                                            const void* context) {
+    (void)identifier;
+    (void)listener;
+    (void)context;
+    return PB_RC_NOT_SUPPORTED;
+}
+
+static pb_rc_t identifier_unregister_listener(pb_identifier_t* identifier,
+                                              pb_identifierI_listener_fn_t* listener) {
+    (void)identifier;
+    (void)listener;
+    return PB_RC_NOT_SUPPORTED;
+}
+
+static const pb_identifier_functionsI g5_identifier_functions = {
+    identifier_add_templates,          identifier_remove_templates,
+    identifier_remove_all_templates,   identifier_identify_template,
+    identifier_identify_template_rank, identifier_register_listener,
+    identifier_unregister_listener,
+};
+
+static void identifier_delete_context(void* arg) {
+    identifier_context_t* context = (identifier_context_t*)arg;
+    int i;
+    if (context == NULL) {
+        return;
+    }
+
+    context->quit = TRUE;
+    for (i = 0; i < context->nbr_of_workers; i++) {
+        identifier_worker_t* worker = &context->workers[i];
+        if (worker->thread.hwin != NULL) {
+            plat_semaphore_post(worker->start);
+            plat_thread_release(&worker->thread);
+        }
+        if (worker->start.sema != NULL) {
+            plat_semaphore_release(&worker->start);
+        }
+        // Left by worker 0 and by workers whose thread did not start
+        g5_matcher_destroy(worker->matcher);
+        PLAT_FREE(worker->candidates);
+    }
+    PLAT_FREE(context->workers);
+    plat_semaphore_release(&context->done);
+    plat_mutex_release(&context->mutex);
+
+    remove_all_templates(context);
+    PLAT_FREE(context->templates);
+    PLAT_FREE(context->fingers);
+    PLAT_FREE(context->references);
+    PLAT_FREE(context);
+}
+
+pb_identifier_t* g5_identifier_create(pb_session_t* session, uint8_t nbr_of_worker_threads,
+                                      struct algo_info* algo_info) {
+    identifier_context_t* context;
+    pb_identifier_t* identifier;
+    int i;
+
+    if (nbr_of_worker_threads == 0) {
+        nbr_of_worker_threads = 1;
+    }
+    context = (identifier_context_t*)plat_alloc(sizeof(identifier_context_t));
+    if (context == NULL) {
+        return NULL;
+    }
+    memset(context, 0, sizeof(identifier_context_t));
+    context->nbr_of_workers = nbr_of_worker_threads;
+    context->workers =
+        (identifier_worker_t*)plat_alloc(nbr_of_worker_threads * sizeof(identifier_worker_t));
+    if (context->workers == NULL || plat_mutex_create(&context->mutex) != THREAD_RES_OK ||
+        plat_semaphore_create(&context->done, 0, nbr_of_worker_threads) != THREAD_RES_OK) {
+        context->nbr_of_workers = 0;
+        identifier_delete_context(context);
+        return NULL;
+    }
+    memset(context->workers, 0, nbr_of_worker_threads * sizeof(identifier_worker_t));
+
+    for (i = 0; i < nbr_of_worker_threads; i++) {
+        identifier_worker_t* worker = &context->workers[i];
+        worker->context = context;
+        worker->index = i;
+        worker->matcher = g5_matcher_create(algo_info);
+        if (worker->matcher == NULL) {
+            ex_log(LOG_ERROR, "g5_identifier_create: worker %d g5_matcher_create failed", i);
+            identifier_delete_context(context);
+            return NULL;
+        }
+        if (i == 0) {
+            // worker 0 runs on the calling thread
+            continue;
+        }
+        worker->param.params = worker;
+        if (plat_semaphore_create(&worker->start, 0, 1) != THREAD_RES_OK ||
+            plat_thread_create_ex(&worker->thread, (void*)identifier_worker_routine,
+                                  &worker->param) != THREAD_RES_OK) {
+            ex_log(LOG_ERROR, "g5_identifier_create: worker %d start failed", i);
+            identifier_delete_context(context);
+            return NULL;
+        }
+    }
+
+    identifier = pb_identifier_create(session, nbr_of_worker_threads, &g5_identifier_functions,
+                                      context, identifier_delete_context);
+    if (identifier == NULL) {
+        identifier_delete_context(context);
+    }
+    return identifier;
+}
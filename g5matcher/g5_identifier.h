@@ -0,0 +1,42 @@
+#ifndef G5_IDENTIFIER_H_
+#define G5_IDENTIFIER_H_
+
+#include "g5_match.h"
+#include "pb_identifier.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Template type of the G5 templates (g5_matcher_extract) added to a G5 identifier. */
+#define G5_TEMPLATE_TYPE PB_TEMPLATE_EXTERNAL1
+
+/**
+ * g5_identifier_create
+ *
+ * Create a pb_identifier_t whose identify functions run on the G5 matcher. The
+ * enrolled templates are split between nbr_of_worker_threads workers, each owning a
+ * g5_matcher_t; the calling thread acts as the first worker. Use the pb_identifier_*
+ * functions on the result and pb_identifier_delete() to release it.
+ *
+ * Scores returned by pb_identifier_identify_template_rank() are G5 match scores
+ * (clamped to 16 bits). pb_identifier_identify_template() accepts the best template
+ * that verify_template_v2 accepts at the FAR of pb_identifier_fpir_to_far().
+ *
+ * @param session
+ *  session passed on to pb_identifier_create().
+ * @param nbr_of_worker_threads
+ *  number of workers, 0 is treated as 1.
+ * @param algo_info
+ *  sensor type, radius and resolution of the worker matchers. NULL keeps the defaults.
+ * @return
+ *  the identifier, or NULL if a worker could not be initialized.
+ */
+pb_identifier_t* g5_identifier_create(pb_session_t* session, uint8_t nbr_of_worker_threads,
+                                      struct algo_info* algo_info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,308 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define LATENCY_HAS_TSC 1
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define LATENCY_HAS_TSC 1
+#endif
+
+typedef unsigned char BYTE;
+#include "g5_latency.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "plat_log.h"
+
+#ifdef _WIN32
+#define LATENCY_INC(p) InterlockedIncrement((volatile LONG*)(p))
+#define LATENCY_LOAD64(p) \
+    ((unsigned long long)InterlockedCompareExchange64((volatile LONGLONG*)(p), 0, 0))
+#define LATENCY_ADD64(p, v) InterlockedExchangeAdd64((volatile LONGLONG*)(p), (LONGLONG)(v))
+#define LATENCY_CAS64(p, old_value, new_value)                                        \
+    (InterlockedCompareExchange64((volatile LONGLONG*)(p), (LONGLONG)(new_value),     \
+                                  (LONGLONG)(old_value)) == (LONGLONG)(old_value))
+#else
+#define LATENCY_INC(p) __sync_add_and_fetch((p), 1)
+#define LATENCY_LOAD64(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define LATENCY_ADD64(p, v) __sync_add_and_fetch((p), (v))
+#define LATENCY_CAS64(p, old_value, new_value) \
+    __sync_bool_compare_and_swap((p), (old_value), (new_value))
+#endif
+
+// Log-linear buckets: values below 2^SUB_BITS ns have a bucket each, above that every
+// power of two is split into 2^SUB_BITS buckets of equal width.
+#define SUB_BITS 5
+#define SUB_COUNT (1 << SUB_BITS)
+#define MAX_BITS 42  // 2^42 ns is ~73 minutes, longer spans are clamped
+#define NBR_OF_BUCKETS ((MAX_BITS - SUB_BITS + 1) * SUB_COUNT)
+#define MAX_VALUE ((1ULL << MAX_BITS) - 1)
+
+#define TSC_CALIBRATION_NS 20000000
+
+typedef struct latency_histogram {
+    volatile unsigned long buckets[NBR_OF_BUCKETS];
+    volatile unsigned long long count;
+    volatile unsigned long long sum_ns;
+    volatile unsigned long long max_ns;
+} latency_histogram_t;
+
+static latency_histogram_t g_histograms[G5_STAGE_COUNT];
+static volatile int g_enabled = 0;
+static g5_latency_clock_t g_clock = G5_LATENCY_CLOCK_MONOTONIC;
+static double g_ns_per_tick = 0;
+
+static const char* g_stage_names[G5_STAGE_COUNT] = {
+    "init",      "extraction", "verify_init_v2", "verify_template_v2", "verify_uninit_v2",
+    "uninit",    "compare",    "identify",       "enroll_init_v2",     "enroll_v2",
+    "enroll_finish",
+};
+
+static unsigned long long monotonic_ticks(void) {
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (unsigned long long)counter.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+static double monotonic_ns_per_tick(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return 1e9 / (double)frequency.QuadPart;
+#else
+    return 1.0;
+#endif
+}
+
+static unsigned long long now_ticks(void) {
+#ifdef LATENCY_HAS_TSC
+    if (g_clock == G5_LATENCY_CLOCK_TSC) return __rdtsc();
+#endif
+    return monotonic_ticks();
+}
+
+#ifdef LATENCY_HAS_TSC
+// Only an invariant TSC runs at a constant rate across P-states and sleep states.
+static int has_invariant_tsc(void) {
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+    if ((unsigned int)regs[0] < 0x80000007) return 0;
+    __cpuid(regs, 0x80000007);
+    return (regs[3] >> 8) & 1;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0x80000000, NULL) < 0x80000007) return 0;
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx >> 8) & 1;
+#endif
+}
+
+static double calibrate_tsc(void) {
+    double mono_ns_per_tick = monotonic_ns_per_tick();
+    unsigned long long mono_start = monotonic_ticks();
+    unsigned long long tsc_start = __rdtsc();
+    unsigned long long mono_end;
+    unsigned long long tsc_end;
+
+    do {
+        mono_end = monotonic_ticks();
+        tsc_end = __rdtsc();
+    } while ((mono_end - mono_start) * mono_ns_per_tick < TSC_CALIBRATION_NS);
+
+    if (tsc_end <= tsc_start) return 0;
+    return (mono_end - mono_start) * mono_ns_per_tick / (double)(tsc_end - tsc_start);
+}
+#endif
+
+static int bucket_index(unsigned long long value) {
+    int msb = 0;
+
+    if (value < SUB_COUNT) return (int)value;
+    if (value > MAX_VALUE) value = MAX_VALUE;
+#ifdef __GNUC__
+    msb = 63 - __builtin_clzll(value);
+#else
+    {
+        unsigned long long v = value;
+        int shift;
+        for (shift = 32; shift > 0; shift >>= 1) {
+            if (v >> shift) {
+                v >>= shift;
+                msb += shift;
+            }
+        }
+    }
+#endif
+    return (msb - SUB_BITS + 1) * SUB_COUNT + (int)(value >> (msb - SUB_BITS)) - SUB_COUNT;
+}
+
+// Highest value that falls into the bucket, as HdrHistogram reports percentiles.
+static unsigned long long bucket_highest(int index) {
+    int shift;
+
+    if (index < SUB_COUNT) return (unsigned long long)index;
+    shift = index / SUB_COUNT - 1;
+    return ((unsigned long long)(SUB_COUNT + index % SUB_COUNT + 1) << shift) - 1;
+}
+
+static double percentile_us(const unsigned long* buckets, unsigned long long total,
+                            unsigned long long max_ns, double percentile) {
+    unsigned long long target = (unsigned long long)(percentile / 100.0 * total + 0.5);
+    unsigned long long seen = 0;
+    unsigned long long value;
+    int i;
+
+    if (total == 0) return 0;
+    if (target < 1) target = 1;
+    if (target > total) target = total;
+    for (i = 0; i < NBR_OF_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target) break;
+    }
+    value = bucket_highest(i < NBR_OF_BUCKETS ? i : NBR_OF_BUCKETS - 1);
+    if (value > max_ns) value = max_ns;
+    return value / 1000.0;
+}
+
+void g5_latency_enable(int enable) {
+    if (g_ns_per_tick == 0) g_ns_per_tick = monotonic_ns_per_tick();
+    g_enabled = enable != 0;
+}
+
+g5_latency_clock_t g5_latency_set_clock(g5_latency_clock_t clock) {
+    if (clock == G5_LATENCY_CLOCK_TSC) {
+#ifdef LATENCY_HAS_TSC
+        double ns_per_tick;
+        if (!has_invariant_tsc()) {
+            ex_log(LOG_ERROR, "no invariant TSC, keeping the monotonic clock");
+            return g_clock;
+        }
+        ns_per_tick = calibrate_tsc();
+        if (ns_per_tick <= 0) {
+            ex_log(LOG_ERROR, "TSC calibration failed, keeping the monotonic clock");
+            return g_clock;
+        }
+        g_ns_per_tick = ns_per_tick;
+        g_clock = G5_LATENCY_CLOCK_TSC;
+        ex_log(LOG_INFO, "TSC at %.1f MHz", 1000.0 / ns_per_tick);
+#else
+        ex_log(LOG_ERROR, "no TSC on this platform, keeping the monotonic clock");
+#endif
+        return g_clock;
+    }
+    g_ns_per_tick = monotonic_ns_per_tick();
+    g_clock = G5_LATENCY_CLOCK_MONOTONIC;
+    return g_clock;
+}
+
+void g5_latency_reset(void) {
+    memset((void*)g_histograms, 0, sizeof(g_histograms));
+}
+
+unsigned long long g5_latency_begin(void) {
+    if (!g_enabled) return 0;
+    return now_ticks();
+}
+
+void g5_latency_end(g5_stage_t stage, unsigned long long start) {
+    latency_histogram_t* histogram;
+    unsigned long long end;
+    unsigned long long ns;
+    unsigned long long max_ns;
+
+    if (start == 0 || stage < 0 || stage >= G5_STAGE_COUNT) return;
+    end = now_ticks();
+    ns = end > start ? (unsigned long long)((end - start) * g_ns_per_tick) : 0;
+    if (ns > MAX_VALUE) ns = MAX_VALUE;
+
+    histogram = &g_histograms[stage];
+    LATENCY_INC(&histogram->buckets[bucket_index(ns)]);
+    LATENCY_ADD64(&histogram->count, 1);
+    LATENCY_ADD64(&histogram->sum_ns, ns);
+    do {
+        max_ns = LATENCY_LOAD64(&histogram->max_ns);
+        if (ns <= max_ns) break;
+    } while (!LATENCY_CAS64(&histogram->max_ns, max_ns, ns));
+}
+
+unsigned long long g5_latency_now_ns(void) {
+    // Not stored, any thread may get here before the clock was set up
+    double ns_per_tick = g_ns_per_tick != 0 ? g_ns_per_tick : monotonic_ns_per_tick();
+    return (unsigned long long)(now_ticks() * ns_per_tick);
+}
+
+void g5_latency_get_summary(g5_stage_t stage, g5_latency_summary_t* summary) {
+    unsigned long buckets[NBR_OF_BUCKETS];
+    latency_histogram_t* histogram;
+    unsigned long long total = 0;
+    unsigned long long max_ns;
+    int i;
+
+    memset(summary, 0, sizeof(*summary));
+    if (stage < 0 || stage >= G5_STAGE_COUNT) return;
+    histogram = &g_histograms[stage];
+
+    // Copy the buckets so the percentiles are taken from one consistent total even
+    // while spans are still being recorded.
+    for (i = 0; i < NBR_OF_BUCKETS; i++) {
+        buckets[i] = histogram->buckets[i];
+        total += buckets[i];
+    }
+    max_ns = LATENCY_LOAD64(&histogram->max_ns);
+    if (total == 0) return;
+
+    summary->count = total;
+    summary->mean_us = LATENCY_LOAD64(&histogram->sum_ns) / 1000.0 /
+                       LATENCY_LOAD64(&histogram->count);
+    summary->p50_us = percentile_us(buckets, total, max_ns, 50);
+    summary->p90_us = percentile_us(buckets, total, max_ns, 90);
+    summary->p99_us = percentile_us(buckets, total, max_ns, 99);
+    summary->p999_us = percentile_us(buckets, total, max_ns, 99.9);
+    summary->max_us = max_ns / 1000.0;
+}
+
+const char* g5_latency_stage_name(g5_stage_t stage) {
+    if (stage < 0 || stage >= G5_STAGE_COUNT) return "unknown";
+    return g_stage_names[stage];
+}
+
+int g5_latency_write_json(const char* path) {
+    FILE* file = fopen(path, "w");
+    int i;
+
+    if (file == NULL) {
+        ex_log(LOG_ERROR, "failed to open %s", path);
+        return -1;
+    }
+    fprintf(file, "{\n  \"clock\": \"%s\",\n  \"unit\": \"us\",\n  \"stages\": {\n",
+            g_clock == G5_LATENCY_CLOCK_TSC ? "tsc" : "monotonic");
+    for (i = 0; i < G5_STAGE_COUNT; i++) {
+        g5_latency_summary_t summary;
+        g5_latency_get_summary((g5_stage_t)i, &summary);
+        fprintf(file,
+                "    \"%s\": {\"count\": %llu, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+                "\"p99\": %.3f, \"p99.9\": %.3f, \"max\": %.3f}%s\n",
+                g_stage_names[i], summary.count, summary.mean_us, summary.p50_us,
+                summary.p90_us, summary.p99_us, summary.p999_us, summary.max_us,
+                i + 1 < G5_STAGE_COUNT ? "," : "");
+    }
+    fprintf(file, "  }\n}\n");
+    if (fclose(file) != 0) {
+        ex_log(LOG_ERROR, "failed to write %s", path);
+        return -1;
+    }
+    return 0;
+}
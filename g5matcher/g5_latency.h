@@ -0,0 +1,103 @@
+#ifndef G5_LATENCY_H_
+#define G5_LATENCY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Per-stage latency of the G5 pipeline.
+ *
+ * The stages of g5_matcher_compare(), identification, enrollment and matcher setup are
+ * wrapped in spans that record their duration into one histogram per stage. The
+ * histograms are log-linear like HdrHistogram: 32 buckets per power of two, so a
+ * percentile is within ~3% of the true value, from 1 ns up to several minutes.
+ * Recording is a few atomic increments, no lock is taken, so all matcher threads record
+ * into the same histograms.
+ *
+ * Recording is off by default; a disabled span costs one load and a branch.
+ */
+
+typedef enum g5_stage {
+    G5_STAGE_INIT,           // algorithm_initialization_v2 and the configuration
+    G5_STAGE_EXTRACT,        // extract_feature_v2, template cache hits are not extractions
+    G5_STAGE_VERIFY_INIT,    // verify_init_v2
+    G5_STAGE_VERIFY,         // verify_template_v2
+    G5_STAGE_VERIFY_UNINIT,  // verify_uninit_v2
+    G5_STAGE_UNINIT,         // algorithm_uninitialization_v2
+    G5_STAGE_COMPARE,        // all of g5_matcher_compare()
+    G5_STAGE_IDENTIFY,       // probe against a loaded gallery, extraction included
+    G5_STAGE_ENROLL_INIT,    // enroll_init_v2, allocates the enroll template
+    G5_STAGE_ENROLL,         // enroll_v2 of one image
+    G5_STAGE_ENROLL_FINISH,  // enroll_finish_v2, get_enroll_template_v2 and enroll_uninit_v2
+    G5_STAGE_COUNT,
+} g5_stage_t;
+
+typedef enum g5_latency_clock {
+    G5_LATENCY_CLOCK_MONOTONIC,  // QueryPerformanceCounter / CLOCK_MONOTONIC
+    G5_LATENCY_CLOCK_TSC,        // rdtsc, calibrated against the monotonic clock
+} g5_latency_clock_t;
+
+typedef struct g5_latency_summary {
+    unsigned long long count;
+    double mean_us;
+    double p50_us;
+    double p90_us;
+    double p99_us;
+    double p999_us;
+    double max_us;
+} g5_latency_summary_t;
+
+/**
+ * Start (enable != 0) or stop recording. Recorded values are kept until
+ * g5_latency_reset().
+ */
+void g5_latency_enable(int enable);
+
+/**
+ * Select the clock of the spans. The TSC is only used when the CPU reports an
+ * invariant TSC; it is calibrated against the monotonic clock, which takes ~20 ms.
+ * Call it while recording is off, spans in flight would mix the two clocks.
+ *
+ * @return
+ *  the clock in use afterwards.
+ */
+g5_latency_clock_t g5_latency_set_clock(g5_latency_clock_t clock);
+
+void g5_latency_reset(void);
+
+/**
+ * @return
+ *  the start of a span, 0 while recording is off.
+ */
+unsigned long long g5_latency_begin(void);
+
+/**
+ * Record the time since start into the histogram of stage. Nothing is recorded for
+ * start 0.
+ */
+void g5_latency_end(g5_stage_t stage, unsigned long long start);
+
+/**
+ * @return
+ *  the time in ns on the clock of the spans, whether recording is on or not.
+ */
+unsigned long long g5_latency_now_ns(void);
+
+void g5_latency_get_summary(g5_stage_t stage, g5_latency_summary_t* summary);
+
+const char* g5_latency_stage_name(g5_stage_t stage);
+
+/**
+ * Write count, mean, p50, p90, p99, p99.9 and max of every stage to path as JSON.
+ *
+ * @return
+ *  0, or -1 if the file could not be written.
+ */
+int g5_latency_write_json(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
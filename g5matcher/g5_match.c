@@ -8,29 +8,41 @@
 //|* *|
 //\******************************************************************************/
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 typedef unsigned char BYTE;
 #include "g5_match.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "EgisAlgorithmApiV2.h"
+#include "g5_arena.h"
+#include "g5_latency.h"
+#include "g5_mem.h"
+#include "g5_template_cache.h"
+#include "g5_trace.h"
+#include "pb_image.h"
+#include "plat_log.h"
 //
 
 #ifndef plat_alloc
-#define plat_alloc(fmt) malloc(fmt)
+#define plat_alloc(fmt) g5_mem_malloc(fmt)
 #endif
 
 #ifndef PLAT_FREE
-#define PLAT_FREE(x) \
-    if (x != NULL) { \
-        free(x);     \
-        x = NULL;    \
+#define PLAT_FREE(x)    \
+    if (x != NULL) {    \
+        g5_mem_free(x); \
+        x = NULL;       \
     }
 #endif
 
 #ifndef plat_free
-#define plat_free(x) free(x)
+#define plat_free(x) g5_mem_free(x)
 #endif
 
 #ifndef FALSE
@@ -41,18 +53,31 @@ typedef unsigned char BYTE;
 #define TRUE 1
 #endif
 
+#ifdef _MSC_VER
+#define DECISION_CAS(p, old_value, new_value)                                         \
+    (InterlockedCompareExchange((volatile LONG*)(p), (LONG)(new_value), (LONG)(old_value)) == \
+     (LONG)(old_value))
+#define DECISION_STORE(p, v) InterlockedExchange((volatile LONG*)(p), (LONG)(v))
+#else
+#define DECISION_CAS(p, old_value, new_value) \
+    __sync_bool_compare_and_swap((p), (old_value), (new_value))
+#define DECISION_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
 #define BAUTH_MAX_TEMPLATE_INDEXS 4
 #define MATCHER_API_MAX_DPI_VERIFY_NUM 5
 
+// Allocation hook of the BMF library, malloc / free unless g5_arena is configured
 void* pb_malloc(size_t size) {
-    return malloc(size);
+    return g5_arena_malloc(size);
 }
 void pb_free(void* ptr) {
-    free(ptr);
+    g5_arena_free(ptr);
 }
 #define FAR_RATIO 100 * 1000  // 100K
 static char g_imgfmt[16] = "*.png";
 static int g_max_enroll_count = 17;
+static int g_enroll_template_size = 500 * 1024;
 static int g_max_dry_count = 5;
 static int g_enroll_redundant_level = 0;
 static int g_enroll_quality_reject_level = 15;
@@ -68,9 +93,12 @@ static int g_centroid_Y = 100;
 static int g_radius = 120;
 static int g_dyn_mask_threshold = 0;
 static int g_dyn_mask_radius = 0;
-static void* g_ctx;                  // new
 static BYTE* g_decision_data = 0;    // new
 static int g_decision_data_len = 0;  // new
+// g_decision_data was handed back by a matcher and is owned here, not set by the caller
+static int g_decision_data_owned = FALSE;
+// Guards the g_decision_data* above, matchers take and hand back decision data on any thread
+static volatile long g_decision_lock = 0;
 static enum algo_api_sensor_type g_sensor_type = FP_ALGOAPI_MODE_EGIS_ET713_3PG_S3PG6;
 
 typedef struct _model_setting {
@@ -105,170 +133,913 @@ typedef struct _model_setting {
     enum lens_type phone_lens_type;
     enum fp_type phone_sensor_type;
 } model_setting;
-model_setting g_session;
-
-static void set_image_class_type_num(void* ctx) {
-    set_required_minimum_nbr_of_subtemplates_v2(ctx, FP_IMAGE_TYPE_ENROLL, g_max_enroll_count);
-    set_required_minimum_nbr_of_subtemplates_v2(ctx, FP_IMAGE_TYPE_DRY, g_max_dry_count);
-}
-
-int algorithm_initialization() {
-    g_session.g_ctx = g_ctx;
-    // g_session.g_enroll_template_size = g_enroll_template_size;
-    g_session.g_enroll_redundant_level = g_enroll_redundant_level;
-    g_session.g_enroll_quality_reject_level = g_enroll_quality_reject_level;
-    g_session.g_enroll_latent_reject_level = g_enroll_latent_reject_level;
-    g_session.g_normal_far_ratio = g_verify_accuracy_level;
-    // g_session.g_wash_hand_far_ratio = g_wash_hand_far_ratio;
-    // g_session.g_easy_mode_2_far_ratio = g_easy_mode_2_far_ratio;
-    // g_session.g_easy_mode_3_far_ratio = g_easy_mode_3_far_ratio;
-    g_session.g_latency_adjustment = g_latency_adjustment;
-    g_session.g_resolution = g_resolution;
-    g_session.g_resolution_v2 = g_resolution_v2;
-    // g_session.g_boost = g_boost;
-    g_session.g_spd = g_spd;
-    // g_session.g_matcher_g5_spd_th = g_matcher_g5_spd_th;
-    // g_session.g_mask_enable = g_mask_enable;
-    g_session.g_centroid_X = g_centroid_X;
-    g_session.g_centroid_Y = g_centroid_Y;
-    g_session.g_radius = g_radius;
-    g_session.g_dyn_mask_threshold = g_dyn_mask_threshold;
-    g_session.g_dyn_mask_radius = g_dyn_mask_radius;
-    // g_session.g_latent_finger_check = g_latent_finger_check;
-    // g_session.g_skip_failimage_learn = g_skip_failimage_learn;
-    // g_session.g_update_learn_by_filename = g_update_learn_by_filename;
-    // g_session.g_dry_finger_mode = g_dry_finger_mode;
-    g_session.g_sensor_type = g_sensor_type;
-    // g_session.phone_model_type = phone_model_type;
-    // g_session.phone_lens_type = phone_lens_type;
-    // g_session.phone_sensor_type = phone_sensor_type;
 
+// One G5 context with its own configuration and decision data. Instances share no
+// state, so each thread can own one.
+struct g5_matcher {
+    model_setting session;
+    int max_enroll_count;
+    int max_dry_count;
+    int first_n_lower_far;
+    BYTE* decision_data;  // passed to and handed back by the G5 context
+    int decision_data_len;
+    BYTE* decision_copy;  // private copy of the default decision data the context started from
+    unsigned char algo_ver[FP_ALGO_VERSION_LEN];
+    g5_template_cache_t* template_cache;  // not owned, may be shared
+    // Gallery templates between load and unload, only read by g5_matcher_identify
+    struct verify_init_v2 gallery;
+    g5_template_entry_t** gallery_entries;
+    int gallery_loaded;
+    // Between g5_matcher_enroll_begin and g5_matcher_enroll_finish
+    int enrolling;
+    int enroll_count;
+};
+
+unsigned char g_algo_ver[FP_ALGO_VERSION_LEN];
+static int g_algo_ver_printed = FALSE;
+
+// Default matcher behind images_compare_ / g5_matcher_open
+static g5_matcher_t* g_default_matcher = NULL;
+
+static void set_image_class_type_num(g5_matcher_t* matcher) {
+    set_required_minimum_nbr_of_subtemplates_v2(matcher->session.g_ctx, FP_IMAGE_TYPE_ENROLL,
+                                                matcher->max_enroll_count);
+    set_required_minimum_nbr_of_subtemplates_v2(matcher->session.g_ctx, FP_IMAGE_TYPE_DRY,
+                                                matcher->max_dry_count);
+}
+
+static void load_default_setting(g5_matcher_t* matcher) {
+    model_setting* session = &matcher->session;
+    session->g_enroll_template_size = g_enroll_template_size;
+    session->g_enroll_redundant_level = g_enroll_redundant_level;
+    session->g_enroll_quality_reject_level = g_enroll_quality_reject_level;
+    session->g_enroll_latent_reject_level = g_enroll_latent_reject_level;
+    session->g_normal_far_ratio = g_verify_accuracy_level;
+    // session->g_wash_hand_far_ratio = g_wash_hand_far_ratio;
+    // session->g_easy_mode_2_far_ratio = g_easy_mode_2_far_ratio;
+    // session->g_easy_mode_3_far_ratio = g_easy_mode_3_far_ratio;
+    session->g_latency_adjustment = g_latency_adjustment;
+    session->g_resolution = g_resolution;
+    session->g_resolution_v2 = g_resolution_v2;
+    // session->g_boost = g_boost;
+    session->g_spd = g_spd;
+    // session->g_matcher_g5_spd_th = g_matcher_g5_spd_th;
+    // session->g_mask_enable = g_mask_enable;
+    session->g_centroid_X = g_centroid_X;
+    session->g_centroid_Y = g_centroid_Y;
+    session->g_radius = g_radius;
+    session->g_dyn_mask_threshold = g_dyn_mask_threshold;
+    session->g_dyn_mask_radius = g_dyn_mask_radius;
+    // session->g_latent_finger_check = g_latent_finger_check;
+    // session->g_skip_failimage_learn = g_skip_failimage_learn;
+    // session->g_update_learn_by_filename = g_update_learn_by_filename;
+    // session->g_dry_finger_mode = g_dry_finger_mode;
+    session->g_sensor_type = g_sensor_type;
+    // session->phone_model_type = phone_model_type;
+    // session->phone_lens_type = phone_lens_type;
+    // session->phone_sensor_type = phone_sensor_type;
+
+    matcher->max_enroll_count = g_max_enroll_count;
+    matcher->max_dry_count = g_max_dry_count;
+    matcher->first_n_lower_far = g_first_n_lower_far;
+}
+
+static void apply_algo_info(model_setting* session, const struct algo_info* algo_info) {
+    session->g_sensor_type = algo_info->sensor_type;
+    session->g_resolution = algo_info->resolution;
+    session->g_radius = algo_info->radius;
+}
+
+// A pipeline stage is timed into its latency histogram, shown on the trace timeline and
+// owns the allocations made in it.
+static unsigned long long stage_begin(g5_stage_t stage) {
+    G5_TRACE_BEGIN(g5_latency_stage_name(stage));
+    g5_mem_push_stage(stage);
+    return g5_latency_begin();
+}
+
+static void stage_end(g5_stage_t stage, unsigned long long span) {
+    g5_latency_end(stage, span);
+    g5_mem_pop_stage();
+    G5_TRACE_END(g5_latency_stage_name(stage));
+}
+
+static void decision_lock(void) {
+    while (!DECISION_CAS(&g_decision_lock, 0, 1)) {
+    }
+}
+
+static void decision_unlock(void) {
+    DECISION_STORE(&g_decision_lock, 0);
+}
+
+/*
+ * Start a context of the default sensor type from a private copy of the default
+ * decision data: algorithm_initialization_v2 takes the data non-const, so contexts
+ * must not share one buffer. Decision data is learned for one sensor type, the
+ * contexts of other types start cold.
+ */
+static void take_decision_data(g5_matcher_t* matcher) {
+    int len = 0;
+    matcher->decision_data = NULL;
+    matcher->decision_data_len = 0;
+    if (matcher->session.g_sensor_type != g_sensor_type) {
+        return;
+    }
+    decision_lock();
+    if (g_decision_data != NULL && g_decision_data_len > 0) {
+        len = g_decision_data_len;
+        matcher->decision_copy = (BYTE*)plat_alloc(len);
+        if (matcher->decision_copy != NULL) {
+            memcpy(matcher->decision_copy, g_decision_data, len);
+        }
+    }
+    decision_unlock();
+    if (matcher->decision_copy != NULL) {
+        matcher->decision_data = matcher->decision_copy;
+        matcher->decision_data_len = len;
+    } else if (len > 0) {
+        ex_log(LOG_ERROR, "take_decision_data: out of memory for %d bytes, starting cold", len);
+    }
+}
+
+/*
+ * Make the decision data the context handed back at algorithm_uninitialization_v2 the
+ * default new matchers start from, as a copy owned here, and free the private copy
+ * the context started from. The last matcher of the default sensor type to end wins.
+ */
+static void hand_back_decision_data(g5_matcher_t* matcher) {
+    int len = matcher->decision_data_len;
+    BYTE* copy;
+    BYTE* old = NULL;
+
+    if (matcher->session.g_sensor_type == g_sensor_type && matcher->decision_data != NULL &&
+        len > 0) {
+        copy = (BYTE*)plat_alloc(len);
+        if (copy != NULL) {
+            memcpy(copy, matcher->decision_data, len);
+            decision_lock();
+            old = g_decision_data_owned ? g_decision_data : NULL;
+            g_decision_data = copy;
+            g_decision_data_len = len;
+            g_decision_data_owned = TRUE;
+            decision_unlock();
+            plat_free(old);
+        } else {
+            ex_log(LOG_ERROR, "hand_back_decision_data: out of memory for %d bytes", len);
+        }
+    }
+    PLAT_FREE(matcher->decision_copy);
+    matcher->decision_data = NULL;
+    matcher->decision_data_len = 0;
+}
+
+static int algorithm_initialization(g5_matcher_t* matcher) {
+    model_setting* session = &matcher->session;
+    unsigned long long span = stage_begin(G5_STAGE_INIT);
     int ret;
-    ret = algorithm_initialization_v2(&g_session.g_ctx, g_decision_data, g_decision_data_len,
-                                      g_session.g_sensor_type);
+    take_decision_data(matcher);
+    ret = algorithm_initialization_v2(&session->g_ctx, matcher->decision_data,
+                                      matcher->decision_data_len, session->g_sensor_type);
+    if (ret != FP_OK || session->g_ctx == NULL) {
+        PLAT_FREE(matcher->decision_copy);
+        matcher->decision_data = NULL;
+        matcher->decision_data_len = 0;
+        stage_end(G5_STAGE_INIT, span);
+        return ret != FP_OK ? ret : FP_ERR;
+    }
     // General config
-    set_image_class_type_num(g_session.g_ctx);
-    ret = set_algo_config_v2(g_session.g_ctx, FP_OP_ENABLE_SPD, g_session.g_spd);
-    ret = set_algo_config_v2(g_session.g_ctx, FP_OP_RESOLUTION, g_session.g_resolution);
-    if (g_session.g_centroid_X > 0 && g_session.g_centroid_Y > 0 && g_session.g_radius > 0) {
-        ret = set_algo_config_v2(g_session.g_ctx, FP_OP_CENTROID_X, g_session.g_centroid_X);
-        ret = set_algo_config_v2(g_session.g_ctx, FP_OP_CENTROID_Y, g_session.g_centroid_Y);
-        ret = set_algo_config_v2(g_session.g_ctx, FP_OP_RADIUS, g_session.g_radius);
-    }
-    if (g_session.g_dyn_mask_threshold > 0 && g_session.g_dyn_mask_radius > 0) {
-        ret = set_algo_config_v2(g_session.g_ctx, FP_OP_DYN_MASK_THRESHOLD,
-                                 g_session.g_dyn_mask_threshold);
-        ret =
-            set_algo_config_v2(g_session.g_ctx, FP_OP_DYN_MASK_RADIUS, g_session.g_dyn_mask_radius);
+    set_image_class_type_num(matcher);
+    ret = set_algo_config_v2(session->g_ctx, FP_OP_ENABLE_SPD, session->g_spd);
+    ret = set_algo_config_v2(session->g_ctx, FP_OP_RESOLUTION, session->g_resolution);
+    if (session->g_centroid_X > 0 && session->g_centroid_Y > 0 && session->g_radius > 0) {
+        ret = set_algo_config_v2(session->g_ctx, FP_OP_CENTROID_X, session->g_centroid_X);
+        ret = set_algo_config_v2(session->g_ctx, FP_OP_CENTROID_Y, session->g_centroid_Y);
+        ret = set_algo_config_v2(session->g_ctx, FP_OP_RADIUS, session->g_radius);
+    }
+    if (session->g_dyn_mask_threshold > 0 && session->g_dyn_mask_radius > 0) {
+        ret = set_algo_config_v2(session->g_ctx, FP_OP_DYN_MASK_THRESHOLD,
+                                 session->g_dyn_mask_threshold);
+        ret = set_algo_config_v2(session->g_ctx, FP_OP_DYN_MASK_RADIUS, session->g_dyn_mask_radius);
     }
     // Enroll config
-    ret = set_algo_config_v2(g_session.g_ctx, FP_OP_MAX_ENROLL_COUNT, g_max_enroll_count);
-    ret = set_algo_config_v2(g_session.g_ctx, FP_OP_ENROLL_REDUNDANT_LEVEL,
-                             g_session.g_enroll_redundant_level);
-    ret = set_algo_config_v2(g_session.g_ctx, FP_OP_ENROLL_QUALITY_REJECT_LEVEL,
-                             g_session.g_enroll_quality_reject_level);
-    ret = set_algo_config_v2(g_session.g_ctx, FP_OP_ENROLL_LATENT_REJECT_LEVEL,
-                             g_session.g_enroll_latent_reject_level);
+    ret = set_algo_config_v2(session->g_ctx, FP_OP_MAX_ENROLL_COUNT, matcher->max_enroll_count);
+    ret = set_algo_config_v2(session->g_ctx, FP_OP_ENROLL_REDUNDANT_LEVEL,
+                             session->g_enroll_redundant_level);
+    ret = set_algo_config_v2(session->g_ctx, FP_OP_ENROLL_QUALITY_REJECT_LEVEL,
+                             session->g_enroll_quality_reject_level);
+    ret = set_algo_config_v2(session->g_ctx, FP_OP_ENROLL_LATENT_REJECT_LEVEL,
+                             session->g_enroll_latent_reject_level);
     // Verify config
-    ret = set_accuracy_level_v2(g_session.g_ctx, g_session.g_normal_far_ratio);
-    ret = set_algo_config_v2(g_session.g_ctx, FP_OP_SET_FIRST_N_LOWER_FAR, g_first_n_lower_far);
-    return ret;
+    ret = set_accuracy_level_v2(session->g_ctx, session->g_normal_far_ratio);
+    ret = set_algo_config_v2(session->g_ctx, FP_OP_SET_FIRST_N_LOWER_FAR,
+                             matcher->first_n_lower_far);
+    // Single template comparison
+    set_algo_config_v2(session->g_ctx, FP_OP_MAX_ENROLL_COUNT, 1);
+    stage_end(G5_STAGE_INIT, span);
+    return FP_OK;
 }
-unsigned char g_algo_ver[FP_ALGO_VERSION_LEN];
-void get_version() {
-    int algo_ver_len = FP_ALGO_VERSION_LEN;
-    algorithm_initialization_v2(&g_ctx, g_decision_data, g_decision_data_len, g_sensor_type);
 
+static void algorithm_uninitialization(g5_matcher_t* matcher) {
+    unsigned long long span;
+    if (matcher->session.g_ctx == NULL) {
+        return;
+    }
+    span = stage_begin(G5_STAGE_UNINIT);
+    algorithm_uninitialization_v2(matcher->session.g_ctx, &matcher->decision_data,
+                                  &matcher->decision_data_len);  // new
+    stage_end(G5_STAGE_UNINIT, span);
+    matcher->session.g_ctx = NULL;
+    hand_back_decision_data(matcher);
+}
+
+static void get_version(g5_matcher_t* matcher) {
+    int algo_ver_len = FP_ALGO_VERSION_LEN;
     // algorithm_do_other(FP_ALGOAPI_GET_VERSION, NULL, (BYTE*)&g_algo_api_info);
-    algorithm_do_other_v2(g_ctx, FP_OP_GET_VERSION_V2, NULL, 0, g_algo_ver, &algo_ver_len);
-    printf("G5 version : matcher(%s) \n", g_algo_ver);
-    // algorithm_uninitialization(NULL, DECISION_DATA_LEN);
-    algorithm_uninitialization_v2(g_ctx, &g_decision_data, &g_decision_data_len);  // new
+    algorithm_do_other_v2(matcher->session.g_ctx, FP_OP_GET_VERSION_V2, NULL, 0,
+                          matcher->algo_ver, &algo_ver_len);
 }
 
-void images_compare_(unsigned char** raw1, unsigned char** raw2, int w, int h, int* match_score,
-                     int* rot, int* dx, int* dy) {
-    if (raw1 == NULL || raw2 == NULL) {
-        printf("Load image file fail\r\n");
+static g5_matcher_t* matcher_create(struct algo_info* algo_info) {
+    g5_matcher_t* matcher = (g5_matcher_t*)plat_alloc(sizeof(g5_matcher_t));
+    if (matcher == NULL) {
+        return NULL;
+    }
+    memset(matcher, 0, sizeof(g5_matcher_t));
+    load_default_setting(matcher);
+    if (algo_info != NULL) {
+        apply_algo_info(&matcher->session, algo_info);
+    }
+    if (algorithm_initialization(matcher) != FP_OK) {
+        plat_free(matcher);
+        return NULL;
+    }
+    get_version(matcher);
+    return matcher;
+}
+
+g5_matcher_t* g5_matcher_create(struct algo_info* algo_info) {
+    return matcher_create(algo_info);
+}
+
+int g5_matcher_configure(g5_matcher_t* matcher, struct algo_info* algo_info) {
+    model_setting* session;
+    int ret = FP_OK;
+    if (matcher == NULL || algo_info == NULL) {
+        return FP_NULL_DATA;
+    }
+    if (matcher->gallery_loaded || matcher->enrolling) {
+        // The loaded templates were extracted with the current configuration
+        return FP_STATE_ERR;
+    }
+    session = &matcher->session;
+
+    if (algo_info->sensor_type != (int)session->g_sensor_type) {
+        // The sensor type is bound to the context at algorithm_initialization_v2
+        algorithm_uninitialization(matcher);
+        apply_algo_info(session, algo_info);
+        return algorithm_initialization(matcher);
+    }
+    if (algo_info->resolution != session->g_resolution) {
+        session->g_resolution = algo_info->resolution;
+        ret = set_algo_config_v2(session->g_ctx, FP_OP_RESOLUTION, session->g_resolution);
+    }
+    if (algo_info->radius != session->g_radius) {
+        session->g_radius = algo_info->radius;
+        if (session->g_centroid_X > 0 && session->g_centroid_Y > 0 && session->g_radius > 0) {
+            ret = set_algo_config_v2(session->g_ctx, FP_OP_RADIUS, session->g_radius);
+        }
+    }
+    return ret;
+}
+
+void g5_matcher_set_template_cache(g5_matcher_t* matcher, g5_template_cache_t* cache) {
+    if (matcher == NULL) {
         return;
     }
+    matcher->template_cache = cache;
+}
+
+static void make_template_key(g5_matcher_t* matcher, const unsigned char* raw, int w, int h,
+                              g5_template_key_t* key) {
+    const model_setting* session = &matcher->session;
+    key->pixels = raw;
+    key->pixel_hash = g5_template_cache_hash(raw, w * h);
+    key->width = w;
+    key->height = h;
+    key->sensor_type = session->g_sensor_type;
+    key->resolution = session->g_resolution;
+    key->centroid_x = session->g_centroid_X;
+    key->centroid_y = session->g_centroid_Y;
+    key->radius = session->g_radius;
+    key->spd = session->g_spd;
+}
+
+static int extract_feature(g5_matcher_t* matcher, unsigned char* raw, int w, int h, BYTE** temp,
+                           int* temp_size) {
+    unsigned long long span = stage_begin(G5_STAGE_EXTRACT);
+    int status;
+    g5_arena_begin();
+    status = extract_feature_v2(matcher->session.g_ctx, raw, w, h, FP_IMAGE_TYPE_NORMAL, temp,
+                                temp_size);
+    // The template outlives the arena scope and is released with g5_matcher_free_template()
+    if (*temp != NULL) {
+        *temp = (BYTE*)g5_arena_promote(*temp, *temp_size);
+        if (*temp == NULL) {
+            *temp_size = 0;
+            status = FP_ALLOC_MEM_FAIL;
+        }
+    }
+    g5_arena_end();
+    stage_end(G5_STAGE_EXTRACT, span);
+    return status;
+}
+
+/*
+ * Extract the template of raw, going through the template cache if one is set.
+ * With a cache *entry is acquired and must be released, otherwise *entry is NULL and
+ * *temp must be freed by the caller.
+ */
+static int extract_template(g5_matcher_t* matcher, unsigned char* raw, int w, int h,
+                            g5_template_entry_t** entry, BYTE** temp, int* temp_size) {
+    g5_template_key_t key;
+    int status;
+
+    *entry = NULL;
+    *temp = NULL;
+    *temp_size = 0;
+    if (matcher->template_cache == NULL) {
+        return extract_feature(matcher, raw, w, h, temp, temp_size);
+    }
+
+    make_template_key(matcher, raw, w, h, &key);
+    *entry = g5_template_cache_lookup(matcher->template_cache, &key);
+    if (*entry == NULL) {
+        status = extract_feature(matcher, raw, w, h, temp, temp_size);
+        if (*temp == NULL) {
+            return status != FP_OK ? status : FP_NULL_FEATURE;
+        }
+        *entry = g5_template_cache_insert(matcher->template_cache, &key, *temp, *temp_size);
+        if (*entry == NULL) {
+            *temp = NULL;
+            return FP_ALLOC_MEM_FAIL;
+        }
+    }
+    *temp = (BYTE*)g5_template_entry_data(*entry, temp_size);
+    return FP_OK;
+}
+
+static void release_template(g5_matcher_t* matcher, g5_template_entry_t* entry, BYTE* temp) {
+    if (entry != NULL) {
+        g5_template_cache_release(matcher->template_cache, entry);
+    } else {
+        plat_free(temp);
+    }
+}
+
+static void get_alignment(const struct verify_info_v2* verify_info, int* rot, int* dx, int* dy) {
+    *rot = (float)verify_info->match_alignment.rotation / 255 * 360;
+    if (*rot > 180) {
+        *rot = *rot - 360;
+    }
+    *dx = verify_info->match_alignment.dx;
+    *dy = verify_info->match_alignment.dy;
+}
 
-    // init
+int g5_matcher_compare(g5_matcher_t* matcher, unsigned char* raw1, unsigned char* raw2, int w,
+                       int h, int* match_score, int* rot, int* dx, int* dy) {
     int status = 0;
     int nbr_of_fingers_to_enroll = 1;  // new
+    unsigned long long compare_span;
+    unsigned long long span;
+    void* ctx;
 
-    algorithm_initialization();
-    set_algo_config_v2(g_session.g_ctx, FP_OP_MAX_ENROLL_COUNT, 1);
+    if (matcher == NULL || matcher->session.g_ctx == NULL || matcher->gallery_loaded ||
+        matcher->enrolling) {
+        return FP_STATE_ERR;
+    }
+    if (raw1 == NULL || raw2 == NULL) {
+        return FP_NULL_DATA;
+    }
+    ctx = matcher->session.g_ctx;
+    compare_span = stage_begin(G5_STAGE_COMPARE);
+    g5_arena_begin();
+
+    g5_template_entry_t* entry1 = NULL;
     BYTE* extract_finger_temp1 = NULL;
     int extract_finger_temp1_size = 0;
+    g5_template_entry_t* entry2 = NULL;
     BYTE* extract_finger_temp2 = NULL;
     int extract_finger_temp2_size = 0;
 
-    // get version
-    get_version();
-
     // extract feature
-    extract_feature_v2(g_session.g_ctx, raw1[0], w, h, FP_IMAGE_TYPE_NORMAL, &extract_finger_temp1,
-                       &extract_finger_temp1_size);
+    extract_template(matcher, raw1, w, h, &entry1, &extract_finger_temp1,
+                     &extract_finger_temp1_size);
 
-    extract_feature_v2(g_session.g_ctx, raw2[0], w, h, FP_IMAGE_TYPE_NORMAL, &extract_finger_temp2,
-                       &extract_finger_temp2_size);
+    extract_template(matcher, raw2, w, h, &entry2, &extract_finger_temp2,
+                     &extract_finger_temp2_size);
 
     struct verify_init_v2 verify_init = {0};  // new
     verify_init.enroll_temp_array =
         (BYTE**)plat_alloc(nbr_of_fingers_to_enroll * sizeof(BYTE*));  // new
     if (verify_init.enroll_temp_array == NULL) {
-        return;
+        release_template(matcher, entry1, extract_finger_temp1);
+        release_template(matcher, entry2, extract_finger_temp2);
+        g5_arena_end();
+        stage_end(G5_STAGE_COMPARE, compare_span);
+        return FP_ALLOC_MEM_FAIL;
     }
     verify_init.enroll_temp_size_array =
         (int*)plat_alloc(nbr_of_fingers_to_enroll * sizeof(int));  // new
     if (verify_init.enroll_temp_size_array == NULL) {
         PLAT_FREE(verify_init.enroll_temp_array);
-        return;
+        release_template(matcher, entry1, extract_finger_temp1);
+        release_template(matcher, entry2, extract_finger_temp2);
+        g5_arena_end();
+        stage_end(G5_STAGE_COMPARE, compare_span);
+        return FP_ALLOC_MEM_FAIL;
     }
     verify_init.enroll_temp_number = nbr_of_fingers_to_enroll;  // new
-    verify_init.enroll_temp_array[0] = (BYTE*)plat_alloc(extract_finger_temp1_size * sizeof(BYTE));
     verify_init.enroll_temp_array[0] = extract_finger_temp1;
     verify_init.enroll_temp_size_array[0] = extract_finger_temp1_size;
-    status = verify_init_v2(g_session.g_ctx, &verify_init);
+    span = stage_begin(G5_STAGE_VERIFY_INIT);
+    status = verify_init_v2(ctx, &verify_init);
+    stage_end(G5_STAGE_VERIFY_INIT, span);
 
     struct verify_info_v2 verify_info_data = {0};
     verify_info_data.try_match_count = 0;
-    verify_info_data.image = raw2[0];
+    verify_info_data.image = raw2;
     verify_info_data.width = w;
     verify_info_data.height = h;
     verify_info_data.match_score = 0;
     verify_info_data.match_index = -1;
     verify_info_data.image_class = FP_IMAGE_TYPE_NORMAL;
-    verify_info_data.latency_adjustment = g_latency_adjustment;
+    verify_info_data.latency_adjustment = matcher->session.g_latency_adjustment;
     verify_info_data.match_score_array = (int*)plat_alloc(sizeof(int) * 1);
     verify_info_data.is_learning_update = 0;
     verify_info_data.enroll_temp_size = 0;
 
     // matching
-    status = verify_template_v2(g_session.g_ctx, extract_finger_temp1, extract_finger_temp1_size,
+    span = stage_begin(G5_STAGE_VERIFY);
+    status = verify_template_v2(ctx, extract_finger_temp1, extract_finger_temp1_size,
                                 extract_finger_temp2, extract_finger_temp2_size, &verify_info_data);
+    stage_end(G5_STAGE_VERIFY, span);
 
-    int result = verify_info_data.match_result;
     *match_score = verify_info_data.match_score;
-    *rot = (float)verify_info_data.match_alignment.rotation / 255 * 360;
-    if (*rot > 180) {
-        *rot = *rot - 360;
-    }
-    *dx = verify_info_data.match_alignment.dx;
-    *dy = verify_info_data.match_alignment.dy;
+    get_alignment(&verify_info_data, rot, dx, dy);
 
-    status = verify_uninit_v2(g_session.g_ctx);
+    span = stage_begin(G5_STAGE_VERIFY_UNINIT);
+    verify_uninit_v2(ctx);
+    stage_end(G5_STAGE_VERIFY_UNINIT, span);
 
     plat_free(verify_init.enroll_temp_array);
     plat_free(verify_init.enroll_temp_size_array);
     plat_free(verify_info_data.match_score_array);
 
-    plat_free(extract_finger_temp1);
-    plat_free(extract_finger_temp2);
-    algorithm_uninitialization_v2(g_session.g_ctx, &g_decision_data,
-                                  &g_decision_data_len);  // new
-    return;
+    release_template(matcher, entry1, extract_finger_temp1);
+    release_template(matcher, entry2, extract_finger_temp2);
+    g5_arena_end();
+    stage_end(G5_STAGE_COMPARE, compare_span);
+    return status;
+}
+
+int g5_matcher_compare_succeeded(int status) {
+    return status == FP_MATCHOK || status == FP_MATCHFAIL || status == FP_OK;
+}
+
+int g5_matcher_compare_images(g5_matcher_t* matcher, const pb_image_t* image1,
+                              const pb_image_t* image2, int* match_score, int* rot, int* dx,
+                              int* dy) {
+    int w, h;
+    if (image1 == NULL || image2 == NULL) {
+        return FP_NULL_DATA;
+    }
+    w = pb_image_get_cols(image1);
+    h = pb_image_get_rows(image1);
+    if (pb_image_get_cols(image2) != w || pb_image_get_rows(image2) != h) {
+        return FP_PARAMETER_NOT_VALID;
+    }
+    // The G5 API takes non-const pixels but does not write to them
+    return g5_matcher_compare(matcher, (unsigned char*)pb_image_get_pixels(image1),
+                              (unsigned char*)pb_image_get_pixels(image2), w, h, match_score,
+                              rot, dx, dy);
+}
+
+int g5_matcher_extract(g5_matcher_t* matcher, unsigned char* raw, int w, int h,
+                       unsigned char** temp, int* temp_size) {
+    if (matcher == NULL || matcher->session.g_ctx == NULL) {
+        return FP_STATE_ERR;
+    }
+    if (raw == NULL || temp == NULL || temp_size == NULL) {
+        return FP_NULL_DATA;
+    }
+    *temp = NULL;
+    *temp_size = 0;
+    return extract_feature(matcher, raw, w, h, temp, temp_size);
+}
+
+void g5_matcher_free_template(unsigned char* temp) {
+    plat_free(temp);
+}
+
+int g5_matcher_verify_templates(g5_matcher_t* matcher, const unsigned char* temp1,
+                                int temp1_size, const unsigned char* temp2, int temp2_size,
+                                int* match_score, int* rot, int* dx, int* dy) {
+    unsigned long long span;
+    int status;
+    if (matcher == NULL || matcher->session.g_ctx == NULL) {
+        return FP_STATE_ERR;
+    }
+    if (temp1 == NULL || temp2 == NULL) {
+        return FP_NULL_DATA;
+    }
+
+    struct verify_info_v2 verify_info_data = {0};
+    verify_info_data.match_index = -1;
+    verify_info_data.image_class = FP_IMAGE_TYPE_NORMAL;
+    verify_info_data.latency_adjustment = matcher->session.g_latency_adjustment;
+    verify_info_data.match_score_array = (int*)plat_alloc(sizeof(int) * 1);
+
+    span = stage_begin(G5_STAGE_VERIFY);
+    status = verify_template_v2(matcher->session.g_ctx, temp1, temp1_size, temp2, temp2_size,
+                                &verify_info_data);
+    stage_end(G5_STAGE_VERIFY, span);
+
+    *match_score = verify_info_data.match_score;
+    get_alignment(&verify_info_data, rot, dx, dy);
+    plat_free(verify_info_data.match_score_array);
+    return status;
+}
+
+int g5_matcher_set_far_ratio(g5_matcher_t* matcher, int far_ratio) {
+    if (matcher == NULL || matcher->session.g_ctx == NULL) {
+        return FP_STATE_ERR;
+    }
+    if (far_ratio == matcher->session.g_normal_far_ratio) {
+        return FP_OK;
+    }
+    matcher->session.g_normal_far_ratio = far_ratio;
+    return set_accuracy_level_v2(matcher->session.g_ctx, far_ratio);
+}
+
+static void gallery_free(g5_matcher_t* matcher) {
+    struct verify_init_v2* gallery = &matcher->gallery;
+    int i;
+    for (i = 0; i < gallery->enroll_temp_number; i++) {
+        release_template(matcher, matcher->gallery_entries[i], gallery->enroll_temp_array[i]);
+    }
+    PLAT_FREE(gallery->enroll_temp_array);
+    PLAT_FREE(gallery->enroll_temp_size_array);
+    PLAT_FREE(matcher->gallery_entries);
+    gallery->enroll_temp_number = 0;
+}
+
+int g5_matcher_load_gallery(g5_matcher_t* matcher, unsigned char** images, int nbr_of_images,
+                            int w, int h) {
+    struct verify_init_v2* gallery;
+    int i, status;
+
+    if (matcher == NULL || matcher->session.g_ctx == NULL || matcher->enrolling) {
+        return FP_STATE_ERR;
+    }
+    if (images == NULL || nbr_of_images <= 0) {
+        return FP_NULL_DATA;
+    }
+    g5_matcher_unload_gallery(matcher);
+    gallery = &matcher->gallery;
+
+    gallery->enroll_temp_array = (BYTE**)plat_alloc(nbr_of_images * sizeof(BYTE*));
+    gallery->enroll_temp_size_array = (int*)plat_alloc(nbr_of_images * sizeof(int));
+    matcher->gallery_entries =
+        (g5_template_entry_t**)plat_alloc(nbr_of_images * sizeof(g5_template_entry_t*));
+    if (gallery->enroll_temp_array == NULL || gallery->enroll_temp_size_array == NULL ||
+        matcher->gallery_entries == NULL) {
+        gallery_free(matcher);
+        return FP_ALLOC_MEM_FAIL;
+    }
+
+    for (i = 0; i < nbr_of_images; i++) {
+        status = extract_template(matcher, images[i], w, h, &matcher->gallery_entries[i],
+                                  &gallery->enroll_temp_array[i],
+                                  &gallery->enroll_temp_size_array[i]);
+        gallery->enroll_temp_number = i + 1;
+        if (gallery->enroll_temp_array[i] == NULL) {
+            ex_log(LOG_ERROR, "g5_matcher_load_gallery: extract template %d fail, ret = %d", i,
+                   status);
+            gallery_free(matcher);
+            return status != FP_OK ? status : FP_NULL_FEATURE;
+        }
+    }
+
+    matcher->gallery_loaded = TRUE;
+    return FP_OK;
+}
+
+int g5_matcher_identify(g5_matcher_t* matcher, unsigned char* probe, int w, int h,
+                        g5_identify_result_t* result) {
+    const struct verify_init_v2* gallery;
+    g5_template_entry_t* entry = NULL;
+    BYTE* probe_temp = NULL;
+    int probe_temp_size = 0;
+    unsigned long long span;
+    int best_score = -1;
+    int best_accepted = FALSE;
+    int status;
+    int i;
+
+    if (matcher == NULL || !matcher->gallery_loaded) {
+        return FP_STATE_ERR;
+    }
+    if (probe == NULL || result == NULL) {
+        return FP_NULL_DATA;
+    }
+    gallery = &matcher->gallery;
+    result->status = FP_MATCHFAIL;
+    result->match_index = -1;
+    result->match_score = 0;
+    result->rot = result->dx = result->dy = 0;
+
+    span = stage_begin(G5_STAGE_IDENTIFY);
+    g5_arena_begin();
+    status = extract_template(matcher, probe, w, h, &entry, &probe_temp, &probe_temp_size);
+    if (probe_temp == NULL) {
+        g5_arena_end();
+        stage_end(G5_STAGE_IDENTIFY, span);
+        return status != FP_OK ? status : FP_NULL_FEATURE;
+    }
+    // verify_template_v2 leaves the gallery and the context as they are, verify_v2 would
+    // train them with every probe
+    for (i = 0; i < gallery->enroll_temp_number; i++) {
+        struct verify_info_v2 verify_info_data = {0};
+        int match_score = 0;
+        int accepted;
+
+        verify_info_data.match_index = -1;
+        verify_info_data.image_class = FP_IMAGE_TYPE_NORMAL;
+        verify_info_data.latency_adjustment = matcher->session.g_latency_adjustment;
+        verify_info_data.match_score_array = &match_score;
+        status = verify_template_v2(matcher->session.g_ctx, gallery->enroll_temp_array[i],
+                                    gallery->enroll_temp_size_array[i], probe_temp,
+                                    probe_temp_size, &verify_info_data);
+        if (status != FP_MATCHOK && status != FP_MATCHFAIL) {
+            break;
+        }
+        if (result->match_score_array != NULL) {
+            result->match_score_array[i] = verify_info_data.match_score;
+        }
+        // An accepted template wins over any rejected one, then the higher score
+        accepted = status == FP_MATCHOK;
+        if ((accepted && !best_accepted) ||
+            (accepted == best_accepted && verify_info_data.match_score > best_score)) {
+            best_accepted = accepted;
+            best_score = verify_info_data.match_score;
+            result->status = status;
+            result->match_index = accepted ? i : -1;
+            result->match_score = verify_info_data.match_score;
+            get_alignment(&verify_info_data, &result->rot, &result->dx, &result->dy);
+        }
+    }
+    release_template(matcher, entry, probe_temp);
+    g5_arena_end();
+    stage_end(G5_STAGE_IDENTIFY, span);
+    return status == FP_MATCHOK || status == FP_MATCHFAIL ? FP_OK : status;
+}
+
+int g5_matcher_gallery_size(g5_matcher_t* matcher) {
+    if (matcher == NULL || !matcher->gallery_loaded) {
+        return 0;
+    }
+    return matcher->gallery.enroll_temp_number;
+}
+
+void g5_matcher_unload_gallery(g5_matcher_t* matcher) {
+    if (matcher == NULL) {
+        return;
+    }
+    matcher->gallery_loaded = FALSE;
+    gallery_free(matcher);
+}
+
+int g5_matcher_enroll_begin(g5_matcher_t* matcher) {
+    unsigned long long span;
+    int status;
+    if (matcher == NULL || matcher->session.g_ctx == NULL || matcher->gallery_loaded ||
+        matcher->enrolling) {
+        return FP_STATE_ERR;
+    }
+    set_algo_config_v2(matcher->session.g_ctx, FP_OP_MAX_ENROLL_COUNT, matcher->max_enroll_count);
+    span = stage_begin(G5_STAGE_ENROLL_INIT);
+    status = enroll_init_v2(matcher->session.g_ctx, matcher->session.g_enroll_template_size);
+    stage_end(G5_STAGE_ENROLL_INIT, span);
+    if (status != FP_OK) {
+        set_algo_config_v2(matcher->session.g_ctx, FP_OP_MAX_ENROLL_COUNT, 1);
+        return status;
+    }
+    matcher->enrolling = TRUE;
+    matcher->enroll_count = 0;
+    return FP_OK;
+}
+
+int g5_matcher_enroll_add(g5_matcher_t* matcher, unsigned char* raw, int w, int h,
+                          g5_enroll_progress_t* progress) {
+    struct enroll_info_v2 enroll_info = {0};
+    unsigned long long span;
+    int status;
+
+    if (matcher == NULL || !matcher->enrolling) {
+        return FP_STATE_ERR;
+    }
+    if (raw == NULL) {
+        return FP_NULL_DATA;
+    }
+    enroll_info.image = raw;
+    enroll_info.width = w;
+    enroll_info.height = h;
+    enroll_info.image_class = FP_IMAGE_TYPE_NORMAL;
+
+    span = stage_begin(G5_STAGE_ENROLL);
+    status = enroll_v2(matcher->session.g_ctx, &enroll_info);
+    stage_end(G5_STAGE_ENROLL, span);
+    matcher->enroll_count = enroll_info.count;
+
+    if (progress != NULL) {
+        progress->status = status;
+        progress->percentage = enroll_info.percentage;
+        progress->count = enroll_info.count;
+        progress->quality = enroll_info.image_quality_values.fingerprint_quality;
+        progress->coverage = enroll_info.finger_coverage;
+        progress->match_score = enroll_info.match_score;
+    }
+    return status;
+}
+
+int g5_matcher_enroll_finish(g5_matcher_t* matcher, unsigned char** temp, int* temp_size) {
+    unsigned char* enroll_temp = NULL;
+    int enroll_temp_size = 0;
+    int status = FP_OK;
+    unsigned long long span;
+
+    if (matcher == NULL || !matcher->enrolling) {
+        return FP_STATE_ERR;
+    }
+    span = stage_begin(G5_STAGE_ENROLL_FINISH);
+    if (temp != NULL) {
+        *temp = NULL;
+        if (matcher->enroll_count < matcher->max_enroll_count) {
+            enroll_finish_v2(matcher->session.g_ctx);
+        }
+        status = get_enroll_template_v2(matcher->session.g_ctx, &enroll_temp, &enroll_temp_size);
+        if (status == FP_OK && enroll_temp == NULL) {
+            status = FP_NULL_ENROLL_DATA;
+        }
+        if (status == FP_OK) {
+            // The template is owned by the context until enroll_uninit_v2
+            *temp = (unsigned char*)plat_alloc(enroll_temp_size);
+            if (*temp == NULL) {
+                status = FP_ALLOC_MEM_FAIL;
+            } else {
+                memcpy(*temp, enroll_temp, enroll_temp_size);
+                if (temp_size != NULL) {
+                    *temp_size = enroll_temp_size;
+                }
+            }
+        }
+    }
+
+    enroll_uninit_v2(matcher->session.g_ctx);
+    stage_end(G5_STAGE_ENROLL_FINISH, span);
+    set_algo_config_v2(matcher->session.g_ctx, FP_OP_MAX_ENROLL_COUNT, 1);
+    matcher->enrolling = FALSE;
+    return status;
+}
+
+const char* g5_matcher_get_version(g5_matcher_t* matcher) {
+    if (matcher == NULL) {
+        return NULL;
+    }
+    return (const char*)matcher->algo_ver;
+}
+
+void g5_matcher_destroy(g5_matcher_t* matcher) {
+    if (matcher == NULL) {
+        return;
+    }
+    if (matcher->enrolling) {
+        g5_matcher_enroll_finish(matcher, NULL, NULL);
+    }
+    g5_matcher_unload_gallery(matcher);
+    algorithm_uninitialization(matcher);
+    plat_free(matcher);
+    // Matchers are destroyed on the thread that ran them, before it ends
+    g5_arena_release();
+}
+
+/*
+ * Single-threaded API on top of a default matcher. The file-scope g_* settings are
+ * the defaults every new matcher starts from.
+ */
+static g5_matcher_t* open_default_matcher() {
+    g5_matcher_t* matcher = matcher_create(NULL);
+    if (matcher == NULL) {
+        printf("G5 matcher init fail\r\n");
+        return NULL;
+    }
+    if (!g_algo_ver_printed) {
+        memcpy(g_algo_ver, matcher->algo_ver, FP_ALGO_VERSION_LEN);
+        printf("G5 version : matcher(%s) \n", g_algo_ver);
+        g_algo_ver_printed = TRUE;
+    }
+    return matcher;
+}
+
+static void close_default_matcher(g5_matcher_t* matcher) {
+    algorithm_uninitialization(matcher);
+    plat_free(matcher);
+}
+
+static void set_default_algo_info(struct algo_info* algo_info) {
+    if (algo_info->sensor_type != (int)g_sensor_type) {
+        // The default decision data was learned for the former sensor type
+        g5_matcher_set_decision_data(NULL, 0);
+    }
+    g_sensor_type = algo_info->sensor_type;
+    g_resolution = algo_info->resolution;
+    g_radius = algo_info->radius;
+}
+
+int g5_matcher_open(struct algo_info* algo_info) {
+    g5_matcher_close();
+    if (algo_info != NULL) {
+        set_default_algo_info(algo_info);
+    }
+    g_default_matcher = open_default_matcher();
+    return g_default_matcher != NULL ? FP_OK : FP_ERR;
+}
+
+int g5_matcher_reconfigure(struct algo_info* algo_info) {
+    if (algo_info == NULL) {
+        return FP_NULL_DATA;
+    }
+    if (g_default_matcher == NULL) {
+        return g5_matcher_open(algo_info);
+    }
+    set_default_algo_info(algo_info);
+    return g5_matcher_configure(g_default_matcher, algo_info);
+}
+
+void g5_matcher_close(void) {
+    if (g_default_matcher == NULL) {
+        return;
+    }
+    close_default_matcher(g_default_matcher);
+    g_default_matcher = NULL;
+}
+
+void g5_matcher_set_decision_data(unsigned char* decision_data, int decision_data_len) {
+    BYTE* old;
+    decision_lock();
+    old = g_decision_data_owned ? g_decision_data : NULL;
+    g_decision_data = decision_data_len > 0 ? decision_data : NULL;
+    g_decision_data_len = decision_data != NULL && decision_data_len > 0 ? decision_data_len
+                                                                         : 0;
+    g_decision_data_owned = FALSE;
+    decision_unlock();
+    plat_free(old);
+}
+
+void g5_matcher_get_decision_data(unsigned char** decision_data, int* decision_data_len) {
+    decision_lock();
+    *decision_data = g_decision_data;
+    *decision_data_len = g_decision_data_len;
+    decision_unlock();
+}
+
+int g5_matcher_get_default_sensor_type(void) {
+    return (int)g_sensor_type;
+}
+
+int images_compare_(unsigned char** raw1, unsigned char** raw2, int w, int h, int* match_score,
+                    int* rot, int* dx, int* dy) {
+    g5_matcher_t* matcher;
+    int status;
+    if (raw1 == NULL || raw2 == NULL) {
+        printf("Load image file fail\r\n");
+        return FP_NULL_DATA;
+    }
+
+    if (g_default_matcher != NULL) {
+        return g5_matcher_compare(g_default_matcher, raw1[0], raw2[0], w, h, match_score, rot,
+                                  dx, dy);
+    }
+
+    // one-shot: init, compare and uninit
+    matcher = open_default_matcher();
+    if (matcher == NULL) {
+        return FP_ERR;
+    }
+    status = g5_matcher_compare(matcher, raw1[0], raw2[0], w, h, match_score, rot, dx, dy);
+    close_default_matcher(matcher);
+    return status;
 }
 
 // void images_compare_1(BYTE **raw1, BYTE **raw2, unsigned char *mask1,
@@ -398,14 +1169,15 @@ void images_compare_(unsigned char** raw1, unsigned char** raw2, int w, int h, i
 //  return;
 //}
 
-void images_compare_by_algo(unsigned char** raw1, unsigned char** raw2, int w, int h,
-                            int* match_score, int* rot, int* dx, int* dy,
-                            struct algo_info* algo_info) {
-    g_sensor_type = algo_info->sensor_type;
-    g_resolution = algo_info->resolution;
-    g_radius = algo_info->radius;
-    images_compare_(raw1, raw2, w, h, match_score, rot, dx, dy);
-    return;
+int images_compare_by_algo(unsigned char** raw1, unsigned char** raw2, int w, int h,
+                           int* match_score, int* rot, int* dx, int* dy,
+                           struct algo_info* algo_info) {
+    if (g_default_matcher != NULL) {
+        g5_matcher_reconfigure(algo_info);
+    } else {
+        set_default_algo_info(algo_info);
+    }
+    return images_compare_(raw1, raw2, w, h, match_score, rot, dx, dy);
 }
 
 // void images_compare_1_by_algo(BYTE** raw1, BYTE** raw2, unsigned char* mask1, unsigned char*
@@ -7,6 +7,8 @@ extern "C" {
 
 //#include <stdio.h>
 //#include <stdlib.h>
+#include "g5_template_cache.h"
+#include "pb_image_t.h"
 	
 struct algo_info {
     int sensor_type;
@@ -14,12 +16,240 @@ struct algo_info {
     int resolution;
 };
 
-void images_compare_(unsigned char** raw1, unsigned char** raw2, int w, int h, int* match_score,
-                     int* rot, int* dx, int* dy);
+/**
+ * Re-entrant matcher handle.
+ *
+ * Each g5_matcher_t owns its G5 context, configuration and decision data, so
+ * instances can be used side by side (e.g. one per thread or one per sensor type).
+ * A single instance must not be used from several threads at the same time.
+ */
+typedef struct g5_matcher g5_matcher_t;
 
-void images_compare_by_algo(unsigned char** raw1, unsigned char** raw2, int w, int h,
-                            int* match_score, int* rot, int* dx, int* dy,
-                            struct algo_info* algo_info);
+/**
+ * g5_matcher_create
+ *
+ * The context starts from its own copy of the decision data of
+ * g5_matcher_set_decision_data() when it is configured for the default sensor type, and
+ * cold otherwise. g5_matcher_destroy() hands the decision data of the context back as
+ * the default for the matchers created after it.
+ *
+ * @param algo_info
+ *  sensor type, radius and resolution to configure. NULL keeps the defaults.
+ * @return
+ *  the matcher, or NULL if the G5 context could not be initialized.
+ */
+g5_matcher_t* g5_matcher_create(struct algo_info* algo_info);
+
+/**
+ * Apply algo_info to the matcher. Nothing is done when it matches the current
+ * configuration, a changed sensor type reinitializes the context, a changed
+ * resolution or radius is applied with set_algo_config_v2 only.
+ */
+int g5_matcher_configure(g5_matcher_t* matcher, struct algo_info* algo_info);
+
+/**
+ * Compare raw2 against raw1 (w x h 8-bit images).
+ *
+ * @return
+ *  verify_template_v2 status, or an FP_* error code.
+ */
+int g5_matcher_compare(g5_matcher_t* matcher, unsigned char* raw1, unsigned char* raw2, int w,
+                       int h, int* match_score, int* rot, int* dx, int* dy);
+
+/**
+ * @return
+ *  non-zero if status, as returned by g5_matcher_compare(), comes with a score and an
+ *  alignment. Otherwise it is an FP_* error code and they are not set.
+ */
+int g5_matcher_compare_succeeded(int status);
+
+/**
+ * Compare image2 against image1 straight from their pixel buffers, so images created
+ * with pb_image_create_mr() / pb_image_create_mre() around decoded or mapped pixels
+ * reach the matcher without a copy. Both images must have the same size.
+ *
+ * @return
+ *  see g5_matcher_compare().
+ */
+int g5_matcher_compare_images(g5_matcher_t* matcher, const pb_image_t* image1,
+                              const pb_image_t* image2, int* match_score, int* rot, int* dx,
+                              int* dy);
+
+/**
+ * Extract the template of raw (w x h 8-bit image). The template is owned by the
+ * caller and released with g5_matcher_free_template().
+ */
+int g5_matcher_extract(g5_matcher_t* matcher, unsigned char* raw, int w, int h,
+                       unsigned char** temp, int* temp_size);
+
+void g5_matcher_free_template(unsigned char* temp);
+
+/**
+ * Verify temp2 against temp1 with verify_template_v2.
+ *
+ * @return
+ *  FP_MATCHOK or FP_MATCHFAIL at the matcher's FAR ratio, or an FP_* error code.
+ */
+int g5_matcher_verify_templates(g5_matcher_t* matcher, const unsigned char* temp1,
+                                int temp1_size, const unsigned char* temp2, int temp2_size,
+                                int* match_score, int* rot, int* dx, int* dy);
+
+/**
+ * Set the FAR ratio (1/X) used for the match decision, see set_accuracy_level_v2.
+ */
+int g5_matcher_set_far_ratio(g5_matcher_t* matcher, int far_ratio);
+
+/**
+ * Route template extraction of g5_matcher_compare() through cache (NULL to disable).
+ * The cache is not owned by the matcher and may be shared by several matchers; it
+ * must outlive them.
+ */
+void g5_matcher_set_template_cache(g5_matcher_t* matcher, g5_template_cache_t* cache);
+
+/**
+ * 1:N identification result.
+ */
+typedef struct g5_identify_result {
+    int status;       // FP_MATCHOK or FP_MATCHFAIL
+    int match_index;  // gallery index of the best accepted template, -1 when rejected
+    int match_score;  // score of that template, the best score over the gallery if rejected
+    int rot;
+    int dx;
+    int dy;
+    /** Optional, caller-allocated with g5_matcher_gallery_size() entries.
+     *  Receives the score of every gallery template at the default DPI. */
+    int* match_score_array;
+} g5_identify_result_t;
+
+/**
+ * Extract the templates of the gallery images and keep them in the matcher, so that
+ * g5_matcher_identify() only has to extract the probe. Any previous gallery is
+ * unloaded first.
+ *
+ * While a gallery is loaded g5_matcher_compare() and g5_matcher_configure() return
+ * FP_STATE_ERR.
+ *
+ * @param images
+ *  nbr_of_images w x h 8-bit images, index i is reported as match_index i.
+ * @return
+ *  FP_OK, or the extraction / verify_init_v2 error.
+ */
+int g5_matcher_load_gallery(g5_matcher_t* matcher, unsigned char** images, int nbr_of_images,
+                            int w, int h);
+
+/**
+ * Verify probe against every template of the loaded gallery with verify_template_v2.
+ * Identification is read-only: unlike verify_v2 it does not train the gallery or the
+ * context, so the result of a probe does not depend on the probes before it.
+ *
+ * @return
+ *  FP_OK when the probe was verified (accepted or not, see result->status), or an
+ *  FP_* error code.
+ */
+int g5_matcher_identify(g5_matcher_t* matcher, unsigned char* probe, int w, int h,
+                        g5_identify_result_t* result);
+
+/**
+ * @return
+ *  number of templates in the loaded gallery, 0 when none is loaded.
+ */
+int g5_matcher_gallery_size(g5_matcher_t* matcher);
+
+void g5_matcher_unload_gallery(g5_matcher_t* matcher);
+
+/**
+ * Progress of an enrollment after one image, see struct enroll_info_v2.
+ */
+typedef struct g5_enroll_progress {
+    int status;       // enroll_v2 return value
+    int percentage;   // 100 when the multitemplate is complete
+    int count;        // images added to the multitemplate
+    int quality;      // fingerprint quality of the image
+    int coverage;     // finger coverage of all added images, in percent
+    int match_score;  // score against the previously added images
+} g5_enroll_progress_t;
+
+/**
+ * Start enrolling a multitemplate of up to g_max_enroll_count images. Until
+ * g5_matcher_enroll_finish() the matcher only accepts enroll calls.
+ */
+int g5_matcher_enroll_begin(g5_matcher_t* matcher);
+
+/**
+ * Add one w x h 8-bit image to the enrollment.
+ *
+ * @param progress
+ *  receives the enrollment state after this image, may be NULL.
+ * @return
+ *  enroll_v2 status.
+ */
+int g5_matcher_enroll_add(g5_matcher_t* matcher, unsigned char* raw, int w, int h,
+                          g5_enroll_progress_t* progress);
+
+/**
+ * End the enrollment. With temp set, a multitemplate that is not complete yet is
+ * finished with enroll_finish_v2 and a copy is returned, to be released with
+ * g5_matcher_free_template(). With temp NULL the enrollment is dropped.
+ */
+int g5_matcher_enroll_finish(g5_matcher_t* matcher, unsigned char** temp, int* temp_size);
+
+const char* g5_matcher_get_version(g5_matcher_t* matcher);
+
+void g5_matcher_destroy(g5_matcher_t* matcher);
+
+/**
+ * Long-lived default matcher for the single-threaded API below.
+ *
+ * g5_matcher_open() initializes and configures the G5 context once, queries the
+ * matcher version and keeps the context alive so that following calls to
+ * images_compare_() / images_compare_by_algo() only extract and verify.
+ * Without an open matcher images_compare_() falls back to a full init/uninit
+ * cycle per call.
+ *
+ * @param algo_info
+ *  sensor type, radius and resolution to configure. NULL keeps the defaults.
+ */
+int g5_matcher_open(struct algo_info* algo_info);
+
+/**
+ * Reconfigure the open default matcher, see g5_matcher_configure().
+ */
+int g5_matcher_reconfigure(struct algo_info* algo_info);
+
+void g5_matcher_close(void);
+
+/**
+ * Decision data new matchers start from: g5_matcher_open() and g5_matcher_create() for
+ * the default sensor type, e.g. loaded from a g5_decision_store. Each matcher starts
+ * from its own copy, so the data is only read and must stay valid until it is replaced,
+ * by this call or by the data a matcher hands back when it is closed or destroyed. NULL
+ * starts them cold. Changing the default sensor type drops the data.
+ */
+void g5_matcher_set_decision_data(unsigned char* decision_data, int decision_data_len);
+
+/**
+ * The decision data new matchers start from, updated by g5_matcher_close() and
+ * g5_matcher_destroy() with what the matchers of the default sensor type hand back at
+ * algorithm_uninitialization_v2, the last one closed wins. Valid until it is replaced,
+ * read it while no matcher is closed or destroyed.
+ */
+void g5_matcher_get_decision_data(unsigned char** decision_data, int* decision_data_len);
+
+/** Sensor type of the matchers configured without an algo_info. */
+int g5_matcher_get_default_sensor_type(void);
+
+/**
+ * Compare raw2[0] against raw1[0] on the default matcher.
+ *
+ * @return
+ *  see g5_matcher_compare(), FP_ERR if no matcher could be initialized.
+ */
+int images_compare_(unsigned char** raw1, unsigned char** raw2, int w, int h, int* match_score,
+                    int* rot, int* dx, int* dy);
+
+int images_compare_by_algo(unsigned char** raw1, unsigned char** raw2, int w, int h,
+                           int* match_score, int* rot, int* dx, int* dy,
+                           struct algo_info* algo_info);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,237 @@
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+typedef unsigned char BYTE;
+#include "g5_mem.h"
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "plat_log.h"
+#include "plat_thread.h"
+
+#ifdef _MSC_VER
+#define MEM_THREAD_LOCAL __declspec(thread)
+#define heap_block_size(ptr) _msize(ptr)
+#define MEM_INC(p) InterlockedIncrement((volatile LONG*)(p))
+#else
+#define MEM_THREAD_LOCAL __thread
+#define heap_block_size(ptr) malloc_usable_size(ptr)
+#define MEM_INC(p) __sync_add_and_fetch((p), 1)
+#endif
+
+#define MEM_STAGE_DEPTH 16
+
+// Written by the owning thread only, read by g5_mem_get_report() after the run. Counters
+// are registered once per thread and never freed, so a thread can keep its pointer to them.
+typedef struct mem_thread {
+    long long live_bytes;
+    long long peak_bytes;
+    unsigned long long allocs;
+    unsigned long long frees;
+    int stages[MEM_STAGE_DEPTH];
+    int depth;  // may exceed MEM_STAGE_DEPTH, the deeper stages count as the last one kept
+    g5_mem_stage_stats_t stage_stats[G5_MEM_NBR_OF_STAGES];
+} mem_thread_t;
+
+static volatile int g_enabled = 0;
+static mem_thread_t* g_threads[G5_MEM_MAX_THREADS];
+static int g_nbr_of_threads = 0;
+static volatile unsigned long g_untracked = 0;
+static int g_mutex_created = 0;
+static mutex_handle_t g_mutex;
+
+static MEM_THREAD_LOCAL mem_thread_t* tls_thread = NULL;
+static MEM_THREAD_LOCAL int tls_untracked = 0;  // registration failed, do not retry
+
+static mem_thread_t* get_thread(void) {
+    mem_thread_t* thread = tls_thread;
+
+    if (thread != NULL || tls_untracked) {
+        return thread;
+    }
+    plat_mutex_lock(g_mutex);
+    if (g_nbr_of_threads < G5_MEM_MAX_THREADS) {
+        // Not through g5_mem_malloc, the counters do not count themselves
+        thread = (mem_thread_t*)malloc(sizeof(mem_thread_t));
+        if (thread != NULL) {
+            memset(thread, 0, sizeof(mem_thread_t));
+            g_threads[g_nbr_of_threads++] = thread;
+        }
+    }
+    plat_mutex_unlock(g_mutex);
+    tls_thread = thread;
+    tls_untracked = thread == NULL;
+    return thread;
+}
+
+static int size_class(size_t bytes) {
+    int k = 0;
+    while (k < G5_MEM_SIZE_CLASSES - 1 && ((size_t)16 << k) < bytes) {
+        k++;
+    }
+    return k;
+}
+
+static g5_mem_stage_stats_t* current_stage(mem_thread_t* thread) {
+    int stage = G5_MEM_STAGE_OTHER;
+    if (thread->depth > 0) {
+        stage = thread->stages[(thread->depth < MEM_STAGE_DEPTH ? thread->depth
+                                                                 : MEM_STAGE_DEPTH) -
+                               1];
+    }
+    return &thread->stage_stats[stage];
+}
+
+void g5_mem_enable(int enable) {
+    if (enable && !g_mutex_created) {
+        if (plat_mutex_create(&g_mutex) != THREAD_RES_OK) {
+            ex_log(LOG_ERROR, "g5_mem_enable: plat_mutex_create failed");
+            return;
+        }
+        g_mutex_created = 1;
+    }
+    g_enabled = enable != 0;
+}
+
+void g5_mem_reset(void) {
+    int i;
+    if (!g_mutex_created) {
+        return;
+    }
+    plat_mutex_lock(g_mutex);
+    // Zeroed in place, the stage stack is kept for the stages still open
+    for (i = 0; i < g_nbr_of_threads; i++) {
+        mem_thread_t* thread = g_threads[i];
+        thread->live_bytes = 0;
+        thread->peak_bytes = 0;
+        thread->allocs = 0;
+        thread->frees = 0;
+        memset(thread->stage_stats, 0, sizeof(thread->stage_stats));
+    }
+    g_untracked = 0;
+    plat_mutex_unlock(g_mutex);
+}
+
+void g5_mem_on_alloc(size_t bytes) {
+    mem_thread_t* thread;
+    g5_mem_stage_stats_t* stage;
+
+    if (!g_enabled) {
+        return;
+    }
+    if ((thread = get_thread()) == NULL) {
+        MEM_INC(&g_untracked);
+        return;
+    }
+    thread->allocs++;
+    thread->live_bytes += (long long)bytes;
+    if (thread->live_bytes > thread->peak_bytes) {
+        thread->peak_bytes = thread->live_bytes;
+    }
+    stage = current_stage(thread);
+    stage->allocs++;
+    stage->bytes += bytes;
+    stage->size_classes[size_class(bytes)]++;
+    if (thread->live_bytes > stage->peak_live_bytes) {
+        stage->peak_live_bytes = thread->live_bytes;
+    }
+}
+
+void g5_mem_on_free(size_t bytes) {
+    mem_thread_t* thread;
+
+    if (!g_enabled || (thread = get_thread()) == NULL) {
+        return;
+    }
+    thread->frees++;
+    thread->live_bytes -= (long long)bytes;
+    current_stage(thread)->frees++;
+}
+
+void* g5_mem_malloc(size_t size) {
+    void* ptr = malloc(size);
+    if (g_enabled && ptr != NULL) {
+        g5_mem_on_alloc(heap_block_size(ptr));
+    }
+    return ptr;
+}
+
+void g5_mem_free(void* ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (g_enabled) {
+        g5_mem_on_free(heap_block_size(ptr));
+    }
+    free(ptr);
+}
+
+void g5_mem_push_stage(g5_stage_t stage) {
+    mem_thread_t* thread;
+
+    if (!g_enabled || (thread = get_thread()) == NULL) {
+        return;
+    }
+    if (thread->depth < MEM_STAGE_DEPTH) {
+        thread->stages[thread->depth] = stage >= 0 && stage < G5_STAGE_COUNT
+                                            ? (int)stage
+                                            : G5_MEM_STAGE_OTHER;
+    }
+    thread->depth++;
+}
+
+void g5_mem_pop_stage(void) {
+    mem_thread_t* thread;
+
+    // A stage pushed before g5_mem_enable() has no entry to pop
+    if (!g_enabled || (thread = get_thread()) == NULL || thread->depth == 0) {
+        return;
+    }
+    thread->depth--;
+}
+
+void g5_mem_get_report(g5_mem_report_t* report) {
+    int i, s, k;
+
+    memset(report, 0, sizeof(*report));
+    if (!g_mutex_created) {
+        return;
+    }
+    plat_mutex_lock(g_mutex);
+    report->threads = g_nbr_of_threads;
+    report->untracked = g_untracked;
+    for (i = 0; i < g_nbr_of_threads; i++) {
+        const mem_thread_t* thread = g_threads[i];
+        report->allocs += thread->allocs;
+        report->frees += thread->frees;
+        report->live_bytes += thread->live_bytes;
+        report->sum_thread_peaks += thread->peak_bytes;
+        if (thread->peak_bytes > report->max_thread_peak) {
+            report->max_thread_peak = thread->peak_bytes;
+        }
+        for (s = 0; s < G5_MEM_NBR_OF_STAGES; s++) {
+            const g5_mem_stage_stats_t* from = &thread->stage_stats[s];
+            g5_mem_stage_stats_t* to = &report->stages[s];
+            to->allocs += from->allocs;
+            to->frees += from->frees;
+            to->bytes += from->bytes;
+            if (from->peak_live_bytes > to->peak_live_bytes) {
+                to->peak_live_bytes = from->peak_live_bytes;
+            }
+            for (k = 0; k < G5_MEM_SIZE_CLASSES; k++) {
+                to->size_classes[k] += from->size_classes[k];
+            }
+        }
+    }
+    plat_mutex_unlock(g_mutex);
+}
+
+size_t g5_mem_size_class_limit(int size_class) {
+    if (size_class < 0 || size_class >= G5_MEM_SIZE_CLASSES - 1) {
+        return 0;
+    }
+    return (size_t)16 << size_class;
+}
@@ -0,0 +1,93 @@
+#ifndef G5_MEM_H_
+#define G5_MEM_H_
+
+#include <stddef.h>
+
+#include "g5_latency.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Opt-in memory accounting of the matcher.
+ *
+ * While enabled, every block allocated through pb_malloc (the BMF library) or plat_alloc
+ * (g5_match, the template cache and store) is counted by the calling thread: live and
+ * peak bytes, allocations and frees, and per stage of g5_stage_t the allocations by
+ * power-of-two size class. Blocks allocated outside any stage count under "other".
+ *
+ * Each thread counts into its own counters, so no lock is taken once the thread is
+ * registered; g5_mem_get_report() merges them. A block freed on another thread than
+ * it was allocated on lowers the live bytes of the freeing thread, so the per-thread
+ * live bytes may go negative while their sum stays right. When disabled, g5_mem_malloc
+ * and g5_mem_free are malloc and free.
+ */
+
+#define G5_MEM_STAGE_OTHER G5_STAGE_COUNT
+#define G5_MEM_NBR_OF_STAGES (G5_STAGE_COUNT + 1)
+// Up to 16 bytes, up to 32, ... up to 16 MB, above
+#define G5_MEM_SIZE_CLASSES 22
+// Threads ever registered, the counters of ended threads are not reused
+#define G5_MEM_MAX_THREADS 1024
+
+typedef struct g5_mem_stage_stats {
+    unsigned long long allocs;
+    unsigned long long frees;
+    unsigned long long bytes;   // allocated in the stage
+    long long peak_live_bytes;  // highest live bytes of a thread while in the stage
+    unsigned long long size_classes[G5_MEM_SIZE_CLASSES];
+} g5_mem_stage_stats_t;
+
+typedef struct g5_mem_report {
+    int threads;
+    unsigned long long allocs;
+    unsigned long long frees;
+    long long live_bytes;           // all threads, when the report was taken
+    long long max_thread_peak;      // highest peak of one thread
+    long long sum_thread_peaks;     // upper bound of the peak of all threads together
+    unsigned long long untracked;   // blocks of threads beyond G5_MEM_MAX_THREADS
+    g5_mem_stage_stats_t stages[G5_MEM_NBR_OF_STAGES];
+} g5_mem_report_t;
+
+/**
+ * Start (enable != 0) or stop counting. Blocks allocated while disabled and freed
+ * while enabled lower the live bytes.
+ */
+void g5_mem_enable(int enable);
+
+/**
+ * Zero all counters. The counters stay registered, so threads that are still running
+ * keep valid ones, but call it while no matcher thread allocates: a block counted
+ * meanwhile may be lost from the new counts.
+ */
+void g5_mem_reset(void);
+
+void* g5_mem_malloc(size_t size);
+void g5_mem_free(void* ptr);
+
+/** Count a block that does not come from malloc, e.g. from the arena. */
+void g5_mem_on_alloc(size_t bytes);
+void g5_mem_on_free(size_t bytes);
+
+/** Attribute the following allocations of the calling thread to stage, stages nest. */
+void g5_mem_push_stage(g5_stage_t stage);
+void g5_mem_pop_stage(void);
+
+/**
+ * Merge the counters of all threads. Threads that are still allocating are read
+ * without synchronization, take the report after the run.
+ */
+void g5_mem_get_report(g5_mem_report_t* report);
+
+/**
+ * @return
+ *  the largest size in bytes of size_class, 0 for the last class (above 16 MB).
+ */
+size_t g5_mem_size_class_limit(int size_class);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
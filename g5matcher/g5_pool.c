@@ -0,0 +1,519 @@
+typedef unsigned char BYTE;
+#include "g5_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "EgisAlgorithmApiV2.h"
+#include "g5_trace.h"
+#include "pb_timestamp.h"
+#include "plat_log.h"
+#include "plat_thread.h"
+
+#ifndef plat_alloc
+#define plat_alloc(fmt) malloc(fmt)
+#endif
+
+#ifndef PLAT_FREE
+#define PLAT_FREE(x) \
+    if (x != NULL) { \
+        free(x);     \
+        x = NULL;    \
+    }
+#endif
+
+#ifdef _MSC_VER
+#define POOL_THREAD_LOCAL __declspec(thread)
+#else
+#define POOL_THREAD_LOCAL __thread
+#endif
+
+#define POOL_MAX_WORKERS 256
+#define POOL_MAX_TOKENS 0x7FFFFFFF
+#define POOL_DEQUE_INITIAL_CAPACITY 64
+// How often a worker waiting on a group looks for tasks to help with
+#define POOL_HELP_POLL_US 1000
+
+typedef struct pool_task {
+    g5_pool_task_fn fn;
+    g5_pool_range_fn range_fn;  // set for parallel-for parts instead of fn
+    void* arg;
+    int begin;
+    int end;
+    int grain;
+    g5_pool_group_t* group;
+} pool_task_t;
+
+// Ring buffer of tasks, the owner works at the bottom and thieves take from the top.
+// Tasks are whole comparisons, so a mutex per deque costs nothing measurable.
+typedef struct pool_deque {
+    mutex_handle_t mutex;
+    pool_task_t** tasks;
+    int capacity;
+    int top;
+    int count;
+} pool_deque_t;
+
+typedef struct pool_worker {
+    g5_pool_t* pool;
+    int index;
+    thread_handle_t thread;
+    thread_param_t param;
+    pool_deque_t deque;
+    void* data;
+    g5_pool_worker_stats_t stats;  // written by the worker only
+} pool_worker_t;
+
+struct g5_pool {
+    pool_worker_t* workers;
+    int nbr_of_workers;
+    g5_pool_worker_init_fn init;
+    g5_pool_worker_exit_fn exit;
+    void* ctx;
+    // One token per queued task, a worker takes a token before it takes a task
+    semaphore_handle_t work;
+    mutex_handle_t state_mutex;
+    int stop;
+    int next_inject;
+};
+
+struct g5_pool_group {
+    mutex_handle_t mutex;
+    semaphore_handle_t done;
+    int pending;
+};
+
+static POOL_THREAD_LOCAL pool_worker_t* tls_worker = NULL;
+
+static long elapsed_us(const pb_timestamp_t* start, const pb_timestamp_t* end) {
+    return (end->sec - start->sec) * 1000000L + (end->usec - start->usec);
+}
+
+static int deque_init(pool_deque_t* deque) {
+    memset(deque, 0, sizeof(*deque));
+    deque->tasks = (pool_task_t**)plat_alloc(POOL_DEQUE_INITIAL_CAPACITY * sizeof(pool_task_t*));
+    if (deque->tasks == NULL) {
+        return FP_ALLOC_MEM_FAIL;
+    }
+    deque->capacity = POOL_DEQUE_INITIAL_CAPACITY;
+    if (plat_mutex_create(&deque->mutex) != THREAD_RES_OK) {
+        PLAT_FREE(deque->tasks);
+        return FP_ERR;
+    }
+    return FP_OK;
+}
+
+static void deque_free(pool_deque_t* deque) {
+    plat_mutex_release(&deque->mutex);
+    PLAT_FREE(deque->tasks);
+}
+
+static int deque_push_bottom(pool_deque_t* deque, pool_task_t* task) {
+    int ret = FP_OK;
+    plat_mutex_lock(deque->mutex);
+    if (deque->count == deque->capacity) {
+        pool_task_t** tasks =
+            (pool_task_t**)plat_alloc(2 * deque->capacity * sizeof(pool_task_t*));
+        if (tasks == NULL) {
+            ret = FP_ALLOC_MEM_FAIL;
+        } else {
+            int i;
+            for (i = 0; i < deque->count; i++) {
+                tasks[i] = deque->tasks[(deque->top + i) % deque->capacity];
+            }
+            PLAT_FREE(deque->tasks);
+            deque->tasks = tasks;
+            deque->capacity *= 2;
+            deque->top = 0;
+        }
+    }
+    if (ret == FP_OK) {
+        deque->tasks[(deque->top + deque->count) % deque->capacity] = task;
+        deque->count++;
+    }
+    plat_mutex_unlock(deque->mutex);
+    return ret;
+}
+
+static pool_task_t* deque_pop_bottom(pool_deque_t* deque) {
+    pool_task_t* task = NULL;
+    plat_mutex_lock(deque->mutex);
+    if (deque->count > 0) {
+        deque->count--;
+        task = deque->tasks[(deque->top + deque->count) % deque->capacity];
+    }
+    plat_mutex_unlock(deque->mutex);
+    return task;
+}
+
+static pool_task_t* deque_steal_top(pool_deque_t* deque) {
+    pool_task_t* task = NULL;
+    plat_mutex_lock(deque->mutex);
+    if (deque->count > 0) {
+        task = deque->tasks[deque->top];
+        deque->top = (deque->top + 1) % deque->capacity;
+        deque->count--;
+    }
+    plat_mutex_unlock(deque->mutex);
+    return task;
+}
+
+static void group_add(g5_pool_group_t* group) {
+    plat_mutex_lock(group->mutex);
+    group->pending++;
+    plat_mutex_unlock(group->mutex);
+}
+
+static void group_done(g5_pool_group_t* group) {
+    plat_mutex_lock(group->mutex);
+    // posted under the lock, a waiter that sees pending 0 may free the group at once
+    if (--group->pending == 0) {
+        plat_semaphore_post(group->done);
+    }
+    plat_mutex_unlock(group->mutex);
+}
+
+static int group_pending(g5_pool_group_t* group) {
+    int pending;
+    plat_mutex_lock(group->mutex);
+    pending = group->pending;
+    plat_mutex_unlock(group->mutex);
+    return pending;
+}
+
+static int is_stopping(g5_pool_t* pool) {
+    int stop;
+    plat_mutex_lock(pool->state_mutex);
+    stop = pool->stop;
+    plat_mutex_unlock(pool->state_mutex);
+    return stop;
+}
+
+static pool_worker_t* current_worker(g5_pool_t* pool) {
+    return tls_worker != NULL && tls_worker->pool == pool ? tls_worker : NULL;
+}
+
+// Own deque first, newest task first, then the oldest task of the other workers
+static pool_task_t* find_task(pool_worker_t* worker) {
+    g5_pool_t* pool = worker->pool;
+    pool_task_t* task = deque_pop_bottom(&worker->deque);
+    int i;
+    for (i = 1; task == NULL && i < pool->nbr_of_workers; i++) {
+        task = deque_steal_top(&pool->workers[(worker->index + i) % pool->nbr_of_workers].deque);
+        if (task != NULL) {
+            worker->stats.steals++;
+        }
+    }
+    return task;
+}
+
+// Called with a work token held, so a task is queued for the caller unless the pool stops
+static pool_task_t* take_task(pool_worker_t* worker) {
+    for (;;) {
+        pool_task_t* task = find_task(worker);
+        if (task != NULL) {
+            return task;
+        }
+        if (is_stopping(worker->pool)) {
+            return NULL;
+        }
+    }
+}
+
+static int push_task(g5_pool_t* pool, pool_task_t* task) {
+    pool_worker_t* worker = current_worker(pool);
+    int target;
+
+    if (worker != NULL) {
+        target = worker->index;
+    } else {
+        plat_mutex_lock(pool->state_mutex);
+        target = pool->next_inject;
+        pool->next_inject = (pool->next_inject + 1) % pool->nbr_of_workers;
+        plat_mutex_unlock(pool->state_mutex);
+    }
+    // counted before it is visible, a thief may finish it right away
+    group_add(task->group);
+    if (deque_push_bottom(&pool->workers[target].deque, task) != FP_OK) {
+        group_done(task->group);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    plat_semaphore_post(pool->work);
+    return FP_OK;
+}
+
+static int push_range(g5_pool_t* pool, g5_pool_group_t* group, g5_pool_range_fn fn, void* arg,
+                      int begin, int end, int grain) {
+    pool_task_t* task = (pool_task_t*)plat_alloc(sizeof(pool_task_t));
+    if (task == NULL) {
+        return FP_ALLOC_MEM_FAIL;
+    }
+    memset(task, 0, sizeof(*task));
+    task->range_fn = fn;
+    task->arg = arg;
+    task->begin = begin;
+    task->end = end;
+    task->grain = grain;
+    task->group = group;
+    if (push_task(pool, task) != FP_OK) {
+        PLAT_FREE(task);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    return FP_OK;
+}
+
+static void run_task(pool_worker_t* worker, pool_task_t* task) {
+    pb_timestamp_t start, end;
+    G5_TRACE_BEGIN("task");
+    pb_timestamp_now(&start);
+    if (task->range_fn != NULL) {
+        // Leave the upper halves to thieves until the part is small enough
+        while (task->end - task->begin > task->grain) {
+            int mid = task->begin + (task->end - task->begin) / 2;
+            if (push_range(worker->pool, task->group, task->range_fn, task->arg, mid, task->end,
+                           task->grain) != FP_OK) {
+                break;
+            }
+            task->end = mid;
+        }
+        task->range_fn(task->arg, task->begin, task->end);
+    } else {
+        task->fn(task->arg);
+    }
+    pb_timestamp_now(&end);
+    G5_TRACE_END("task");
+    worker->stats.tasks++;
+    worker->stats.busy_us += elapsed_us(&start, &end);
+    group_done(task->group);
+    PLAT_FREE(task);
+}
+
+static int pool_worker_routine(void* arg) {
+    pool_worker_t* worker = (pool_worker_t*)((thread_param_t*)arg)->params;
+    g5_pool_t* pool = worker->pool;
+
+    tls_worker = worker;
+    g5_trace_set_thread_name("pool worker", worker->index);
+    if (pool->init != NULL) {
+        worker->data = pool->init(pool->ctx, worker->index);
+    }
+    for (;;) {
+        pool_task_t* task;
+        plat_semaphore_wait(pool->work, -1);
+        task = take_task(worker);
+        if (task == NULL) {
+            break;
+        }
+        run_task(worker, task);
+    }
+    if (pool->exit != NULL) {
+        pool->exit(pool->ctx, worker->index, worker->data);
+    }
+    tls_worker = NULL;
+    return 0;
+}
+
+g5_pool_t* g5_pool_create(int nbr_of_workers, g5_pool_worker_init_fn init,
+                          g5_pool_worker_exit_fn exit, void* ctx) {
+    g5_pool_t* pool;
+    int i;
+
+    if (nbr_of_workers <= 0) {
+        nbr_of_workers = 1;
+    }
+    if (nbr_of_workers > POOL_MAX_WORKERS) {
+        nbr_of_workers = POOL_MAX_WORKERS;
+    }
+    pool = (g5_pool_t*)plat_alloc(sizeof(g5_pool_t));
+    if (pool == NULL) {
+        return NULL;
+    }
+    memset(pool, 0, sizeof(*pool));
+    pool->init = init;
+    pool->exit = exit;
+    pool->ctx = ctx;
+    pool->workers = (pool_worker_t*)plat_alloc(nbr_of_workers * sizeof(pool_worker_t));
+    if (pool->workers == NULL) {
+        PLAT_FREE(pool);
+        return NULL;
+    }
+    memset(pool->workers, 0, nbr_of_workers * sizeof(pool_worker_t));
+    if (plat_semaphore_create(&pool->work, 0, POOL_MAX_TOKENS) != THREAD_RES_OK ||
+        plat_mutex_create(&pool->state_mutex) != THREAD_RES_OK) {
+        g5_pool_destroy(pool);
+        return NULL;
+    }
+
+    for (i = 0; i < nbr_of_workers; i++) {
+        pool_worker_t* worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        worker->param.params = worker;
+        if (deque_init(&worker->deque) != FP_OK) {
+            break;
+        }
+        // counted first, so that g5_pool_destroy() cleans up a partly started pool
+        pool->nbr_of_workers++;
+        if (plat_thread_create_ex(&worker->thread, (void*)pool_worker_routine,
+                                  &worker->param) != THREAD_RES_OK) {
+            break;
+        }
+    }
+    if (i < nbr_of_workers) {
+        ex_log(LOG_ERROR, "g5_pool_create: only %d of %d workers started", i, nbr_of_workers);
+        g5_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void g5_pool_destroy(g5_pool_t* pool) {
+    int i;
+    if (pool == NULL) {
+        return;
+    }
+    if (pool->state_mutex.mutex != NULL) {
+        plat_mutex_lock(pool->state_mutex);
+        pool->stop = 1;
+        plat_mutex_unlock(pool->state_mutex);
+    }
+    for (i = 0; i < pool->nbr_of_workers; i++) {
+        plat_semaphore_post(pool->work);
+    }
+    for (i = 0; i < pool->nbr_of_workers; i++) {
+        if (pool->workers[i].thread.hwin != NULL) {
+            plat_thread_release(&pool->workers[i].thread);
+        }
+    }
+    // only now, the workers still running looked into every deque
+    for (i = 0; i < pool->nbr_of_workers; i++) {
+        deque_free(&pool->workers[i].deque);
+    }
+    plat_semaphore_release(&pool->work);
+    plat_mutex_release(&pool->state_mutex);
+    PLAT_FREE(pool->workers);
+    PLAT_FREE(pool);
+}
+
+int g5_pool_nbr_of_workers(g5_pool_t* pool) {
+    return pool != NULL ? pool->nbr_of_workers : 0;
+}
+
+g5_pool_group_t* g5_pool_group_create(void) {
+    g5_pool_group_t* group = (g5_pool_group_t*)plat_alloc(sizeof(g5_pool_group_t));
+    if (group == NULL) {
+        return NULL;
+    }
+    memset(group, 0, sizeof(*group));
+    if (plat_mutex_create(&group->mutex) != THREAD_RES_OK ||
+        plat_semaphore_create(&group->done, 0, 1) != THREAD_RES_OK) {
+        g5_pool_group_destroy(group);
+        return NULL;
+    }
+    return group;
+}
+
+void g5_pool_group_destroy(g5_pool_group_t* group) {
+    if (group == NULL) {
+        return;
+    }
+    plat_semaphore_release(&group->done);
+    plat_mutex_release(&group->mutex);
+    PLAT_FREE(group);
+}
+
+int g5_pool_submit(g5_pool_t* pool, g5_pool_group_t* group, g5_pool_task_fn fn, void* arg) {
+    pool_task_t* task;
+    if (pool == NULL || group == NULL || fn == NULL) {
+        return FP_NULL_DATA;
+    }
+    task = (pool_task_t*)plat_alloc(sizeof(pool_task_t));
+    if (task == NULL) {
+        return FP_ALLOC_MEM_FAIL;
+    }
+    memset(task, 0, sizeof(*task));
+    task->fn = fn;
+    task->arg = arg;
+    task->group = group;
+    if (push_task(pool, task) != FP_OK) {
+        PLAT_FREE(task);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    return FP_OK;
+}
+
+void g5_pool_wait(g5_pool_t* pool, g5_pool_group_t* group) {
+    pool_worker_t* worker = current_worker(pool);
+    if (pool == NULL || group == NULL) {
+        return;
+    }
+    while (group_pending(group) > 0) {
+        if (worker == NULL) {
+            // done may hold a stale post from an earlier wait, pending is checked again
+            plat_semaphore_wait(group->done, -1);
+        } else if (plat_semaphore_wait(pool->work, 0) == THREAD_RES_OK) {
+            pool_task_t* task = take_task(worker);
+            if (task != NULL) {
+                run_task(worker, task);
+            }
+        } else {
+            plat_semaphore_wait(group->done, POOL_HELP_POLL_US);
+        }
+    }
+}
+
+int g5_pool_parallel_for(g5_pool_t* pool, int begin, int end, int grain, g5_pool_range_fn fn,
+                         void* arg) {
+    g5_pool_group_t* group;
+    int nbr_of_parts;
+    int ret = FP_OK;
+    int i;
+
+    if (pool == NULL || fn == NULL) {
+        return FP_NULL_DATA;
+    }
+    if (end <= begin) {
+        return FP_OK;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+    group = g5_pool_group_create();
+    if (group == NULL) {
+        return FP_ALLOC_MEM_FAIL;
+    }
+
+    // From outside give every worker a part of its own to start on, from inside a task
+    // the other workers steal from the split halves
+    nbr_of_parts = current_worker(pool) != NULL ? 1 : pool->nbr_of_workers;
+    if (nbr_of_parts > end - begin) {
+        nbr_of_parts = end - begin;
+    }
+    for (i = 0; i < nbr_of_parts && ret == FP_OK; i++) {
+        int part_begin = begin + (int)((long long)(end - begin) * i / nbr_of_parts);
+        int part_end = begin + (int)((long long)(end - begin) * (i + 1) / nbr_of_parts);
+        ret = push_range(pool, group, fn, arg, part_begin, part_end, grain);
+    }
+    g5_pool_wait(pool, group);
+    g5_pool_group_destroy(group);
+    return ret;
+}
+
+void* g5_pool_worker_data(void) {
+    return tls_worker != NULL ? tls_worker->data : NULL;
+}
+
+int g5_pool_worker_index(void) {
+    return tls_worker != NULL ? tls_worker->index : -1;
+}
+
+void g5_pool_get_worker_stats(g5_pool_t* pool, int worker, g5_pool_worker_stats_t* stats) {
+    if (stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (pool == NULL || worker < 0 || worker >= pool->nbr_of_workers) {
+        return;
+    }
+    *stats = pool->workers[worker].stats;
+}
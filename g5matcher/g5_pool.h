@@ -0,0 +1,104 @@
+#ifndef G5_POOL_H_
+#define G5_POOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Work-stealing task pool on plat_thread.
+ *
+ * Every worker owns a deque of tasks. A task submitted from a worker is pushed on the
+ * bottom of that worker's deque and the worker pops from the bottom (newest first),
+ * while idle workers steal from the top (oldest first) of the others. Tasks submitted
+ * from any other thread are spread round-robin over the deques. Comparison costs vary
+ * a lot between images, so this keeps all workers busy where a static split leaves
+ * some idle behind a slow share.
+ *
+ * Each worker runs init on its own thread before taking tasks and keeps the returned
+ * data (e.g. its g5_matcher_t) in thread-local storage, see g5_pool_worker_data().
+ */
+typedef struct g5_pool g5_pool_t;
+
+/** Wait group, counts the tasks submitted with it that have not finished yet. */
+typedef struct g5_pool_group g5_pool_group_t;
+
+typedef void* (*g5_pool_worker_init_fn)(void* ctx, int worker);
+typedef void (*g5_pool_worker_exit_fn)(void* ctx, int worker, void* data);
+typedef void (*g5_pool_task_fn)(void* arg);
+/** Processes the indices begin .. end - 1. */
+typedef void (*g5_pool_range_fn)(void* arg, int begin, int end);
+
+typedef struct g5_pool_worker_stats {
+    unsigned long long tasks;   // tasks run, including the split parts of parallel-for
+    unsigned long long steals;  // tasks taken from another worker's deque
+    long long busy_us;          // time spent running tasks
+} g5_pool_worker_stats_t;
+
+/**
+ * g5_pool_create
+ *
+ * @param init
+ *  called on each worker thread before it takes tasks, may be NULL. The returned data
+ *  is passed to exit when the pool is destroyed.
+ * @param exit
+ *  called on each worker thread before it ends, may be NULL.
+ * @return
+ *  the pool, or NULL if it could not be created.
+ */
+g5_pool_t* g5_pool_create(int nbr_of_workers, g5_pool_worker_init_fn init,
+                          g5_pool_worker_exit_fn exit, void* ctx);
+
+/**
+ * Stop and join the workers. All submitted tasks must have been waited for.
+ */
+void g5_pool_destroy(g5_pool_t* pool);
+
+int g5_pool_nbr_of_workers(g5_pool_t* pool);
+
+g5_pool_group_t* g5_pool_group_create(void);
+void g5_pool_group_destroy(g5_pool_group_t* group);
+
+/**
+ * Queue fn(arg) as part of group. May be called from inside a task.
+ *
+ * @return
+ *  FP_OK or FP_ALLOC_MEM_FAIL.
+ */
+int g5_pool_submit(g5_pool_t* pool, g5_pool_group_t* group, g5_pool_task_fn fn, void* arg);
+
+/**
+ * Block until every task of group has finished. A worker waiting from inside a task
+ * runs queued tasks meanwhile, so tasks may wait for tasks they submitted.
+ */
+void g5_pool_wait(g5_pool_t* pool, g5_pool_group_t* group);
+
+/**
+ * Run fn over begin .. end - 1 and wait for it. The range is split in halves on demand
+ * until a part holds at most grain indices, so idle workers steal large parts first.
+ *
+ * @return
+ *  FP_OK or FP_ALLOC_MEM_FAIL, in which case part of the range may have been run.
+ */
+int g5_pool_parallel_for(g5_pool_t* pool, int begin, int end, int grain, g5_pool_range_fn fn,
+                         void* arg);
+
+/**
+ * @return
+ *  the init data of the worker running the calling thread, NULL outside the workers.
+ */
+void* g5_pool_worker_data(void);
+
+/**
+ * @return
+ *  index of the worker running the calling thread, -1 outside the workers.
+ */
+int g5_pool_worker_index(void);
+
+void g5_pool_get_worker_stats(g5_pool_t* pool, int worker, g5_pool_worker_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
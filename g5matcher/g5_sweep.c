@@ -0,0 +1,157 @@
+typedef unsigned char BYTE;
+#include "g5_sweep.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "EgisAlgorithmApiV2.h"
+#include "model_config.h"
+#include "pb_timestamp.h"
+#include "plat_log.h"
+
+#ifndef plat_alloc
+#define plat_alloc(fmt) malloc(fmt)
+#endif
+
+#ifndef PLAT_FREE
+#define PLAT_FREE(x) \
+    if (x != NULL) { \
+        free(x);     \
+        x = NULL;    \
+    }
+#endif
+
+static long elapsed_us(const pb_timestamp_t* start, const pb_timestamp_t* end) {
+    return (end->sec - start->sec) * 1000000L + (end->usec - start->usec);
+}
+
+static void model_from_profile(const model_profile_t* profile, g5_sweep_model_t* model) {
+    const threshold_manager_t* th = &profile->thresholds;
+    memset(model, 0, sizeof(*model));
+    model->name = profile->name;
+    model->algo_info.sensor_type = th->matcher_g5_algo_type;
+    model->algo_info.resolution = th->matcher_g5_dpi;
+    model->algo_info.radius = th->matcher_g5_radius;
+    model->far_ratio = th->normal_far_ratio;
+}
+
+int g5_sweep_nbr_of_models(void) {
+    return MODEL_END;
+}
+
+int g5_sweep_model_by_index(int index, g5_sweep_model_t* model) {
+    const model_profile_t* profiles;
+    int count;
+    if (model == NULL) {
+        return FP_NULL_DATA;
+    }
+    profiles = get_model_profiles(&count);
+    if (index < 0 || index >= MODEL_END || index >= count) {
+        return FP_PARAMETER_NOT_VALID;
+    }
+    model_from_profile(&profiles[index], model);
+    return FP_OK;
+}
+
+int g5_sweep_model_by_name(const char* name, g5_sweep_model_t* model) {
+    const model_profile_t* profile;
+    if (model == NULL) {
+        return FP_NULL_DATA;
+    }
+    profile = get_model_profile(name);
+    if (profile == NULL) {
+        return FP_PARAMETER_NOT_VALID;
+    }
+    model_from_profile(profile, model);
+    return FP_OK;
+}
+
+// Models with equal settings get equal scores, the FAR ratio only picks the threshold
+static int same_scores(const struct algo_info* a, const struct algo_info* b) {
+    return a->sensor_type == b->sensor_type && a->resolution == b->resolution &&
+           a->radius == b->radius;
+}
+
+int g5_sweep_run(const g5_eval_sample_t* samples, int w, int h, const g5_eval_pair_t* pairs,
+                 int nbr_of_pairs, const g5_sweep_model_t* models, int nbr_of_models,
+                 int nbr_of_threads, g5_template_cache_t* cache, g5_sweep_result_t* result) {
+    int* group_model;  // first model of each group
+    int ret = FP_OK;
+    int i, g;
+
+    if (samples == NULL || pairs == NULL || models == NULL || result == NULL ||
+        nbr_of_models <= 0) {
+        return FP_NULL_DATA;
+    }
+    memset(result, 0, sizeof(*result));
+    result->nbr_of_models = nbr_of_models;
+    result->model_group = (int*)plat_alloc(nbr_of_models * sizeof(int));
+    result->group_result = (g5_eval_result_t*)plat_alloc(nbr_of_models * sizeof(g5_eval_result_t));
+    result->group_time_us = (long*)plat_alloc(nbr_of_models * sizeof(long));
+    group_model = (int*)plat_alloc(nbr_of_models * sizeof(int));
+    if (result->model_group == NULL || result->group_result == NULL ||
+        result->group_time_us == NULL || group_model == NULL) {
+        PLAT_FREE(group_model);
+        g5_sweep_result_free(result);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    memset(result->group_result, 0, nbr_of_models * sizeof(g5_eval_result_t));
+    memset(result->group_time_us, 0, nbr_of_models * sizeof(long));
+
+    for (i = 0; i < nbr_of_models; i++) {
+        for (g = 0; g < result->nbr_of_groups; g++) {
+            if (same_scores(&models[group_model[g]].algo_info, &models[i].algo_info)) {
+                break;
+            }
+        }
+        if (g == result->nbr_of_groups) {
+            group_model[result->nbr_of_groups++] = i;
+        }
+        result->model_group[i] = g;
+    }
+
+    for (g = 0; g < result->nbr_of_groups && ret == FP_OK; g++) {
+        struct algo_info algo_info = models[group_model[g]].algo_info;
+        pb_timestamp_t start, end;
+        pb_timestamp_now(&start);
+        ret = g5_eval_run(samples, w, h, pairs, nbr_of_pairs, &algo_info, nbr_of_threads, cache,
+                          &result->group_result[g]);
+        pb_timestamp_now(&end);
+        result->group_time_us[g] = elapsed_us(&start, &end);
+        if (ret != FP_OK) {
+            ex_log(LOG_ERROR, "g5_sweep_run: %s failed, ret = %d", models[group_model[g]].name,
+                   ret);
+        }
+    }
+
+    PLAT_FREE(group_model);
+    if (ret != FP_OK) {
+        g5_sweep_result_free(result);
+    }
+    return ret;
+}
+
+void g5_sweep_result_free(g5_sweep_result_t* result) {
+    int g;
+    if (result == NULL) {
+        return;
+    }
+    if (result->group_result != NULL) {
+        for (g = 0; g < result->nbr_of_groups; g++) {
+            g5_eval_result_free(&result->group_result[g]);
+        }
+    }
+    PLAT_FREE(result->model_group);
+    PLAT_FREE(result->group_result);
+    PLAT_FREE(result->group_time_us);
+    result->nbr_of_models = 0;
+    result->nbr_of_groups = 0;
+}
+
+const g5_eval_result_t* g5_sweep_model_result(const g5_sweep_result_t* result, int model) {
+    if (result == NULL || result->model_group == NULL || model < 0 ||
+        model >= result->nbr_of_models) {
+        return NULL;
+    }
+    return &result->group_result[result->model_group[model]];
+}
@@ -0,0 +1,85 @@
+#ifndef G5_SWEEP_H_
+#define G5_SWEEP_H_
+
+#include "g5_eval.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Multi-model threshold sweep.
+ *
+ * Evaluates one dataset and protocol under the matcher settings of several phone
+ * models. Models whose sensor type, resolution and radius are equal produce the same
+ * scores, so they are grouped and each group is run once with g5_eval_run(). The
+ * decoded images and the pair list are shared by all groups, and a template cache
+ * passed in is shared too (its key includes the extraction settings), so an image is
+ * extracted at most once per distinct configuration.
+ *
+ * The models come from the profiles of model_config.c, so a sweep always runs with the
+ * thresholds the matcher is configured with for the model.
+ */
+
+typedef struct g5_sweep_model {
+    const char* name;
+    struct algo_info algo_info;  // as set by init_model_setting for the model
+    int far_ratio;               // the model's FAR 1/X, 0 for none
+} g5_sweep_model_t;
+
+/** @return the number of phone models, without the aliases of model_config.c. */
+int g5_sweep_nbr_of_models(void);
+
+/**
+ * Fill model with the settings init_model_setting applies for a phone model: sensor type,
+ * resolution and radius from the THRESHOLDS_BY_MODEL thresholds of its profile, and its
+ * normal FAR ratio. The name points to the constant profile.
+ *
+ * @param index
+ *  0 .. g5_sweep_nbr_of_models() - 1, in the order of enum model_type.
+ * @return
+ *  FP_OK or FP_PARAMETER_NOT_VALID.
+ */
+int g5_sweep_model_by_index(int index, g5_sweep_model_t* model);
+
+/**
+ * As g5_sweep_model_by_index() for the profile named name, e.g. "MODEL_A51", case
+ * insensitive. Aliases are accepted.
+ */
+int g5_sweep_model_by_name(const char* name, g5_sweep_model_t* model);
+
+typedef struct g5_sweep_result {
+    int nbr_of_models;
+    int nbr_of_groups;
+    int* model_group;                // group index of each model
+    g5_eval_result_t* group_result;  // histograms of each group
+    long* group_time_us;             // g5_eval_run time of each group
+} g5_sweep_result_t;
+
+/**
+ * g5_sweep_run
+ *
+ * @param samples, w, h, pairs, nbr_of_pairs, nbr_of_threads, cache
+ *  see g5_eval_run().
+ * @param result
+ *  receives the groups and their histograms, free with g5_sweep_result_free().
+ * @return
+ *  FP_OK or the first g5_eval_run() error.
+ */
+int g5_sweep_run(const g5_eval_sample_t* samples, int w, int h, const g5_eval_pair_t* pairs,
+                 int nbr_of_pairs, const g5_sweep_model_t* models, int nbr_of_models,
+                 int nbr_of_threads, g5_template_cache_t* cache, g5_sweep_result_t* result);
+
+void g5_sweep_result_free(g5_sweep_result_t* result);
+
+/**
+ * @return
+ *  the histograms model was evaluated with, shared with the other models of its group.
+ */
+const g5_eval_result_t* g5_sweep_model_result(const g5_sweep_result_t* result, int model);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,352 @@
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+typedef unsigned char BYTE;
+#include "g5_template_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "g5_mem.h"
+#include "plat_thread.h"
+
+#ifndef plat_alloc
+#define plat_alloc(fmt) g5_mem_malloc(fmt)
+#endif
+
+#ifndef plat_free
+#define plat_free(x) g5_mem_free(x)
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifdef _MSC_VER
+#define CACHE_LOAD(p) InterlockedCompareExchange((volatile LONG*)(p), 0, 0)
+#define CACHE_STORE(p, v) InterlockedExchange((volatile LONG*)(p), (v))
+#define CACHE_INC(p) InterlockedIncrement((volatile LONG*)(p))
+#define CACHE_DEC(p) InterlockedDecrement((volatile LONG*)(p))
+#define CACHE_LOAD64(p) InterlockedCompareExchange64((volatile LONGLONG*)(p), 0, 0)
+#define CACHE_INC64(p) InterlockedIncrement64((volatile LONGLONG*)(p))
+#else
+#define CACHE_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define CACHE_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define CACHE_INC(p) __sync_add_and_fetch((p), 1)
+#define CACHE_DEC(p) __sync_sub_and_fetch((p), 1)
+#define CACHE_LOAD64(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define CACHE_INC64(p) __sync_add_and_fetch((p), 1)
+#endif
+
+#define TEMPLATE_CACHE_DEFAULT_BUCKETS 4096
+
+// The pixels of the key follow the entry in the same allocation, key.pixels points to them.
+struct g5_template_entry {
+    g5_template_key_t key;
+    unsigned char* temp;
+    int temp_size;
+    volatile long ref_count;
+    volatile long referenced;  // looked up since the eviction scan last passed it
+    int cached;                // set before the entry is published, never changes after
+    struct g5_template_entry* hash_next;
+    struct g5_template_entry* lru_prev;  // towards most recently inserted or kept
+    struct g5_template_entry* lru_next;  // towards the next eviction candidate
+};
+
+// Lookups hold the lock shared, they only take a reference and mark the entry. Inserts and
+// evictions, which change the buckets and the list, hold it exclusively.
+struct g5_template_cache {
+    rwlock_handle_t lock;
+    size_t max_bytes;
+    int max_entries;
+    g5_template_entry_t** buckets;
+    unsigned int bucket_mask;
+    g5_template_entry_t* lru_head;
+    g5_template_entry_t* lru_tail;
+    volatile long long hits;  // counted under the shared lock
+    volatile long long misses;
+    g5_template_cache_stats_t stats;  // the other counters, under the exclusive lock
+};
+
+unsigned long long g5_template_cache_hash(const unsigned char* pixels, int size) {
+    unsigned long long hash = 14695981039346656037ULL;
+    int i;
+    for (i = 0; i < size; i++) {
+        hash ^= pixels[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static unsigned int key_bucket(const g5_template_cache_t* cache, const g5_template_key_t* key) {
+    unsigned long long h = key->pixel_hash;
+    h ^= (unsigned long long)key->sensor_type * 0x9E3779B97F4A7C15ULL;
+    h ^= (unsigned long long)(key->resolution ^ (key->radius << 16)) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 29;
+    return (unsigned int)h & cache->bucket_mask;
+}
+
+static size_t key_pixel_bytes(const g5_template_key_t* key) {
+    return key->width > 0 && key->height > 0 ? (size_t)key->width * key->height : 0;
+}
+
+// The hash only picks the bucket and rules out most candidates, a hit also compares the
+// pixels so that two images with the same hash never share a template.
+static int key_equal(const g5_template_key_t* a, const g5_template_key_t* b) {
+    return a->pixel_hash == b->pixel_hash && a->width == b->width && a->height == b->height &&
+           a->sensor_type == b->sensor_type && a->resolution == b->resolution &&
+           a->centroid_x == b->centroid_x && a->centroid_y == b->centroid_y &&
+           a->radius == b->radius && a->spd == b->spd &&
+           memcmp(a->pixels, b->pixels, key_pixel_bytes(a)) == 0;
+}
+
+static size_t entry_bytes(const g5_template_entry_t* entry) {
+    return entry->temp_size + key_pixel_bytes(&entry->key);
+}
+
+static g5_template_entry_t* bucket_find(const g5_template_cache_t* cache, unsigned int bucket,
+                                        const g5_template_key_t* key) {
+    g5_template_entry_t* entry = cache->buckets[bucket];
+    while (entry != NULL && !key_equal(&entry->key, key)) {
+        entry = entry->hash_next;
+    }
+    return entry;
+}
+
+static void lru_unlink(g5_template_cache_t* cache, g5_template_entry_t* entry) {
+    if (entry->lru_prev != NULL) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        cache->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next != NULL) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        cache->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void lru_push_front(g5_template_cache_t* cache, g5_template_entry_t* entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head != NULL) {
+        cache->lru_head->lru_prev = entry;
+    }
+    cache->lru_head = entry;
+    if (cache->lru_tail == NULL) {
+        cache->lru_tail = entry;
+    }
+}
+
+static void hash_unlink(g5_template_cache_t* cache, g5_template_entry_t* entry) {
+    g5_template_entry_t** link = &cache->buckets[key_bucket(cache, &entry->key)];
+    while (*link != NULL) {
+        if (*link == entry) {
+            *link = entry->hash_next;
+            break;
+        }
+        link = &(*link)->hash_next;
+    }
+    entry->hash_next = NULL;
+}
+
+static void entry_free(g5_template_entry_t* entry) {
+    plat_free(entry->temp);
+    plat_free(entry);
+}
+
+static int over_limit(const g5_template_cache_t* cache, size_t extra_bytes, int extra_entries) {
+    if (cache->max_bytes > 0 && cache->stats.bytes + extra_bytes > cache->max_bytes) {
+        return TRUE;
+    }
+    if (cache->max_entries > 0 && cache->stats.entries + extra_entries > cache->max_entries) {
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/*
+ * Evict unreferenced entries from the list tail until extra_bytes fit. Lookups cannot
+ * reorder the list under the shared lock, so an entry looked up since the last pass gets
+ * a second chance instead: it is unmarked and moved to the head. Every entry is passed at
+ * most twice. Must hold the lock exclusively, no reference can be taken meanwhile.
+ */
+static void evict(g5_template_cache_t* cache, size_t extra_bytes) {
+    g5_template_entry_t* entry = cache->lru_tail;
+    int budget = 2 * cache->stats.entries;
+    while (entry != NULL && budget-- > 0 && over_limit(cache, extra_bytes, 1)) {
+        g5_template_entry_t* prev = entry->lru_prev;
+        if (CACHE_LOAD(&entry->referenced)) {
+            CACHE_STORE(&entry->referenced, 0);
+            lru_unlink(cache, entry);
+            lru_push_front(cache, entry);
+        } else if (CACHE_LOAD(&entry->ref_count) == 0) {
+            hash_unlink(cache, entry);
+            lru_unlink(cache, entry);
+            cache->stats.bytes -= entry_bytes(entry);
+            cache->stats.entries--;
+            cache->stats.evictions++;
+            entry_free(entry);
+        }
+        entry = prev;
+    }
+}
+
+g5_template_cache_t* g5_template_cache_create(size_t max_bytes, int max_entries) {
+    unsigned int nbr_of_buckets = TEMPLATE_CACHE_DEFAULT_BUCKETS;
+    g5_template_cache_t* cache = (g5_template_cache_t*)plat_alloc(sizeof(g5_template_cache_t));
+    if (cache == NULL) {
+        return NULL;
+    }
+    memset(cache, 0, sizeof(g5_template_cache_t));
+    cache->max_bytes = max_bytes;
+    cache->max_entries = max_entries;
+
+    while (max_entries > 0 && nbr_of_buckets < (unsigned int)max_entries &&
+           nbr_of_buckets < (1u << 24)) {
+        nbr_of_buckets <<= 1;
+    }
+    cache->bucket_mask = nbr_of_buckets - 1;
+    cache->buckets = (g5_template_entry_t**)plat_alloc(nbr_of_buckets * sizeof(g5_template_entry_t*));
+    if (cache->buckets == NULL) {
+        plat_free(cache);
+        return NULL;
+    }
+    memset(cache->buckets, 0, nbr_of_buckets * sizeof(g5_template_entry_t*));
+
+    if (plat_rwlock_create(&cache->lock) != THREAD_RES_OK) {
+        plat_free(cache->buckets);
+        plat_free(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+void g5_template_cache_destroy(g5_template_cache_t* cache) {
+    g5_template_entry_t* entry;
+    if (cache == NULL) {
+        return;
+    }
+    entry = cache->lru_head;
+    while (entry != NULL) {
+        g5_template_entry_t* next = entry->lru_next;
+        entry_free(entry);
+        entry = next;
+    }
+    plat_rwlock_release(&cache->lock);
+    plat_free(cache->buckets);
+    plat_free(cache);
+}
+
+g5_template_entry_t* g5_template_cache_lookup(g5_template_cache_t* cache,
+                                              const g5_template_key_t* key) {
+    g5_template_entry_t* entry;
+    if (cache == NULL || key == NULL || key->pixels == NULL) {
+        return NULL;
+    }
+
+    plat_rwlock_lock_shared(cache->lock);
+    entry = bucket_find(cache, key_bucket(cache, key), key);
+    if (entry != NULL) {
+        CACHE_INC(&entry->ref_count);
+        if (!CACHE_LOAD(&entry->referenced)) {
+            CACHE_STORE(&entry->referenced, 1);
+        }
+        CACHE_INC64(&cache->hits);
+    } else {
+        CACHE_INC64(&cache->misses);
+    }
+    plat_rwlock_unlock_shared(cache->lock);
+    return entry;
+}
+
+g5_template_entry_t* g5_template_cache_insert(g5_template_cache_t* cache,
+                                              const g5_template_key_t* key, unsigned char* temp,
+                                              int temp_size) {
+    g5_template_entry_t* entry;
+    g5_template_entry_t* existing;
+    unsigned int bucket;
+    size_t pixel_bytes;
+    if (cache == NULL || key == NULL || key->pixels == NULL || temp == NULL) {
+        plat_free(temp);
+        return NULL;
+    }
+
+    pixel_bytes = key_pixel_bytes(key);
+    entry = (g5_template_entry_t*)plat_alloc(sizeof(g5_template_entry_t) + pixel_bytes);
+    if (entry == NULL) {
+        plat_free(temp);
+        return NULL;
+    }
+    memset(entry, 0, sizeof(g5_template_entry_t));
+    entry->key = *key;
+    entry->key.pixels = (const unsigned char*)(entry + 1);
+    memcpy(entry + 1, key->pixels, pixel_bytes);
+    entry->temp = temp;
+    entry->temp_size = temp_size;
+    entry->ref_count = 1;
+
+    plat_rwlock_lock(cache->lock);
+    bucket = key_bucket(cache, key);
+    existing = bucket_find(cache, bucket, key);
+    if (existing != NULL) {
+        CACHE_INC(&existing->ref_count);
+        plat_rwlock_unlock(cache->lock);
+        entry_free(entry);
+        return existing;
+    }
+
+    evict(cache, entry_bytes(entry));
+    if (!over_limit(cache, entry_bytes(entry), 1)) {
+        entry->cached = TRUE;
+        entry->hash_next = cache->buckets[bucket];
+        cache->buckets[bucket] = entry;
+        lru_push_front(cache, entry);
+        cache->stats.bytes += entry_bytes(entry);
+        cache->stats.entries++;
+    }
+    plat_rwlock_unlock(cache->lock);
+    return entry;
+}
+
+const unsigned char* g5_template_entry_data(const g5_template_entry_t* entry, int* temp_size) {
+    if (entry == NULL) {
+        return NULL;
+    }
+    if (temp_size != NULL) {
+        *temp_size = entry->temp_size;
+    }
+    return entry->temp;
+}
+
+void g5_template_cache_release(g5_template_cache_t* cache, g5_template_entry_t* entry) {
+    if (cache == NULL || entry == NULL) {
+        return;
+    }
+    // A cached entry is freed by the eviction that finds it unreferenced, an uncached one
+    // by its last release. cached is read first: once the count drops, a cached entry may
+    // be gone.
+    if (entry->cached) {
+        CACHE_DEC(&entry->ref_count);
+    } else if (CACHE_DEC(&entry->ref_count) == 0) {
+        entry_free(entry);
+    }
+}
+
+void g5_template_cache_get_stats(g5_template_cache_t* cache, g5_template_cache_stats_t* stats) {
+    if (cache == NULL || stats == NULL) {
+        return;
+    }
+    plat_rwlock_lock_shared(cache->lock);
+    *stats = cache->stats;
+    stats->hits = (unsigned long long)CACHE_LOAD64(&cache->hits);
+    stats->misses = (unsigned long long)CACHE_LOAD64(&cache->misses);
+    plat_rwlock_unlock_shared(cache->lock);
+}
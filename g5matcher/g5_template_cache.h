@@ -0,0 +1,97 @@
+#ifndef G5_TEMPLATE_CACHE_H_
+#define G5_TEMPLATE_CACHE_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Cache of extracted feature templates.
+ *
+ * An entry is keyed by the pixels plus the matcher configuration that affects
+ * extraction, so an image taking part in many comparisons is extracted once. A content
+ * hash of the pixels picks the bucket, a hit also compares the pixels, which the cache
+ * keeps a copy of; the copy counts towards the byte limit. Entries are reference counted:
+ * an acquired entry stays valid until it is released, even if it is evicted meanwhile.
+ * Unreferenced entries are evicted in insertion order when the byte or entry limit is
+ * exceeded, except that an entry looked up since the last eviction pass is kept once more
+ * (second chance).
+ *
+ * All functions are thread-safe, one cache can be shared by several matchers. Lookups
+ * only share a read lock, inserts take it exclusively and releases take no lock.
+ */
+typedef struct g5_template_cache g5_template_cache_t;
+typedef struct g5_template_entry g5_template_entry_t;
+
+typedef struct g5_template_key {
+    const unsigned char* pixels;  // width * height bytes, copied by the cache on insert
+    unsigned long long pixel_hash;
+    int width;
+    int height;
+    int sensor_type;
+    int resolution;
+    int centroid_x;
+    int centroid_y;
+    int radius;
+    int spd;
+} g5_template_key_t;
+
+typedef struct g5_template_cache_stats {
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    size_t bytes;
+    int entries;
+} g5_template_cache_stats_t;
+
+/**
+ * g5_template_cache_create
+ *
+ * @param max_bytes
+ *  memory limit for cached templates, 0 for no limit.
+ * @param max_entries
+ *  maximum number of cached templates, 0 for no limit.
+ */
+g5_template_cache_t* g5_template_cache_create(size_t max_bytes, int max_entries);
+void g5_template_cache_destroy(g5_template_cache_t* cache);
+
+/** 64-bit FNV-1a hash over the pixels, used as g5_template_key_t.pixel_hash. */
+unsigned long long g5_template_cache_hash(const unsigned char* pixels, int size);
+
+/**
+ * g5_template_cache_lookup
+ *
+ * @return
+ *  the acquired entry, or NULL on a miss.
+ */
+g5_template_entry_t* g5_template_cache_lookup(g5_template_cache_t* cache,
+                                              const g5_template_key_t* key);
+
+/**
+ * g5_template_cache_insert
+ *
+ * Ownership of temp (allocated with plat_alloc / by extract_feature_v2) always moves
+ * to the cache. If the key was inserted concurrently, temp is freed and the existing
+ * entry is returned. If the template does not fit in the cache it is returned in an
+ * uncached entry which is freed on release.
+ *
+ * @return
+ *  the acquired entry, or NULL if out of memory (temp is freed).
+ */
+g5_template_entry_t* g5_template_cache_insert(g5_template_cache_t* cache,
+                                              const g5_template_key_t* key, unsigned char* temp,
+                                              int temp_size);
+
+const unsigned char* g5_template_entry_data(const g5_template_entry_t* entry, int* temp_size);
+
+void g5_template_cache_release(g5_template_cache_t* cache, g5_template_entry_t* entry);
+
+void g5_template_cache_get_stats(g5_template_cache_t* cache, g5_template_cache_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
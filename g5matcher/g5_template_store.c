@@ -0,0 +1,177 @@
+typedef unsigned char BYTE;
+#include "g5_template_store.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "EgisAlgorithmApiV2.h"
+#include "g5_mem.h"
+#include "pb_crc32.h"
+#include "plat_file.h"
+#include "plat_log.h"
+
+#ifndef plat_alloc
+#define plat_alloc(fmt) g5_mem_malloc(fmt)
+#endif
+
+#ifndef PLAT_FREE
+#define PLAT_FREE(x)    \
+    if (x != NULL) {    \
+        g5_mem_free(x); \
+        x = NULL;       \
+    }
+#endif
+
+#define TEMPLATE_STORE_MAGIC 0x50543547  // "G5TP"
+#define TEMPLATE_STORE_VERSION 1
+#define TEMPLATE_STORE_HEADER_SIZE 16
+
+struct g5_template_store {
+    char dir[PATH_MAX];
+};
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static int make_path(const g5_template_store_t* store, const char* user, char* path) {
+    int len;
+    if (user == NULL || user[0] == '\0') {
+        return FP_NULL_DATA;
+    }
+#ifdef _MSC_VER
+    len = sprintf_s(path, PATH_MAX, "%s\\%s%s", store->dir, user, G5_TEMPLATE_STORE_EXT);
+#else
+    len = snprintf(path, PATH_MAX, "%s/%s%s", store->dir, user, G5_TEMPLATE_STORE_EXT);
+#endif
+    return len > 0 && len < PATH_MAX ? FP_OK : FP_ERR;
+}
+
+g5_template_store_t* g5_template_store_open(const char* dir) {
+    g5_template_store_t* store;
+    size_t len;
+    if (dir == NULL) {
+        return NULL;
+    }
+    len = strlen(dir);
+    if (len == 0 || len >= PATH_MAX) {
+        return NULL;
+    }
+    store = (g5_template_store_t*)plat_alloc(sizeof(g5_template_store_t));
+    if (store == NULL) {
+        return NULL;
+    }
+    memcpy(store->dir, dir, len + 1);
+    // Paths are built with a separator of their own
+    while (len > 1 && (store->dir[len - 1] == '/' || store->dir[len - 1] == '\\')) {
+        store->dir[--len] = '\0';
+    }
+    return store;
+}
+
+void g5_template_store_close(g5_template_store_t* store) {
+    PLAT_FREE(store);
+}
+
+int g5_template_store_put(g5_template_store_t* store, const char* user,
+                          const unsigned char* temp, int temp_size) {
+    char path[PATH_MAX];
+    unsigned char* buf;
+    int len, ret;
+
+    if (store == NULL || temp == NULL || temp_size <= 0) {
+        return FP_NULL_DATA;
+    }
+    ret = make_path(store, user, path);
+    if (ret != FP_OK) {
+        return ret;
+    }
+    len = TEMPLATE_STORE_HEADER_SIZE + temp_size;
+    buf = (unsigned char*)plat_alloc(len);
+    if (buf == NULL) {
+        return FP_ALLOC_MEM_FAIL;
+    }
+    put_u32(buf, TEMPLATE_STORE_MAGIC);
+    put_u32(buf + 4, TEMPLATE_STORE_VERSION);
+    put_u32(buf + 8, (uint32_t)temp_size);
+    put_u32(buf + 12, pb_crc32(temp, (uint32_t)temp_size));
+    memcpy(buf + TEMPLATE_STORE_HEADER_SIZE, temp, temp_size);
+
+    ret = plat_save_file(path, buf, len);
+    PLAT_FREE(buf);
+    if (ret != len) {
+        ex_log(LOG_ERROR, "g5_template_store_put: failed to write %s (%d)", path, ret);
+        return FP_ERR;
+    }
+    return FP_OK;
+}
+
+int g5_template_store_get(g5_template_store_t* store, const char* user, unsigned char** temp,
+                          int* temp_size) {
+    char path[PATH_MAX];
+    unsigned char* buf;
+    unsigned int buf_size = TEMPLATE_STORE_HEADER_SIZE + G5_TEMPLATE_STORE_MAX_SIZE;
+    unsigned int real_size = 0;
+    uint32_t size;
+    int ret;
+
+    if (store == NULL || temp == NULL || temp_size == NULL) {
+        return FP_NULL_DATA;
+    }
+    *temp = NULL;
+    *temp_size = 0;
+    ret = make_path(store, user, path);
+    if (ret != FP_OK) {
+        return ret;
+    }
+    buf = (unsigned char*)plat_alloc(buf_size);
+    if (buf == NULL) {
+        return FP_ALLOC_MEM_FAIL;
+    }
+    ret = plat_load_file(path, buf, buf_size, &real_size);
+    if (ret <= 0 || (unsigned int)ret != real_size || real_size < TEMPLATE_STORE_HEADER_SIZE) {
+        PLAT_FREE(buf);
+        return FP_NULL_ENROLL_DATA;
+    }
+    size = get_u32(buf + 8);
+    if (get_u32(buf) != TEMPLATE_STORE_MAGIC || get_u32(buf + 4) != TEMPLATE_STORE_VERSION ||
+        size == 0 || size != real_size - TEMPLATE_STORE_HEADER_SIZE ||
+        pb_crc32(buf + TEMPLATE_STORE_HEADER_SIZE, size) != get_u32(buf + 12)) {
+        ex_log(LOG_ERROR, "g5_template_store_get: %s is not a valid template", path);
+        PLAT_FREE(buf);
+        return FP_NULL_ENROLL_DATA;
+    }
+    // Hand out the template without the header, released with g5_matcher_free_template
+    *temp = (unsigned char*)plat_alloc(size);
+    if (*temp == NULL) {
+        PLAT_FREE(buf);
+        return FP_ALLOC_MEM_FAIL;
+    }
+    memcpy(*temp, buf + TEMPLATE_STORE_HEADER_SIZE, size);
+    *temp_size = (int)size;
+    PLAT_FREE(buf);
+    return FP_OK;
+}
+
+int g5_template_store_remove(g5_template_store_t* store, const char* user) {
+    char path[PATH_MAX];
+    int ret;
+    if (store == NULL) {
+        return FP_NULL_DATA;
+    }
+    ret = make_path(store, user, path);
+    if (ret != FP_OK) {
+        return ret;
+    }
+    return plat_remove_file(path) == PLAT_FILE_REMOVE_SUCCESS ? FP_OK : FP_ERR;
+}
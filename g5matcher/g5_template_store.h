@@ -0,0 +1,62 @@
+#ifndef G5_TEMPLATE_STORE_H_
+#define G5_TEMPLATE_STORE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Directory of enrolled multitemplates, one file per user.
+ *
+ * A file holds a small header (magic, version, template size and CRC-32 of the
+ * template) followed by the template, so a truncated or corrupt file is rejected on
+ * load. Users are stored in separate files, put and get can be called from several
+ * threads as long as each user is written by one thread only.
+ */
+typedef struct g5_template_store g5_template_store_t;
+
+#define G5_TEMPLATE_STORE_EXT ".g5t"
+/** Largest template accepted on load. */
+#define G5_TEMPLATE_STORE_MAX_SIZE (2 * 1024 * 1024)
+
+/**
+ * g5_template_store_open
+ *
+ * @param dir
+ *  existing directory to store the templates in.
+ * @return
+ *  the store, or NULL on failure.
+ */
+g5_template_store_t* g5_template_store_open(const char* dir);
+
+void g5_template_store_close(g5_template_store_t* store);
+
+/**
+ * Write the template of user, replacing any previous one.
+ *
+ * @param user
+ *  user id, used as the file name (without extension).
+ * @return
+ *  FP_OK or an FP_* error code.
+ */
+int g5_template_store_put(g5_template_store_t* store, const char* user,
+                          const unsigned char* temp, int temp_size);
+
+/**
+ * Read the template of user. The template is owned by the caller and released
+ * with g5_matcher_free_template().
+ *
+ * @return
+ *  FP_OK, FP_NULL_ENROLL_DATA if there is no valid template for user, or an FP_*
+ *  error code.
+ */
+int g5_template_store_get(g5_template_store_t* store, const char* user, unsigned char** temp,
+                          int* temp_size);
+
+int g5_template_store_remove(g5_template_store_t* store, const char* user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,309 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+typedef unsigned char BYTE;
+#include "g5_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pb_timestamp.h"
+#include "plat_log.h"
+#include "plat_thread.h"
+
+#ifndef plat_alloc
+#define plat_alloc(fmt) malloc(fmt)
+#endif
+
+#ifndef PLAT_FREE
+#define PLAT_FREE(x) \
+    if (x != NULL) { \
+        free(x);     \
+        x = NULL;    \
+    }
+#endif
+
+#ifdef _MSC_VER
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL __thread
+#endif
+
+typedef struct trace_event {
+    const char* name;
+    long long ts_us;
+    int pair_id;
+    char phase;  // 'B' or 'E'
+} trace_event_t;
+
+// Owned by one thread while tracing, read by g5_trace_stop() after the threads are done.
+typedef struct trace_buffer {
+    unsigned long thread_id;
+    char thread_name[G5_TRACE_THREAD_NAME_LEN];
+    trace_event_t* events;
+    int capacity;
+    int count;
+    int open;       // recorded begins without their end yet
+    int skipped;    // dropped begins without their end yet
+    unsigned long long dropped;
+    int pair_id;
+} trace_buffer_t;
+
+volatile int g5_trace_on = 0;
+
+static trace_buffer_t* g_buffers[G5_TRACE_MAX_THREADS];
+static int g_nbr_of_buffers = 0;
+static int g_events_per_thread = G5_TRACE_DEFAULT_EVENTS;
+static volatile unsigned long g_session = 0;
+static int g_unregistered_dropped = 0;  // guarded by g_mutex
+static int g_mutex_created = 0;
+static mutex_handle_t g_mutex;
+static pb_timestamp_t g_start;
+static g5_trace_stats_t g_stats;
+
+static TRACE_THREAD_LOCAL trace_buffer_t* tls_buffer = NULL;
+static TRACE_THREAD_LOCAL unsigned long tls_session = 0;
+
+static unsigned long current_thread_id(void) {
+#ifdef _WIN32
+    return (unsigned long)GetCurrentThreadId();
+#else
+    return (unsigned long)syscall(SYS_gettid);
+#endif
+}
+
+static long long now_us(void) {
+    pb_timestamp_t now;
+    pb_timestamp_now(&now);
+    return (long long)(now.sec - g_start.sec) * 1000000 + (now.usec - g_start.usec);
+}
+
+// Returns the buffer of the calling thread, registering one on its first event of the
+// session. NULL once G5_TRACE_MAX_THREADS threads have registered or on no memory.
+static trace_buffer_t* thread_buffer(void) {
+    trace_buffer_t* buffer = tls_buffer;
+
+    if (buffer != NULL && tls_session == g_session) {
+        return buffer;
+    }
+    tls_buffer = NULL;
+
+    plat_mutex_lock(g_mutex);
+    if (g_nbr_of_buffers < G5_TRACE_MAX_THREADS) {
+        buffer = (trace_buffer_t*)plat_alloc(sizeof(trace_buffer_t));
+        if (buffer != NULL) {
+            memset(buffer, 0, sizeof(trace_buffer_t));
+            buffer->events =
+                (trace_event_t*)plat_alloc(g_events_per_thread * sizeof(trace_event_t));
+            if (buffer->events == NULL) {
+                PLAT_FREE(buffer);
+            }
+        }
+        if (buffer != NULL) {
+            buffer->thread_id = current_thread_id();
+            buffer->capacity = g_events_per_thread;
+            buffer->pair_id = G5_TRACE_NO_PAIR;
+            g_buffers[g_nbr_of_buffers++] = buffer;
+        }
+    } else {
+        buffer = NULL;
+    }
+    if (buffer == NULL) {
+        g_unregistered_dropped++;
+    }
+    plat_mutex_unlock(g_mutex);
+
+    tls_buffer = buffer;
+    tls_session = g_session;
+    return buffer;
+}
+
+int g5_trace_start(int events_per_thread) {
+    if (g5_trace_on) {
+        return -1;
+    }
+    if (!g_mutex_created) {
+        if (plat_mutex_create(&g_mutex) != THREAD_RES_OK) {
+            ex_log(LOG_ERROR, "g5_trace_start: plat_mutex_create failed");
+            return -1;
+        }
+        g_mutex_created = 1;
+    }
+    // Room for at least one begin/end pair
+    g_events_per_thread = events_per_thread > 2 ? events_per_thread : G5_TRACE_DEFAULT_EVENTS;
+    g_nbr_of_buffers = 0;
+    g_unregistered_dropped = 0;
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_session++;
+    pb_timestamp_now(&g_start);
+    g5_trace_on = 1;
+    return 0;
+}
+
+void g5_trace_begin(const char* name) {
+    trace_buffer_t* buffer;
+    trace_event_t* event;
+
+    if (!g5_trace_on || (buffer = thread_buffer()) == NULL) {
+        return;
+    }
+    // Keep one free slot for the end of every recorded begin, this one included
+    if (buffer->skipped > 0 || buffer->count + buffer->open + 2 > buffer->capacity) {
+        buffer->skipped++;
+        buffer->dropped++;
+        return;
+    }
+    event = &buffer->events[buffer->count++];
+    event->name = name;
+    event->ts_us = now_us();
+    event->pair_id = buffer->pair_id;
+    event->phase = 'B';
+    buffer->open++;
+}
+
+void g5_trace_end(const char* name) {
+    trace_buffer_t* buffer;
+    trace_event_t* event;
+
+    if (!g5_trace_on || (buffer = thread_buffer()) == NULL) {
+        return;
+    }
+    if (buffer->skipped > 0) {
+        buffer->skipped--;
+        buffer->dropped++;
+        return;
+    }
+    if (buffer->open == 0) {
+        return;
+    }
+    event = &buffer->events[buffer->count++];
+    event->name = name;
+    event->ts_us = now_us();
+    event->pair_id = G5_TRACE_NO_PAIR;
+    event->phase = 'E';
+    buffer->open--;
+}
+
+void g5_trace_set_pair(int pair_id) {
+    trace_buffer_t* buffer;
+
+    if (g5_trace_on && (buffer = thread_buffer()) != NULL) {
+        buffer->pair_id = pair_id;
+    }
+}
+
+void g5_trace_set_thread_name(const char* name, int index) {
+    trace_buffer_t* buffer;
+    char full_name[G5_TRACE_THREAD_NAME_LEN + 16];
+
+    if (!g5_trace_on || (buffer = thread_buffer()) == NULL) {
+        return;
+    }
+    if (index < 0) {
+        strncpy(buffer->thread_name, name, G5_TRACE_THREAD_NAME_LEN - 1);
+    } else {
+#ifdef _MSC_VER
+        sprintf_s(full_name, sizeof(full_name), "%.*s %d", G5_TRACE_THREAD_NAME_LEN, name, index);
+#else
+        snprintf(full_name, sizeof(full_name), "%.*s %d", G5_TRACE_THREAD_NAME_LEN, name, index);
+#endif
+        strncpy(buffer->thread_name, full_name, G5_TRACE_THREAD_NAME_LEN - 1);
+    }
+    buffer->thread_name[G5_TRACE_THREAD_NAME_LEN - 1] = '\0';
+}
+
+// Thread names are the only strings not given as literals, keep the JSON valid
+static void write_json_string(FILE* file, const char* s) {
+    fputc('"', file);
+    for (; *s != '\0'; s++) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', file);
+            fputc(*s, file);
+        } else if ((unsigned char)*s >= 0x20) {
+            fputc(*s, file);
+        }
+    }
+    fputc('"', file);
+}
+
+static void write_events(FILE* file) {
+    const char* separator = "\n";
+    int i, j;
+
+    for (i = 0; i < g_nbr_of_buffers; i++) {
+        trace_buffer_t* buffer = g_buffers[i];
+        if (buffer->thread_name[0] != '\0') {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,"
+                          "\"args\":{\"name\":",
+                    separator, buffer->thread_id);
+            write_json_string(file, buffer->thread_name);
+            fprintf(file, "}}");
+            separator = ",\n";
+        }
+        for (j = 0; j < buffer->count; j++) {
+            trace_event_t* event = &buffer->events[j];
+            fprintf(file, "%s{\"name\":", separator);
+            write_json_string(file, event->name);
+            fprintf(file, ",\"cat\":\"g5\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%lu",
+                    event->phase, event->ts_us, buffer->thread_id);
+            if (event->pair_id != G5_TRACE_NO_PAIR) {
+                fprintf(file, ",\"args\":{\"pair\":%d}", event->pair_id);
+            }
+            fprintf(file, "}");
+            separator = ",\n";
+        }
+    }
+}
+
+int g5_trace_stop(const char* path) {
+    FILE* file;
+    int ret = 0;
+    int i;
+
+    if (!g5_trace_on) {
+        return -1;
+    }
+    g5_trace_on = 0;
+
+    g_stats.threads = g_nbr_of_buffers;
+    g_stats.dropped = g_unregistered_dropped;
+    for (i = 0; i < g_nbr_of_buffers; i++) {
+        g_stats.events += g_buffers[i]->count;
+        g_stats.dropped += g_buffers[i]->dropped;
+    }
+
+    file = fopen(path, "w");
+    if (file == NULL) {
+        ex_log(LOG_ERROR, "g5_trace_stop: failed to open %s", path);
+        ret = -1;
+    } else {
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%llu},"
+                      "\"traceEvents\":[",
+                g_stats.dropped);
+        write_events(file);
+        fprintf(file, "\n]}\n");
+        if (fclose(file) != 0) {
+            ex_log(LOG_ERROR, "g5_trace_stop: failed to write %s", path);
+            ret = -1;
+        }
+    }
+
+    for (i = 0; i < g_nbr_of_buffers; i++) {
+        PLAT_FREE(g_buffers[i]->events);
+        PLAT_FREE(g_buffers[i]);
+    }
+    g_nbr_of_buffers = 0;
+    return ret;
+}
+
+void g5_trace_get_stats(g5_trace_stats_t* stats) {
+    *stats = g_stats;
+}
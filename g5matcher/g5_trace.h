@@ -0,0 +1,96 @@
+#ifndef G5_TRACE_H_
+#define G5_TRACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Timeline of matcher activity in the Chrome trace format, which Perfetto
+ * (ui.perfetto.dev) and chrome://tracing open.
+ *
+ * Every thread records begin/end events with a pb_timestamp_now() timestamp and the
+ * pair it is working on into a buffer of its own, so recording takes no lock. The
+ * buffers are written out as one JSON file by g5_trace_stop().
+ *
+ * The G5_TRACE_* macros only test a global flag while tracing is stopped. A thread
+ * whose buffer is full drops further events and they are counted; a begin that is
+ * kept always keeps room for its end, so the timeline stays well nested.
+ */
+
+#define G5_TRACE_DEFAULT_EVENTS (1 << 16)
+#define G5_TRACE_MAX_THREADS 256
+#define G5_TRACE_THREAD_NAME_LEN 32
+#define G5_TRACE_NO_PAIR (-1)
+
+extern volatile int g5_trace_on;
+
+#define G5_TRACE_BEGIN(name)                   \
+    do {                                       \
+        if (g5_trace_on) g5_trace_begin(name); \
+    } while (0)
+
+#define G5_TRACE_END(name)                   \
+    do {                                     \
+        if (g5_trace_on) g5_trace_end(name); \
+    } while (0)
+
+#define G5_TRACE_SET_PAIR(pair_id)                   \
+    do {                                             \
+        if (g5_trace_on) g5_trace_set_pair(pair_id); \
+    } while (0)
+
+typedef struct g5_trace_stats {
+    unsigned long long events;   // events recorded
+    unsigned long long dropped;  // events dropped on a full buffer
+    int threads;                 // threads that recorded events
+} g5_trace_stats_t;
+
+/**
+ * Start recording.
+ *
+ * @param events_per_thread
+ *  capacity of each thread buffer, 0 for G5_TRACE_DEFAULT_EVENTS
+ * @return
+ *  0, or -1 if tracing is already started.
+ */
+int g5_trace_start(int events_per_thread);
+
+/**
+ * Stop recording, write the events of all threads to path and free the buffers. The
+ * traced threads must not be inside a span, in practice they have been joined.
+ *
+ * @return
+ *  0, or -1 if tracing was not started or the file could not be written.
+ */
+int g5_trace_stop(const char* path);
+
+/**
+ * Record the begin of span name on the calling thread. name must stay valid until
+ * g5_trace_stop(), e.g. a string literal.
+ */
+void g5_trace_begin(const char* name);
+
+/** Record the end of the innermost span of the calling thread. */
+void g5_trace_end(const char* name);
+
+/**
+ * Set the pair recorded with the following begin events of the calling thread,
+ * G5_TRACE_NO_PAIR for none.
+ */
+void g5_trace_set_pair(int pair_id);
+
+/**
+ * Name the calling thread in the timeline as "name index", or just name for index -1.
+ * The name is copied and truncated to G5_TRACE_THREAD_NAME_LEN - 1 characters.
+ */
+void g5_trace_set_thread_name(const char* name, int index);
+
+/** Counters of the last session, set by g5_trace_stop(). */
+void g5_trace_get_stats(g5_trace_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,6 +1,12 @@
 #pragma once
-#include "g5_main.h"
+#include "EgisAlgorithmApiV2.h"
 #define BOOL unsigned char
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
 #define EGIS_OK 0
 #define EGIS_MODEL_UNKNOWN 1
 
@@ -2614,105 +2620,105 @@ enum fp_type
 #define SET_DL2_ELLIPSE_2_THETA(x) x##_DL2_ELLIPSE_2_THETA
 #define SET_DL2_ELLIPSE_3_THETA(x) x##_DL2_ELLIPSE_3_THETA
 
-#define INIT_TH_BY_MODEL(x)                                                                             \
-	do                                                                                                  \
+// threshold_manager_t initializer from the x##_* settings of a model
+#define THRESHOLDS_BY_MODEL(x)                                                                          \
 	{                                                                                                   \
-		threshold_manager.major_for_sdk = SET_VERSION_MAJOR_FOR_SDK(x);                                 \
-		threshold_manager.major_for_lib = SET_VERSION_MAJOR_FOR_LIB(x);                                 \
-		threshold_manager.version_minor = SET_VERSION_MINOR(x);                                         \
-		threshold_manager.version_build = SET_VERSION_BUILD(x);                                         \
-		threshold_manager.version_patch = SET_VERSION_PATCH(x);                                         \
-		threshold_manager.check_black_th = SET_CHECK_BLACK_TH(x);                                       \
-		threshold_manager.check_black_th_2 = SET_CHECK_BLACK_TH_2(x);                                   \
-		threshold_manager.sunlight_th_m = SET_SUNLIGHT_TH_M(x);                                         \
-		threshold_manager.sunlight_th_625_m = SET_SUNLIGHT_TH_625_M(x);                                 \
-		threshold_manager.bds_egis_partial_th = SET_BDS_EGIS_PARTIAL_TH(x);                             \
-		threshold_manager.first_4_bds_egis_partial_th = SET_FIRST_4_BDS_EGIS_PARTIAL_TH(x);             \
-		threshold_manager.enroll_moire_th = SET_ENROLL_MOIRE_TH(x);                                     \
-		threshold_manager.identify_moire_th = SET_IDENTIFY_MOIRE_TH(x);                                 \
-		threshold_manager.learning_moire_th = SET_LEARNING_MOIRE_TH(x);                                 \
-		threshold_manager.fake_mode = SET_FAKE_MODE(x);                                                 \
-		threshold_manager.fake_finger_th = SET_FAKE_FINGER_TH(x);                                       \
-		threshold_manager.fake_finger_partial_th = SET_FAKE_FINGER_PARTIAL_TH(x);                       \
-		threshold_manager.euclidean_distance_th = SET_EUCLIDEAN_DISTANCE_TH(x);                         \
-		threshold_manager.normal_far_ratio = SET_NORMAL_FAR_RATIO(x);                                   \
-		threshold_manager.easy_mode_2_far_ratio = SET_EASY_MODE_2_FAR_RATIO(x);                         \
-		threshold_manager.easy_mode_3_far_ratio = SET_EASY_MODE_3_FAR_RATIO(x);                         \
-		threshold_manager.dry_image_class_match_score_th = SET_DRY_IMAGE_CLASS_MATCH_SCORE_TH(x);       \
-		threshold_manager.fa_attack_far_ratio = SET_FA_ATTACK_FAR_RATIO(x);                             \
-		threshold_manager.special_attack_far_ratio = SET_SPECIAL_ATTACK_FAR_RATIO(x);                   \
-		threshold_manager.wash_hand_far_ratio = SET_WASH_HAND_FAR_RATIO(x);                             \
-		threshold_manager.latent_finger_threshold_1 = SET_LATENT_FINGER_THRESHOLD_1(x);                 \
-		threshold_manager.latent_finger_threshold_2 = SET_LATENT_FINGER_THRESHOLD_2(x);                 \
-		threshold_manager.finger_score_th = SET_FINGER_SCORE_TH(x);                                     \
-		threshold_manager.phone_case_mode = SET_PHONE_CASE_MODE(x);                                     \
-		threshold_manager.enroll_phone_case_th_1 = SET_ENROLL_PHONE_CASE_TH_1(x);                       \
-		threshold_manager.enroll_phone_case_th_2 = SET_ENROLL_PHONE_CASE_TH_2(x);                       \
-		threshold_manager.enroll_phone_case_th_3 = SET_ENROLL_PHONE_CASE_TH_3(x);                       \
-		threshold_manager.verify_phone_case_th = SET_VERIFY_PHONE_CASE_TH(x);                           \
-		threshold_manager.matte_partial_enroll_th = SET_MATTE_PARTIAL_ENROLL_TH(x);                     \
-		threshold_manager.matte_partial_verify_th = SET_MATTE_PARTIAL_VERIFY_TH(x);                     \
-		threshold_manager.matte_partial_learning_th = SET_MATTE_PARTIAL_LEARNING_TH(x);                 \
-		threshold_manager.partial_radius = SET_PARTIAL_RADIUS(x);                                       \
-		threshold_manager.is_need_lower_egp = SET_IS_NEED_LOWER_EGP(x);                                 \
-		threshold_manager.partial_enroll_th = SET_PARTIAL_ENROLL_TH(x);                                 \
-		threshold_manager.first_4_partial_enroll_th = SET_FIRST_4_PARTIAL_ENROLL_TH(x);                 \
-		threshold_manager.partial_verify_th = SET_PARTIAL_VERIFY_TH(x);                                 \
-		threshold_manager.is_enable_dry_slot = SET_IS_ENABLE_DRY_SLOT(x);                               \
-		threshold_manager.is_need_check_pre_mean_50 = SET_IS_NEED_CHECK_PRE_MEAN_50(x);                 \
-		threshold_manager.is_need_delay_before_bac = SET_IS_NEED_DELAY_BEFORE_BAC(x);                   \
-		threshold_manager.is_use_bds_to_train_fake = SET_IS_USE_BDS_TO_TRAIN_FAKE(x);                   \
-		threshold_manager.is_use_clt = SET_IS_USE_CLT(x);                                               \
-		threshold_manager.is_use_16bit_to_train_model3 = SET_IS_USE_16BIT_TO_TRAIN_MODEL3(x);           \
-		threshold_manager.verify_dl_detected_1_egp_th = SET_VERIFY_DL_DETECTED_1_EGP_TH(x);             \
-		threshold_manager.verify_dl_detected_2_egp_th = SET_VERIFY_DL_DETECTED_2_EGP_TH(x);             \
-		threshold_manager.verify_latent_over_mean_10_egp_th = SET_VERIFY_LATENT_OVER_MEAN_10_EGP_TH(x); \
-		threshold_manager.verify_latent_over_mean_50_egp_th = SET_VERIFY_LATENT_OVER_MEAN_50_EGP_TH(x); \
-		threshold_manager.egp_th_update_pre_mean = SET_EGP_TH_UPDATE_PRE_MEAN(x);                       \
-		threshold_manager.rl_th_update_pre_mean = SET_RL_TH_UPDATE_PRE_MEAN(x);                         \
-		threshold_manager.latent_finger_orange_threshold_1 = SET_LATENT_FINGER_ORANGE_THRESHOLD_1(x);   \
-		threshold_manager.latent_finger_orange_threshold_2 = SET_LATENT_FINGER_ORANGE_THRESHOLD_2(x);   \
-		threshold_manager.matte_bds_add_th = SET_MATTE_BDS_ADD_TH(x);                                   \
-		threshold_manager.orange_card_addtional_score_th = SET_ORANGE_CARD_ADDTIONAL_SCORE_TH(x);       \
-		threshold_manager.verify_latent_over_mean_10_rl_th = SET_VERIFY_LATENT_OVER_MEAN_10_RL_TH(x);   \
-		threshold_manager.detect_latent_mode = SET_DETECT_LATENT_MODE(x);                               \
-		threshold_manager.orange_qty_change_percentage_th = SET_ORANGE_QTY_CHANGE_PERCENTAGE_TH(x);     \
-		threshold_manager.matcher_g5_reject_level = SET_MATCHER_G5_REJECT_LEVEL(x);                     \
-		threshold_manager.matcher_g5_dpi = SET_MATCHER_G5_DPI(x);                                       \
-		threshold_manager.matcher_g5_radius = SET_MATCHER_G5_RADIUS(x);                                 \
-		threshold_manager.matcher_g5_redundant_level = SET_MATCHER_G5_REDUNDANT_LEVEL(x);               \
-		threshold_manager.matcher_g5_algo_type = SET_MATCHER_G5_ALGO_TYPE(x);                           \
-		threshold_manager.matcher_g5_spd_th = SET_MATCHER_G5_SPD_TH(x);                                 \
-		threshold_manager.orange_card_pre_qty_th = SET_ORANGE_CARD_PRE_QTY_TH(x);                       \
-		threshold_manager.detect_latent_bkg_type = SET_DETECT_LATENT_BKG_TYPE(x);                       \
-		threshold_manager.detect_latent_use_coef_type = SET_DETECT_LATENT_USE_COEF_TYPE(x);             \
-		threshold_manager.detect_latent_use_dl2 = SET_DETECT_LATENT_USE_DL2(x);                         \
-		threshold_manager.combined_q3_gap_th = SET_COMBINED_Q3_GAP_TH(x);                               \
-		threshold_manager.combined_isp_gap_th = SET_COMBINED_ISP_GAP_TH(x);                             \
-		threshold_manager.combined_dlx_th = SET_COMBINED_DLX_TH(x);                                     \
-		threshold_manager.combined_dly_th = SET_COMBINED_DLY_TH(x);                                     \
-		threshold_manager.separated_isp_th = SET_SEPARATED_ISP_TH(x);                                   \
-		threshold_manager.separated_dlx_th = SET_SEPARATED_DLX_TH(x);                                   \
-		threshold_manager.separated_dly_th = SET_SEPARATED_DLY_TH(x);                                   \
-		threshold_manager.separated_isp_gap_th = SET_SEPARATED_ISP_GAP_TH(x);                           \
-		threshold_manager.predicted_latent_dly_th = SET_PREDICTED_LATENT_DLY_TH(x);                     \
-		threshold_manager.pre_q3_update_egp_th = SET_PRE_Q3_UPDATE_EGP_TH(x);                           \
-		threshold_manager.dl2_ellipse_1_center_x = SET_DL2_ELLIPSE_1_CENTER_X(x);                       \
-		threshold_manager.dl2_ellipse_1_center_y = SET_DL2_ELLIPSE_1_CENTER_Y(x);                       \
-		threshold_manager.dl2_ellipse_2_center_x = SET_DL2_ELLIPSE_2_CENTER_X(x);                       \
-		threshold_manager.dl2_ellipse_2_center_y = SET_DL2_ELLIPSE_2_CENTER_Y(x);                       \
-		threshold_manager.dl2_ellipse_3_center_x = SET_DL2_ELLIPSE_3_CENTER_X(x);                       \
-		threshold_manager.dl2_ellipse_3_center_y = SET_DL2_ELLIPSE_3_CENTER_Y(x);                       \
-		threshold_manager.dl2_ellipse_1_axis_a = SET_DL2_ELLIPSE_1_AXIS_A(x);                           \
-		threshold_manager.dl2_ellipse_1_axis_b = SET_DL2_ELLIPSE_1_AXIS_B(x);                           \
-		threshold_manager.dl2_ellipse_2_axis_a = SET_DL2_ELLIPSE_2_AXIS_A(x);                           \
-		threshold_manager.dl2_ellipse_2_axis_b = SET_DL2_ELLIPSE_2_AXIS_B(x);                           \
-		threshold_manager.dl2_ellipse_3_axis_a = SET_DL2_ELLIPSE_3_AXIS_A(x);                           \
-		threshold_manager.dl2_ellipse_3_axis_b = SET_DL2_ELLIPSE_3_AXIS_B(x);                           \
-		threshold_manager.dl2_ellipse_1_theta = SET_DL2_ELLIPSE_1_THETA(x);                             \
-		threshold_manager.dl2_ellipse_2_theta = SET_DL2_ELLIPSE_2_THETA(x);                             \
-		threshold_manager.dl2_ellipse_3_theta = SET_DL2_ELLIPSE_3_THETA(x);                             \
-	} while (0)
+		.major_for_sdk = SET_VERSION_MAJOR_FOR_SDK(x),                                                  \
+		.major_for_lib = SET_VERSION_MAJOR_FOR_LIB(x),                                                  \
+		.version_minor = SET_VERSION_MINOR(x),                                                          \
+		.version_build = SET_VERSION_BUILD(x),                                                          \
+		.version_patch = SET_VERSION_PATCH(x),                                                          \
+		.check_black_th = SET_CHECK_BLACK_TH(x),                                                        \
+		.check_black_th_2 = SET_CHECK_BLACK_TH_2(x),                                                    \
+		.sunlight_th_m = SET_SUNLIGHT_TH_M(x),                                                          \
+		.sunlight_th_625_m = SET_SUNLIGHT_TH_625_M(x),                                                  \
+		.bds_egis_partial_th = SET_BDS_EGIS_PARTIAL_TH(x),                                              \
+		.first_4_bds_egis_partial_th = SET_FIRST_4_BDS_EGIS_PARTIAL_TH(x),                              \
+		.enroll_moire_th = SET_ENROLL_MOIRE_TH(x),                                                      \
+		.identify_moire_th = SET_IDENTIFY_MOIRE_TH(x),                                                  \
+		.learning_moire_th = SET_LEARNING_MOIRE_TH(x),                                                  \
+		.fake_mode = SET_FAKE_MODE(x),                                                                  \
+		.fake_finger_th = SET_FAKE_FINGER_TH(x),                                                        \
+		.fake_finger_partial_th = SET_FAKE_FINGER_PARTIAL_TH(x),                                        \
+		.euclidean_distance_th = SET_EUCLIDEAN_DISTANCE_TH(x),                                          \
+		.normal_far_ratio = SET_NORMAL_FAR_RATIO(x),                                                    \
+		.easy_mode_2_far_ratio = SET_EASY_MODE_2_FAR_RATIO(x),                                          \
+		.easy_mode_3_far_ratio = SET_EASY_MODE_3_FAR_RATIO(x),                                          \
+		.dry_image_class_match_score_th = SET_DRY_IMAGE_CLASS_MATCH_SCORE_TH(x),                        \
+		.fa_attack_far_ratio = SET_FA_ATTACK_FAR_RATIO(x),                                              \
+		.special_attack_far_ratio = SET_SPECIAL_ATTACK_FAR_RATIO(x),                                    \
+		.wash_hand_far_ratio = SET_WASH_HAND_FAR_RATIO(x),                                              \
+		.latent_finger_threshold_1 = SET_LATENT_FINGER_THRESHOLD_1(x),                                  \
+		.latent_finger_threshold_2 = SET_LATENT_FINGER_THRESHOLD_2(x),                                  \
+		.finger_score_th = SET_FINGER_SCORE_TH(x),                                                      \
+		.phone_case_mode = SET_PHONE_CASE_MODE(x),                                                      \
+		.enroll_phone_case_th_1 = SET_ENROLL_PHONE_CASE_TH_1(x),                                        \
+		.enroll_phone_case_th_2 = SET_ENROLL_PHONE_CASE_TH_2(x),                                        \
+		.enroll_phone_case_th_3 = SET_ENROLL_PHONE_CASE_TH_3(x),                                        \
+		.verify_phone_case_th = SET_VERIFY_PHONE_CASE_TH(x),                                            \
+		.matte_partial_enroll_th = SET_MATTE_PARTIAL_ENROLL_TH(x),                                      \
+		.matte_partial_verify_th = SET_MATTE_PARTIAL_VERIFY_TH(x),                                      \
+		.matte_partial_learning_th = SET_MATTE_PARTIAL_LEARNING_TH(x),                                  \
+		.partial_radius = SET_PARTIAL_RADIUS(x),                                                        \
+		.is_need_lower_egp = SET_IS_NEED_LOWER_EGP(x),                                                  \
+		.partial_enroll_th = SET_PARTIAL_ENROLL_TH(x),                                                  \
+		.first_4_partial_enroll_th = SET_FIRST_4_PARTIAL_ENROLL_TH(x),                                  \
+		.partial_verify_th = SET_PARTIAL_VERIFY_TH(x),                                                  \
+		.is_enable_dry_slot = SET_IS_ENABLE_DRY_SLOT(x),                                                \
+		.is_need_check_pre_mean_50 = SET_IS_NEED_CHECK_PRE_MEAN_50(x),                                  \
+		.is_need_delay_before_bac = SET_IS_NEED_DELAY_BEFORE_BAC(x),                                    \
+		.is_use_bds_to_train_fake = SET_IS_USE_BDS_TO_TRAIN_FAKE(x),                                    \
+		.is_use_clt = SET_IS_USE_CLT(x),                                                                \
+		.is_use_16bit_to_train_model3 = SET_IS_USE_16BIT_TO_TRAIN_MODEL3(x),                            \
+		.verify_dl_detected_1_egp_th = SET_VERIFY_DL_DETECTED_1_EGP_TH(x),                              \
+		.verify_dl_detected_2_egp_th = SET_VERIFY_DL_DETECTED_2_EGP_TH(x),                              \
+		.verify_latent_over_mean_10_egp_th = SET_VERIFY_LATENT_OVER_MEAN_10_EGP_TH(x),                  \
+		.verify_latent_over_mean_50_egp_th = SET_VERIFY_LATENT_OVER_MEAN_50_EGP_TH(x),                  \
+		.egp_th_update_pre_mean = SET_EGP_TH_UPDATE_PRE_MEAN(x),                                        \
+		.rl_th_update_pre_mean = SET_RL_TH_UPDATE_PRE_MEAN(x),                                          \
+		.latent_finger_orange_threshold_1 = SET_LATENT_FINGER_ORANGE_THRESHOLD_1(x),                    \
+		.latent_finger_orange_threshold_2 = SET_LATENT_FINGER_ORANGE_THRESHOLD_2(x),                    \
+		.matte_bds_add_th = SET_MATTE_BDS_ADD_TH(x),                                                    \
+		.orange_card_addtional_score_th = SET_ORANGE_CARD_ADDTIONAL_SCORE_TH(x),                        \
+		.verify_latent_over_mean_10_rl_th = SET_VERIFY_LATENT_OVER_MEAN_10_RL_TH(x),                    \
+		.detect_latent_mode = SET_DETECT_LATENT_MODE(x),                                                \
+		.orange_qty_change_percentage_th = SET_ORANGE_QTY_CHANGE_PERCENTAGE_TH(x),                      \
+		.matcher_g5_reject_level = SET_MATCHER_G5_REJECT_LEVEL(x),                                      \
+		.matcher_g5_dpi = SET_MATCHER_G5_DPI(x),                                                        \
+		.matcher_g5_radius = SET_MATCHER_G5_RADIUS(x),                                                  \
+		.matcher_g5_redundant_level = SET_MATCHER_G5_REDUNDANT_LEVEL(x),                                \
+		.matcher_g5_algo_type = SET_MATCHER_G5_ALGO_TYPE(x),                                            \
+		.matcher_g5_spd_th = SET_MATCHER_G5_SPD_TH(x),                                                  \
+		.orange_card_pre_qty_th = SET_ORANGE_CARD_PRE_QTY_TH(x),                                        \
+		.detect_latent_bkg_type = SET_DETECT_LATENT_BKG_TYPE(x),                                        \
+		.detect_latent_use_coef_type = SET_DETECT_LATENT_USE_COEF_TYPE(x),                              \
+		.detect_latent_use_dl2 = SET_DETECT_LATENT_USE_DL2(x),                                          \
+		.combined_q3_gap_th = SET_COMBINED_Q3_GAP_TH(x),                                                \
+		.combined_isp_gap_th = SET_COMBINED_ISP_GAP_TH(x),                                              \
+		.combined_dlx_th = SET_COMBINED_DLX_TH(x),                                                      \
+		.combined_dly_th = SET_COMBINED_DLY_TH(x),                                                      \
+		.separated_isp_th = SET_SEPARATED_ISP_TH(x),                                                    \
+		.separated_dlx_th = SET_SEPARATED_DLX_TH(x),                                                    \
+		.separated_dly_th = SET_SEPARATED_DLY_TH(x),                                                    \
+		.separated_isp_gap_th = SET_SEPARATED_ISP_GAP_TH(x),                                            \
+		.predicted_latent_dly_th = SET_PREDICTED_LATENT_DLY_TH(x),                                      \
+		.pre_q3_update_egp_th = SET_PRE_Q3_UPDATE_EGP_TH(x),                                            \
+		.dl2_ellipse_1_center_x = SET_DL2_ELLIPSE_1_CENTER_X(x),                                        \
+		.dl2_ellipse_1_center_y = SET_DL2_ELLIPSE_1_CENTER_Y(x),                                        \
+		.dl2_ellipse_2_center_x = SET_DL2_ELLIPSE_2_CENTER_X(x),                                        \
+		.dl2_ellipse_2_center_y = SET_DL2_ELLIPSE_2_CENTER_Y(x),                                        \
+		.dl2_ellipse_3_center_x = SET_DL2_ELLIPSE_3_CENTER_X(x),                                        \
+		.dl2_ellipse_3_center_y = SET_DL2_ELLIPSE_3_CENTER_Y(x),                                        \
+		.dl2_ellipse_1_axis_a = SET_DL2_ELLIPSE_1_AXIS_A(x),                                            \
+		.dl2_ellipse_1_axis_b = SET_DL2_ELLIPSE_1_AXIS_B(x),                                            \
+		.dl2_ellipse_2_axis_a = SET_DL2_ELLIPSE_2_AXIS_A(x),                                            \
+		.dl2_ellipse_2_axis_b = SET_DL2_ELLIPSE_2_AXIS_B(x),                                            \
+		.dl2_ellipse_3_axis_a = SET_DL2_ELLIPSE_3_AXIS_A(x),                                            \
+		.dl2_ellipse_3_axis_b = SET_DL2_ELLIPSE_3_AXIS_B(x),                                            \
+		.dl2_ellipse_1_theta = SET_DL2_ELLIPSE_1_THETA(x),                                              \
+		.dl2_ellipse_2_theta = SET_DL2_ELLIPSE_2_THETA(x),                                              \
+		.dl2_ellipse_3_theta = SET_DL2_ELLIPSE_3_THETA(x)                                               \
+	}
 
 typedef struct threshold_manager
 {
@@ -2816,6 +2822,16 @@ typedef struct threshold_manager
 	int dl2_ellipse_3_theta;
 } threshold_manager_t;
 
+typedef struct model_profile
+{
+	const char *name;
+	enum model_type model_type;
+	enum lens_type lens_type;
+	enum fp_type sensor_type;
+	int template_size;
+	threshold_manager_t thresholds;
+} model_profile_t;
+
 typedef struct _model_setting
 {
 	void *g_ctx;
@@ -2857,7 +2873,20 @@ struct matcher_api_verify_struct
 };
 
 const char *get_sensor_name(enum algo_api_sensor_type sensor);
+/**
+ * All profiles, *count of them. The first MODEL_END are indexed by enum model_type,
+ * aliases of those follow.
+ */
+const model_profile_t *get_model_profiles(int *count);
+/**
+ * Profile of the model named MODEL_NAME (case insensitive), NULL if unknown.
+ * The profiles are constant, the pointer stays valid.
+ */
+const model_profile_t *get_model_profile(const char *MODEL_NAME);
+int get_phone_model(const char *MODEL_NAME, enum model_type *model_type, enum lens_type *lens_type, enum fp_type *sensor_type);
+int get_template_size(const char *MODEL_NAME, int *template_size);
 int init_model_setting(model_setting *session, const char *MODEL_NAME);
+int init_model_setting_by_profile(model_setting *session, const model_profile_t *profile);
 BOOL get_mlq_t_table(enum model_type model, unsigned char **mlq_temp,
 					 int *mlq_temp_size, int *mlq_temp_count,
 					 enum lens_type lenstype);
@@ -27,38 +27,53 @@ typedef enum {
 #endif
 #endif
 
+/*
+ * Calls below PLAT_LOG_MIN_LEVEL compile to nothing, e.g. build with
+ * PLAT_LOG_MIN_LEVEL=LOG_INFO to strip the verbose and debug logs of the
+ * matcher loops. g_log_level still filters the remaining calls at run time.
+ */
+#ifndef PLAT_LOG_MIN_LEVEL
+#define PLAT_LOG_MIN_LEVEL LOG_VERBOSE
+#endif
+#define PLAT_LOG_ENABLED(level) ((level) >= PLAT_LOG_MIN_LEVEL)
+
 #define FILE_NAME \
 	(strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 #define egislog(level, format, ...)                                       \
 	do {                                                              \
-		output_log(level, LOG_TAG, FILE_NAME, __func__, __LINE__, \
-			   format, ##__VA_ARGS__);                        \
+		if (PLAT_LOG_ENABLED(level))                              \
+			output_log(level, LOG_TAG, FILE_NAME, __func__,   \
+				   __LINE__, format, ##__VA_ARGS__);      \
 	} while (0)
 #define ex_log(level, format, ...)                                      \
 	do {                                                            \
-		output_log(level, "RBS", FILE_NAME, __func__, __LINE__, \
-			   format, ##__VA_ARGS__);                      \
+		if (PLAT_LOG_ENABLED(level))                            \
+			output_log(level, "RBS", FILE_NAME, __func__,   \
+				   __LINE__, format, ##__VA_ARGS__);    \
 	} while (0)
 
 #if !defined(LOGD)
 #define LOGD(format, ...)                                                   \
 	do {                                                                \
-		output_log(LOG_DEBUG, "RBS", FILE_NAME, __func__, __LINE__, \
-			   format, ##__VA_ARGS__);                          \
+		if (PLAT_LOG_ENABLED(LOG_DEBUG))                            \
+			output_log(LOG_DEBUG, "RBS", FILE_NAME, __func__,   \
+				   __LINE__, format, ##__VA_ARGS__);        \
 	} while (0)
 #endif
 
 #if !defined(LOGE)
 #define LOGE(format, ...)                                                   \
 	do {                                                                \
-		output_log(LOG_ERROR, "RBS", FILE_NAME, __func__, __LINE__, \
-			   format, ##__VA_ARGS__);                          \
+		if (PLAT_LOG_ENABLED(LOG_ERROR))                            \
+			output_log(LOG_ERROR, "RBS", FILE_NAME, __func__,   \
+				   __LINE__, format, ##__VA_ARGS__);        \
 	} while (0)
 #endif
 #define egislog_algo(level, format, ...)                                            \
 do {                                                                   \
-	output_algo_log(level, LOG_ALGO_TAG, FILE_NAME, __func__, __LINE__,      \
-	format, ##__VA_ARGS__);                             \
+	if (PLAT_LOG_ENABLED(level))                                   \
+		output_algo_log(level, LOG_ALGO_TAG, FILE_NAME, __func__, __LINE__,      \
+		format, ##__VA_ARGS__);                             \
 } while (0)
 
 #ifdef __cplusplus
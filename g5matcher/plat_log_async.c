@@ -0,0 +1,412 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned char BYTE;
+#include "plat_log_async.h"
+#include "plat_thread.h"
+
+#define DEFAULT_RING_RECORDS 512
+#define DRAIN_INTERVAL_US 10000
+
+/*
+ * Single producer / single consumer rings: head is only written by the owning
+ * thread, tail only by the drain thread. The counters are free running, the
+ * ring capacity is a power of 2 so head - tail stays right when they wrap.
+ */
+#ifdef _WIN32
+#define LOG_LOAD(p) ((unsigned long)InterlockedCompareExchange((volatile LONG*)(p), 0, 0))
+#define LOG_STORE(p, v) InterlockedExchange((volatile LONG*)(p), (LONG)(v))
+#define LOG_INC(p) InterlockedIncrement((volatile LONG*)(p))
+#define LOG_DEC(p) InterlockedDecrement((volatile LONG*)(p))
+#define LOG_CAS(p, old_value, new_value) \
+	(InterlockedCompareExchange((volatile LONG*)(p), (LONG)(new_value), (LONG)(old_value)) == \
+	 (LONG)(old_value))
+#else
+#define LOG_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define LOG_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define LOG_INC(p) __sync_add_and_fetch((p), 1)
+#define LOG_DEC(p) __sync_sub_and_fetch((p), 1)
+#define LOG_CAS(p, old_value, new_value) \
+	__sync_bool_compare_and_swap((p), (old_value), (new_value))
+#endif
+
+typedef struct log_record {
+	LOG_LEVEL level;
+	int line;
+	const char* tag;
+	const char* file_name;
+	const char* func;
+	long long time_us;
+	char payload[PLAT_LOG_PAYLOAD_LEN];
+} log_record_t;
+
+typedef struct log_ring {
+	volatile unsigned long head;	/* next record to write, owner only */
+	char head_pad[64 - sizeof(unsigned long)];
+	volatile unsigned long tail;	/* next record to read, drain thread only */
+	char tail_pad[64 - sizeof(unsigned long)];
+	volatile unsigned long dropped;	/* owner only */
+	unsigned long reported_dropped;	/* drain thread only */
+	volatile unsigned long released;	/* the owner thread has exited */
+	unsigned long thread_id;
+	unsigned long capacity;
+	log_record_t* records;
+} log_ring_t;
+
+static log_ring_t* g_rings[PLAT_LOG_MAX_RINGS];
+static volatile unsigned long g_nbr_of_rings = 0;
+static volatile unsigned long g_registry_lock = 0;
+static volatile unsigned long g_running = 0;
+static volatile unsigned long g_pushing = 0;	/* producers between the g_running check and return */
+static volatile unsigned long g_unregistered_dropped = 0;
+static unsigned long g_reported_unregistered = 0;
+static unsigned long g_ring_records = DEFAULT_RING_RECORDS;
+static volatile unsigned long g_written = 0;	/* drain thread only */
+static long long g_start_us = 0;
+static FILE* g_file = NULL;
+static thread_handle_t g_drain_thread;
+static thread_param_t g_drain_param;
+static semaphore_handle_t g_wake;
+static volatile unsigned long g_stop_drain = 0;
+static unsigned long long g_dropped_at_start = 0;
+
+#ifdef _WIN32
+static DWORD g_ring_key = FLS_OUT_OF_INDEXES;
+#else
+static pthread_key_t g_ring_key;
+#endif
+static int g_ring_key_created = 0;
+
+static long long now_us(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (long long)(counter.QuadPart / frequency.QuadPart * 1000000 +
+			   counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+static unsigned long current_thread_id(void)
+{
+#ifdef _WIN32
+	return (unsigned long)GetCurrentThreadId();
+#else
+	return (unsigned long)syscall(SYS_gettid);
+#endif
+}
+
+/* The ring of an exited thread is handed to the next new thread once drained */
+#ifdef _WIN32
+static VOID WINAPI ring_thread_exit(PVOID data)
+#else
+static void ring_thread_exit(void* data)
+#endif
+{
+	if (data != NULL) {
+		LOG_STORE(&((log_ring_t*)data)->released, 1);
+	}
+}
+
+static void registry_lock(void)
+{
+	while (!LOG_CAS(&g_registry_lock, 0, 1)) {
+	}
+}
+
+static void registry_unlock(void)
+{
+	LOG_STORE(&g_registry_lock, 0);
+}
+
+static log_ring_t* ring_register(void)
+{
+	log_ring_t* ring = NULL;
+	unsigned long i;
+
+	registry_lock();
+	for (i = 0; i < g_nbr_of_rings; i++) {
+		log_ring_t* candidate = g_rings[i];
+		if (LOG_LOAD(&candidate->released) &&
+		    LOG_LOAD(&candidate->head) == LOG_LOAD(&candidate->tail)) {
+			ring = candidate;
+			break;
+		}
+	}
+	if (ring == NULL && g_nbr_of_rings < PLAT_LOG_MAX_RINGS) {
+		ring = (log_ring_t*)calloc(1, sizeof(log_ring_t));
+		if (ring != NULL) {
+			ring->capacity = g_ring_records;
+			ring->records = (log_record_t*)malloc(ring->capacity * sizeof(log_record_t));
+			if (ring->records == NULL) {
+				free(ring);
+				ring = NULL;
+			} else {
+				g_rings[g_nbr_of_rings] = ring;
+				/* published after the slot, the drain thread reads the count first */
+				LOG_STORE(&g_nbr_of_rings, g_nbr_of_rings + 1);
+			}
+		}
+	}
+	if (ring != NULL) {
+		ring->thread_id = current_thread_id();
+		LOG_STORE(&ring->released, 0);
+#ifdef _WIN32
+		FlsSetValue(g_ring_key, ring);
+#else
+		pthread_setspecific(g_ring_key, ring);
+#endif
+	}
+	registry_unlock();
+	return ring;
+}
+
+static log_ring_t* current_ring(void)
+{
+#ifdef _WIN32
+	log_ring_t* ring = (log_ring_t*)FlsGetValue(g_ring_key);
+#else
+	log_ring_t* ring = (log_ring_t*)pthread_getspecific(g_ring_key);
+#endif
+	return ring != NULL ? ring : ring_register();
+}
+
+static int push_record(LOG_LEVEL level, const char* tag, const char* file_name,
+		       const char* func, int line, const char* format, va_list args)
+{
+	log_ring_t* ring;
+	log_record_t* record;
+	unsigned long head, tail;
+
+	ring = current_ring();
+	if (ring == NULL) {
+		LOG_INC(&g_unregistered_dropped);
+		return 1;
+	}
+
+	head = ring->head;
+	tail = LOG_LOAD(&ring->tail);
+	if (head - tail >= ring->capacity) {
+		LOG_STORE(&ring->dropped, ring->dropped + 1);
+		return 1;
+	}
+	record = &ring->records[head & (ring->capacity - 1)];
+	record->level = level;
+	record->line = line;
+	record->tag = tag;
+	record->file_name = file_name;
+	record->func = func;
+	record->time_us = now_us();
+	vsnprintf(record->payload, PLAT_LOG_PAYLOAD_LEN, format, args);
+	record->payload[PLAT_LOG_PAYLOAD_LEN - 1] = '\0';
+	LOG_STORE(&ring->head, head + 1);
+
+	/* wake the drain thread early once a ring is half full */
+	if (head + 1 - tail == ring->capacity / 2) {
+		plat_semaphore_post(g_wake);
+	}
+	return 1;
+}
+
+int plat_log_async_vpush(LOG_LEVEL level, const char* tag, const char* file_name,
+			 const char* func, int line, const char* format, va_list args)
+{
+	int ret;
+
+	/* counted before g_running is read, stop waits for it before g_wake goes away */
+	LOG_INC(&g_pushing);
+	ret = LOG_LOAD(&g_running) ? push_record(level, tag, file_name, func, line, format, args)
+				   : 0;
+	LOG_DEC(&g_pushing);
+	return ret;
+}
+
+static void write_record(const log_ring_t* ring, const log_record_t* record)
+{
+	const char* filename = record->file_name != NULL ? record->file_name : "";
+	const char* separator = strrchr(filename, '\\');
+	long long time_us = record->time_us - g_start_us;
+
+	if (separator != NULL) {
+		filename = separator + 1;
+	}
+	fprintf(g_file, "%lld.%06lld %5lu %s%s\t%s\t[%s:%d] %s\n", time_us / 1000000,
+		time_us % 1000000, ring->thread_id, record->level > LOG_INFO ? "ERROR! " : "",
+		record->tag, record->func, filename, record->line, record->payload);
+}
+
+static void drain_rings(void)
+{
+	unsigned long nbr_of_rings = LOG_LOAD(&g_nbr_of_rings);
+	unsigned long unregistered;
+	unsigned long i;
+	int written = 0;
+
+	for (i = 0; i < nbr_of_rings; i++) {
+		log_ring_t* ring = g_rings[i];
+		unsigned long tail = ring->tail;
+		unsigned long head = LOG_LOAD(&ring->head);
+		unsigned long dropped;
+
+		if (tail != head) {
+			LOG_STORE(&g_written, g_written + (head - tail));
+			written = 1;
+		}
+		for (; tail != head; tail++) {
+			write_record(ring, &ring->records[tail & (ring->capacity - 1)]);
+		}
+		LOG_STORE(&ring->tail, tail);
+
+		dropped = LOG_LOAD(&ring->dropped);
+		if (dropped != ring->reported_dropped) {
+			fprintf(g_file, "plat_log_async: dropped %lu records of thread %lu, ring full\n",
+				dropped - ring->reported_dropped, ring->thread_id);
+			ring->reported_dropped = dropped;
+			written = 1;
+		}
+	}
+	unregistered = LOG_LOAD(&g_unregistered_dropped);
+	if (unregistered != g_reported_unregistered) {
+		fprintf(g_file, "plat_log_async: dropped %lu records of threads without a ring\n",
+			unregistered - g_reported_unregistered);
+		g_reported_unregistered = unregistered;
+		written = 1;
+	}
+	if (written) {
+		fflush(g_file);
+	}
+}
+
+static int drain_routine(void* arg)
+{
+	(void)arg;
+	for (;;) {
+		plat_semaphore_wait(g_wake, DRAIN_INTERVAL_US);
+		drain_rings();
+		if (LOG_LOAD(&g_stop_drain)) {
+			break;
+		}
+	}
+	return 0;
+}
+
+int plat_log_async_start(const char* path, int ring_records)
+{
+	plat_log_async_stats_t stats;
+	unsigned long i;
+
+	if (LOG_LOAD(&g_running) || path == NULL) {
+		return -1;
+	}
+	if (!g_ring_key_created) {
+#ifdef _WIN32
+		g_ring_key = FlsAlloc(ring_thread_exit);
+		if (g_ring_key == FLS_OUT_OF_INDEXES) {
+			return -1;
+		}
+#else
+		if (pthread_key_create(&g_ring_key, ring_thread_exit) != 0) {
+			return -1;
+		}
+#endif
+		g_ring_key_created = 1;
+	}
+
+	g_file = fopen(path, "w");
+	if (g_file == NULL) {
+		return -1;
+	}
+	/* rings allocated by an earlier start keep their size */
+	g_ring_records = 1;
+	if (ring_records <= 0) {
+		ring_records = DEFAULT_RING_RECORDS;
+	}
+	while (g_ring_records < (unsigned long)ring_records) {
+		g_ring_records <<= 1;
+	}
+	for (i = 0; i < LOG_LOAD(&g_nbr_of_rings); i++) {
+		g_rings[i]->reported_dropped = LOG_LOAD(&g_rings[i]->dropped);
+	}
+	g_reported_unregistered = LOG_LOAD(&g_unregistered_dropped);
+	LOG_STORE(&g_written, 0);
+	g_dropped_at_start = 0;
+	plat_log_async_get_stats(&stats);
+	g_dropped_at_start = stats.dropped;
+	g_start_us = now_us();
+	LOG_STORE(&g_stop_drain, 0);
+
+	memset(&g_drain_thread, 0, sizeof(g_drain_thread));
+	memset(&g_wake, 0, sizeof(g_wake));
+	if (plat_semaphore_create(&g_wake, 0, 1) != THREAD_RES_OK) {
+		fclose(g_file);
+		g_file = NULL;
+		return -1;
+	}
+	if (plat_thread_create_ex(&g_drain_thread, (void*)drain_routine, &g_drain_param) !=
+	    THREAD_RES_OK) {
+		plat_semaphore_release(&g_wake);
+		fclose(g_file);
+		g_file = NULL;
+		return -1;
+	}
+	LOG_STORE(&g_running, 1);
+	return 0;
+}
+
+void plat_log_async_stop(void)
+{
+	plat_log_async_stats_t stats;
+
+	/* a full barrier, so a producer either sees g_running cleared or is counted below */
+	if (!LOG_CAS(&g_running, 1, 0)) {
+		return;
+	}
+	while (LOG_LOAD(&g_pushing) != 0) {
+	}
+	LOG_STORE(&g_stop_drain, 1);
+	plat_semaphore_post(g_wake);
+	plat_thread_release(&g_drain_thread);
+	/* records queued while the drain thread was finishing */
+	drain_rings();
+
+	plat_log_async_get_stats(&stats);
+	fprintf(g_file, "plat_log_async: %llu records written, %llu dropped, %d rings\n",
+		stats.written, stats.dropped, stats.rings);
+	fclose(g_file);
+	g_file = NULL;
+	plat_semaphore_release(&g_wake);
+}
+
+void plat_log_async_get_stats(plat_log_async_stats_t* stats)
+{
+	unsigned long nbr_of_rings = LOG_LOAD(&g_nbr_of_rings);
+	unsigned long i;
+
+	if (stats == NULL) {
+		return;
+	}
+	stats->written = LOG_LOAD(&g_written);
+	stats->dropped = LOG_LOAD(&g_unregistered_dropped);
+	for (i = 0; i < nbr_of_rings; i++) {
+		stats->dropped += LOG_LOAD(&g_rings[i]->dropped);
+	}
+	stats->dropped -= g_dropped_at_start;
+	stats->rings = (int)nbr_of_rings;
+}
@@ -0,0 +1,69 @@
+#ifndef __PLAT_LOG_ASYNC_H_
+#define __PLAT_LOG_ASYNC_H_
+
+#include <stdarg.h>
+
+#include "plat_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Asynchronous backend of output_log.
+ *
+ * While started, output_log formats the message on the calling thread into a
+ * fixed-size record of a ring buffer owned by that thread and returns; no lock
+ * is taken and no I/O is done. A background thread drains all rings to the log
+ * file. When a ring is full the record is dropped and counted, the drain thread
+ * writes a line with the number of dropped records to the file.
+ *
+ * tag, file_name and func are stored as pointers, they must be string literals
+ * as passed by the ex_log / egislog macros.
+ */
+
+#define PLAT_LOG_PAYLOAD_LEN 256
+#define PLAT_LOG_MAX_RINGS 256
+
+typedef struct plat_log_async_stats {
+	unsigned long long written;	/* records written to the file */
+	unsigned long long dropped;	/* records dropped on a full ring or without a ring */
+	int rings;			/* per-thread rings allocated so far */
+} plat_log_async_stats_t;
+
+/**
+ * plat_log_async_start
+ *
+ * @param path
+ * 	log file, truncated
+ * @param ring_records
+ * 	records per thread ring, rounded up to a power of 2, 0 for the default (512)
+ * @return
+ * 	0 on success, -1 if already started or the file or drain thread could not
+ * 	be created.
+ */
+int plat_log_async_start(const char* path, int ring_records);
+
+/**
+ * Stop the drain thread after writing every queued record and the counters,
+ * and close the file. output_log is synchronous again afterwards.
+ */
+void plat_log_async_stop(void);
+
+/**
+ * Queue one record, called by output_log.
+ *
+ * @return
+ * 	1 when the record was queued or dropped, 0 when the backend is not started
+ * 	and the caller has to write the message itself.
+ */
+int plat_log_async_vpush(LOG_LEVEL level, const char* tag, const char* file_name,
+			 const char* func, int line, const char* format, va_list args);
+
+void plat_log_async_get_stats(plat_log_async_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,6 +2,7 @@
 #include <string.h>
 #include <windows.h>
 #include "plat_log.h"
+#include "plat_log_async.h"
 
 #define MAX_BUFLEN 1024
 
@@ -18,10 +19,17 @@ void output_log(LOG_LEVEL level, const char *tag, const char *file_name,
 	char out_buffer[MAX_BUFLEN];
 	char *filename;
 	va_list vl;
+	int queued;
 
 	if (format == NULL) return;
 	if (g_log_level > level) return;
 
+	// queued for the drain thread while plat_log_async_start() is in effect
+	va_start(vl, format);
+	queued = plat_log_async_vpush(level, tag, file_name, func_name, line, format, vl);
+	va_end(vl);
+	if (queued) return;
+
 	va_start(vl, format);
 	vsprintf_s(buffer, MAX_BUFLEN, format, vl);
 	va_end(vl);
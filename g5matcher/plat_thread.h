@@ -14,6 +14,12 @@
 #ifndef __PLAT_THREAD_H_
 #define __PLAT_THREAD_H_
 
+/*
+ * Implemented by plat_thread_win.c on Windows and by plat_thread_posix.c
+ * (pthreads and futexes) on Linux. Both are in the project, each compiles to
+ * nothing on the other platform.
+ */
+
 typedef enum plat_thread_result {
 	THREAD_RES_OK,
 	THREAD_RES_WAIT_TIMEOUT,
@@ -41,6 +47,10 @@ typedef struct mutex_handle {
 	void* mutex;
 } mutex_handle_t;
 
+typedef struct rwlock_handle {
+	void* lock;
+} rwlock_handle_t;
+
 int plat_thread_create(thread_handle_t* handle, void* routine);
 int plat_thread_create_ex(thread_handle_t* handle, void* routine, thread_param_t* arg);
 int plat_thread_release(thread_handle_t* handle);
@@ -64,6 +74,13 @@ int plat_mutex_release(mutex_handle_t* handle);
  * 	[THREAD_ERR_FAILED] 
  */
 int plat_semaphore_wait(semaphore_handle_t handle, int wait_time);
+/**
+ * plat_semaphore_post
+ *
+ * @return
+ * 	[THREAD_RES_OK]
+ * 	[THREAD_ERR_FAILED]	the count would exceed max_cnt
+ */
 int plat_semaphore_post(semaphore_handle_t handle);
 
 /**
@@ -102,7 +119,58 @@ int plat_mutex_trylock(mutex_handle_t handle);
  */
 int plat_mutex_unlock(mutex_handle_t handle);
 
+/**
+ * plat_rwlock_create
+ *
+ * A lock that many readers can hold at once and a writer holds alone. Not
+ * recursive: a thread must not take it again while holding it, in either mode.
+ *
+ * @return
+ * 	[THREAD_RES_OK]
+ * 	[THREAD_ERR_INVALID_PARAM]
+ * 	[THREAD_ERR_CREATE_FAILED]
+ */
+int plat_rwlock_create(rwlock_handle_t* handle);
+int plat_rwlock_release(rwlock_handle_t* handle);
+
+/**
+ * plat_rwlock_lock_shared / plat_rwlock_unlock_shared
+ *
+ * Take or drop the lock as a reader, waiting while a writer holds it.
+ *
+ * @return
+ * 	[THREAD_RES_OK]
+ * 	[THREAD_ERR_INVALID_PARAM]
+ * 	[THREAD_ERR_FAILED]
+ */
+int plat_rwlock_lock_shared(rwlock_handle_t handle);
+int plat_rwlock_unlock_shared(rwlock_handle_t handle);
+
+/**
+ * plat_rwlock_lock / plat_rwlock_unlock
+ *
+ * Take or drop the lock as the writer, waiting until no reader or writer holds it.
+ *
+ * @return
+ * 	[THREAD_RES_OK]
+ * 	[THREAD_ERR_INVALID_PARAM]
+ * 	[THREAD_ERR_FAILED]
+ */
+int plat_rwlock_lock(rwlock_handle_t handle);
+int plat_rwlock_unlock(rwlock_handle_t handle);
+
 int plat_sched_setaffinity(void);
-int plat_sched_setaffinity_ex(BYTE cpu_mask);
+/**
+ * plat_sched_setaffinity_ex
+ *
+ * Pin the calling thread to the CPUs whose bits are set in cpu_mask, bit n for
+ * CPU n. On Windows the CPUs are those of the thread's processor group, and a
+ * 32-bit process can only pin CPUs 0-31.
+ *
+ * @return
+ * 	[THREAD_RES_OK]
+ * 	[THREAD_ERR_FAILED]
+ */
+int plat_sched_setaffinity_ex(unsigned long long cpu_mask);
 
 #endif
\ No newline at end of file
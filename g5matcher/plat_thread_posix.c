@@ -0,0 +1,501 @@
+#ifndef _WIN32
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef unsigned char BYTE;
+#include "plat_thread.h"
+#include "plat_log.h"
+
+/*
+ * pthreads implementation of plat_thread.h for Linux, the counterpart of
+ * plat_thread_win.c. Threads are pthreads; mutexes and semaphores are built on
+ * futexes so that an uncontended lock, unlock, wait or post stays in user space.
+ * Mutexes are recursive and owned like the Windows mutex objects: only the owning
+ * thread may unlock them. Read-write locks are pthread rwlocks.
+ */
+
+typedef struct posix_thread_start {
+	int (*routine)(void*);
+	void* arg;
+} posix_thread_start_t;
+
+typedef struct posix_mutex {
+	int state;	/* 0 unlocked, 1 locked, 2 locked and maybe waiters */
+	pid_t owner;	/* thread id of the owner, 0 when unlocked */
+	int depth;	/* recursion depth of the owner */
+} posix_mutex_t;
+
+typedef struct posix_semaphore {
+	int count;
+	int waiters;	/* threads sleeping or about to sleep on count */
+	int max_count;
+} posix_semaphore_t;
+
+static pid_t current_tid(void)
+{
+	return (pid_t)syscall(SYS_gettid);
+}
+
+static int futex_wait(int* addr, int value, const struct timespec* timeout)
+{
+	return (int)syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, timeout, NULL, 0);
+}
+
+static int futex_wake(int* addr, int nbr_of_waiters)
+{
+	return (int)syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, nbr_of_waiters, NULL, NULL, 0);
+}
+
+static void* thread_start(void* arg)
+{
+	posix_thread_start_t start = *(posix_thread_start_t*)arg;
+	free(arg);
+	start.routine(start.arg);
+	return NULL;
+}
+
+static int thread_create(thread_handle_t* handle, void* routine, void* arg)
+{
+	pthread_t thread;
+	int ret;
+	posix_thread_start_t* start = (posix_thread_start_t*)malloc(sizeof(posix_thread_start_t));
+	if (start == NULL) {
+		return THREAD_ERR_CREATE_FAILED;
+	}
+	start->routine = (int (*)(void*))routine;
+	start->arg = arg;
+
+	ret = pthread_create(&thread, NULL, thread_start, start);
+	if (ret != 0) {
+		ex_log(LOG_ERROR, "pthread_create failed ,error = %d", ret);
+		free(start);
+		return THREAD_ERR_CREATE_FAILED;
+	}
+	/* pthread_t is an unsigned long on Linux */
+	handle->hlinux = (unsigned long int)thread;
+	return THREAD_RES_OK;
+}
+
+int plat_thread_create_ex(thread_handle_t* handle, void* routine, thread_param_t* arg)
+{
+	if (handle == NULL || routine == NULL) {
+		ex_log(LOG_ERROR, "plat_thread_create_ex invalid param");
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	if (handle->hlinux != 0) {
+		ex_log(LOG_ERROR, "plat_thread_create_ex handle->hlinux != 0");
+		return THREAD_RES_OK;
+	}
+
+	/* the routine gets &arg->params, as with CreateThread */
+	return thread_create(handle, routine, arg != NULL ? (void*)&arg->params : NULL);
+}
+
+int plat_thread_create(thread_handle_t* handle, void* routine)
+{
+	if (handle == NULL || routine == NULL) {
+		ex_log(LOG_ERROR, "plat_thread_create invalid param");
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	if (handle->hlinux != 0) {
+		ex_log(LOG_ERROR, "plat_thread_create handle->hlinux != 0");
+		return THREAD_RES_OK;
+	}
+
+	return thread_create(handle, routine, NULL);
+}
+
+int plat_thread_release(thread_handle_t* handle)
+{
+	int ret;
+	if (handle == NULL) {
+		ex_log(LOG_ERROR, "plat_thread_release handle == NULL");
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	if (handle->hlinux == 0) {
+		ex_log(LOG_ERROR, "plat_thread_release handle->hlinux == 0, thread has been closed");
+		return THREAD_RES_OK;
+	}
+
+	ret = pthread_join((pthread_t)handle->hlinux, NULL);
+	handle->hlinux = 0;
+	if (ret != 0) {
+		ex_log(LOG_ERROR, "pthread_join failed ,error = %d", ret);
+		return THREAD_ERR_FAILED;
+	}
+	return THREAD_RES_OK;
+}
+
+int plat_mutex_create(mutex_handle_t* handle)
+{
+	posix_mutex_t* mutex;
+	if (handle == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	if (handle->mutex != NULL) {
+		ex_log(LOG_ERROR, "plat_mutex_create handle->mutex != NULL, mutex has already been created");
+		return THREAD_RES_OK;
+	}
+
+	mutex = (posix_mutex_t*)calloc(1, sizeof(posix_mutex_t));
+	if (mutex == NULL) {
+		return THREAD_ERR_CREATE_FAILED;
+	}
+	handle->mutex = mutex;
+	return THREAD_RES_OK;
+}
+
+int plat_mutex_release(mutex_handle_t* handle)
+{
+	if (handle == NULL) {
+		ex_log(LOG_ERROR, "plat_mutex_release handle == NULL");
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	if (handle->mutex == NULL) {
+		ex_log(LOG_INFO, "plat_mutex_release handle->mutex == NULL, mutex has already been closed");
+		return THREAD_RES_OK;
+	}
+
+	free(handle->mutex);
+	handle->mutex = NULL;
+	return THREAD_RES_OK;
+}
+
+/* Takes the lock without recursion, returns 0 or THREAD_RES_WAIT_TIMEOUT with try set */
+static int mutex_acquire(posix_mutex_t* mutex, int try)
+{
+	int state = 0;
+	if (__atomic_compare_exchange_n(&mutex->state, &state, 1, 0, __ATOMIC_ACQUIRE,
+					__ATOMIC_RELAXED)) {
+		return THREAD_RES_OK;
+	}
+	if (try) {
+		return THREAD_RES_WAIT_TIMEOUT;
+	}
+	/* contended: mark the lock as having waiters and sleep until it is handed over */
+	if (state != 2) {
+		state = __atomic_exchange_n(&mutex->state, 2, __ATOMIC_ACQUIRE);
+	}
+	while (state != 0) {
+		futex_wait(&mutex->state, 2, NULL);
+		state = __atomic_exchange_n(&mutex->state, 2, __ATOMIC_ACQUIRE);
+	}
+	return THREAD_RES_OK;
+}
+
+static int mutex_lock(mutex_handle_t handle, int try)
+{
+	posix_mutex_t* mutex = (posix_mutex_t*)handle.mutex;
+	pid_t tid;
+	int retval;
+	if (mutex == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	tid = current_tid();
+	if (__atomic_load_n(&mutex->owner, __ATOMIC_RELAXED) == tid) {
+		mutex->depth++;
+		return THREAD_RES_OK;
+	}
+	retval = mutex_acquire(mutex, try);
+	if (retval == THREAD_RES_OK) {
+		__atomic_store_n(&mutex->owner, tid, __ATOMIC_RELAXED);
+		mutex->depth = 1;
+	}
+	return retval;
+}
+
+int plat_mutex_lock(mutex_handle_t handle)
+{
+	return mutex_lock(handle, 0);
+}
+
+int plat_mutex_trylock(mutex_handle_t handle)
+{
+	return mutex_lock(handle, 1);
+}
+
+int plat_mutex_unlock(mutex_handle_t handle)
+{
+	posix_mutex_t* mutex = (posix_mutex_t*)handle.mutex;
+	if (mutex == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	if (__atomic_load_n(&mutex->owner, __ATOMIC_RELAXED) != current_tid()) {
+		ex_log(LOG_ERROR, "plat_mutex_unlock failed, mutex is not owned by the caller");
+		return THREAD_ERR_FAILED;
+	}
+	if (--mutex->depth > 0) {
+		return THREAD_RES_OK;
+	}
+	__atomic_store_n(&mutex->owner, 0, __ATOMIC_RELAXED);
+	if (__atomic_exchange_n(&mutex->state, 0, __ATOMIC_RELEASE) == 2) {
+		futex_wake(&mutex->state, 1);
+	}
+	return THREAD_RES_OK;
+}
+
+int plat_rwlock_create(rwlock_handle_t* handle)
+{
+	pthread_rwlock_t* lock;
+	if (handle == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	if (handle->lock != NULL) {
+		ex_log(LOG_ERROR, "plat_rwlock_create handle->lock != NULL, lock has already been created");
+		return THREAD_RES_OK;
+	}
+
+	lock = (pthread_rwlock_t*)malloc(sizeof(pthread_rwlock_t));
+	if (lock == NULL) {
+		return THREAD_ERR_CREATE_FAILED;
+	}
+	if (pthread_rwlock_init(lock, NULL) != 0) {
+		free(lock);
+		return THREAD_ERR_CREATE_FAILED;
+	}
+	handle->lock = lock;
+	return THREAD_RES_OK;
+}
+
+int plat_rwlock_release(rwlock_handle_t* handle)
+{
+	if (handle == NULL) {
+		ex_log(LOG_ERROR, "plat_rwlock_release handle == NULL");
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	if (handle->lock == NULL) {
+		ex_log(LOG_INFO, "plat_rwlock_release handle->lock == NULL, lock has already been closed");
+		return THREAD_RES_OK;
+	}
+
+	pthread_rwlock_destroy((pthread_rwlock_t*)handle->lock);
+	free(handle->lock);
+	handle->lock = NULL;
+	return THREAD_RES_OK;
+}
+
+int plat_rwlock_lock_shared(rwlock_handle_t handle)
+{
+	if (handle.lock == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	return pthread_rwlock_rdlock((pthread_rwlock_t*)handle.lock) == 0 ? THREAD_RES_OK
+									 : THREAD_ERR_FAILED;
+}
+
+int plat_rwlock_unlock_shared(rwlock_handle_t handle)
+{
+	if (handle.lock == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	return pthread_rwlock_unlock((pthread_rwlock_t*)handle.lock) == 0 ? THREAD_RES_OK
+									  : THREAD_ERR_FAILED;
+}
+
+int plat_rwlock_lock(rwlock_handle_t handle)
+{
+	if (handle.lock == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	return pthread_rwlock_wrlock((pthread_rwlock_t*)handle.lock) == 0 ? THREAD_RES_OK
+									  : THREAD_ERR_FAILED;
+}
+
+int plat_rwlock_unlock(rwlock_handle_t handle)
+{
+	return plat_rwlock_unlock_shared(handle);
+}
+
+int plat_semaphore_create(semaphore_handle_t* handle, unsigned int initial_cnt, unsigned int max_cnt)
+{
+	posix_semaphore_t* sema;
+	if (handle == NULL || initial_cnt > max_cnt || max_cnt > INT_MAX) {
+		ex_log(LOG_ERROR, "plat_semaphore_create THREAD_ERR_INVALID_PARAM");
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	if (handle->sema != NULL) {
+		ex_log(LOG_DEBUG, "plat_semaphore_create handle->sema != NULL, semaphore has already created");
+		return THREAD_RES_OK;
+	}
+
+	sema = (posix_semaphore_t*)calloc(1, sizeof(posix_semaphore_t));
+	if (sema == NULL) {
+		ex_log(LOG_ERROR, "plat_semaphore_create out of memory");
+		return THREAD_ERR_CREATE_FAILED;
+	}
+	sema->count = (int)initial_cnt;
+	sema->max_count = (int)max_cnt;
+	handle->sema = sema;
+	return THREAD_RES_OK;
+}
+
+int plat_semaphore_release(semaphore_handle_t* handle)
+{
+	if (handle == NULL)
+		return THREAD_ERR_INVALID_PARAM;
+
+	if (handle->sema == NULL) {
+		ex_log(LOG_ERROR, "plat_semaphore_release *handle == NULL, no semaphore needs release");
+		return THREAD_RES_OK;
+	}
+	free(handle->sema);
+	handle->sema = NULL;
+	return THREAD_RES_OK;
+}
+
+static int semaphore_trywait(posix_semaphore_t* sema)
+{
+	int count = __atomic_load_n(&sema->count, __ATOMIC_SEQ_CST);
+	while (count > 0) {
+		if (__atomic_compare_exchange_n(&sema->count, &count, count - 1, 1,
+						__ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static long long monotonic_us(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+int plat_semaphore_wait(semaphore_handle_t handle, int wait_time)
+{
+	posix_semaphore_t* sema = (posix_semaphore_t*)handle.sema;
+	long long deadline = 0;
+	int retval = THREAD_RES_OK;
+	if (sema == NULL) {
+		ex_log(LOG_ERROR, "one method was called before thread manager init");
+		return THREAD_RES_OK;
+	}
+
+	if (semaphore_trywait(sema)) {
+		return THREAD_RES_OK;
+	}
+	if (wait_time == 0) {
+		return THREAD_RES_WAIT_TIMEOUT;
+	}
+	if (wait_time > 0) {
+		deadline = monotonic_us() + wait_time;
+	}
+
+	__atomic_fetch_add(&sema->waiters, 1, __ATOMIC_SEQ_CST);
+	while (!semaphore_trywait(sema)) {
+		struct timespec timeout;
+		struct timespec* ptimeout = NULL;
+		if (wait_time > 0) {
+			long long remaining = deadline - monotonic_us();
+			if (remaining <= 0) {
+				retval = THREAD_RES_WAIT_TIMEOUT;
+				break;
+			}
+			timeout.tv_sec = (time_t)(remaining / 1000000);
+			timeout.tv_nsec = (long)(remaining % 1000000) * 1000;
+			ptimeout = &timeout;
+		}
+		/* returns at once if a post raised count meanwhile */
+		if (futex_wait(&sema->count, 0, ptimeout) != 0 && errno != EAGAIN &&
+		    errno != EINTR && errno != ETIMEDOUT) {
+			ex_log(LOG_ERROR, "plat_semaphore_wait futex failed ,error = %d", errno);
+			retval = THREAD_ERR_FAILED;
+			break;
+		}
+	}
+	__atomic_fetch_sub(&sema->waiters, 1, __ATOMIC_SEQ_CST);
+	return retval;
+}
+
+int plat_semaphore_post(semaphore_handle_t handle)
+{
+	posix_semaphore_t* sema = (posix_semaphore_t*)handle.sema;
+	int count;
+	if (sema == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	count = __atomic_load_n(&sema->count, __ATOMIC_RELAXED);
+	do {
+		if (count >= sema->max_count) {
+			/* like ReleaseSemaphore, the count never exceeds max_cnt */
+			return THREAD_ERR_FAILED;
+		}
+	} while (!__atomic_compare_exchange_n(&sema->count, &count, count + 1, 1,
+					      __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+	if (__atomic_load_n(&sema->waiters, __ATOMIC_SEQ_CST) > 0) {
+		futex_wake(&sema->count, 1);
+	}
+	return THREAD_RES_OK;
+}
+
+int plat_sched_setaffinity_ex(unsigned long long cpu_mask)
+{
+	cpu_set_t cpu_set;
+	int cpu;
+
+	ex_log(LOG_DEBUG, "plat_sched_setaffinity_ex: %llx", cpu_mask);
+
+	CPU_ZERO(&cpu_set);
+	for (cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; cpu++) {
+		if (cpu_mask & (1ULL << cpu)) {
+			CPU_SET(cpu, &cpu_set);
+		}
+	}
+	/* pid 0 is the calling thread */
+	if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+		ex_log(LOG_ERROR, "Error in the syscall setaffinity: mask = %llx, err=%d",
+		       cpu_mask, errno);
+		return THREAD_ERR_FAILED;
+	}
+	return THREAD_RES_OK;
+}
+
+int plat_sched_setaffinity()
+{
+	return plat_sched_setaffinity_ex(0xf0);
+}
+
+/*
+ * Microseconds of CLOCK_MONOTONIC. The value wraps after ~35 minutes; callers only
+ * use differences.
+ */
+int egistec_clock(){
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int)(unsigned int)((unsigned long long)now.tv_sec * 1000000 + now.tv_nsec / 1000);
+}
+
+int egistec_cpu_id() {
+	int cpu = sched_getcpu();
+
+	return cpu < 0 ? 0 : cpu;
+}
+
+#endif
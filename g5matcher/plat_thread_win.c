@@ -1,4 +1,6 @@
+#ifdef _WIN32
 #include <windows.h>
+#include <stdlib.h>
 #include "plat_thread.h"
 //#include "biosign_lib.h"
 #include "plat_log.h"
@@ -96,7 +98,7 @@ int plat_mutex_release(mutex_handle_t* handle)
 		return THREAD_RES_OK;
 	}
 
-	//CloseHandle(handle->mutex);
+	CloseHandle(handle->mutex);
 	handle->mutex = NULL;
 	return THREAD_RES_OK;
 }
@@ -155,6 +157,85 @@ int plat_mutex_unlock(mutex_handle_t handle)
 	return retval;
 }
 
+int plat_rwlock_create(rwlock_handle_t* handle)
+{
+	SRWLOCK* lock;
+	if (handle == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	if (handle->lock != NULL) {
+		ex_log(LOG_ERROR, "plat_rwlock_create handle->lock != NULL, lock has already been created");
+		return THREAD_RES_OK;
+	}
+
+	lock = (SRWLOCK*)malloc(sizeof(SRWLOCK));
+	if (lock == NULL) {
+		return THREAD_ERR_CREATE_FAILED;
+	}
+	InitializeSRWLock(lock);
+	handle->lock = lock;
+	return THREAD_RES_OK;
+}
+
+int plat_rwlock_release(rwlock_handle_t* handle)
+{
+	if (handle == NULL) {
+		ex_log(LOG_ERROR, "plat_rwlock_release handle == NULL");
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	if (handle->lock == NULL) {
+		ex_log(LOG_INFO, "plat_rwlock_release handle->lock == NULL, lock has already been closed");
+		return THREAD_RES_OK;
+	}
+
+	/* An SRW lock holds no kernel object */
+	free(handle->lock);
+	handle->lock = NULL;
+	return THREAD_RES_OK;
+}
+
+int plat_rwlock_lock_shared(rwlock_handle_t handle)
+{
+	if (handle.lock == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	AcquireSRWLockShared((SRWLOCK*)handle.lock);
+	return THREAD_RES_OK;
+}
+
+int plat_rwlock_unlock_shared(rwlock_handle_t handle)
+{
+	if (handle.lock == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	ReleaseSRWLockShared((SRWLOCK*)handle.lock);
+	return THREAD_RES_OK;
+}
+
+int plat_rwlock_lock(rwlock_handle_t handle)
+{
+	if (handle.lock == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	AcquireSRWLockExclusive((SRWLOCK*)handle.lock);
+	return THREAD_RES_OK;
+}
+
+int plat_rwlock_unlock(rwlock_handle_t handle)
+{
+	if (handle.lock == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+
+	ReleaseSRWLockExclusive((SRWLOCK*)handle.lock);
+	return THREAD_RES_OK;
+}
+
 int plat_semaphore_create(semaphore_handle_t* handle, unsigned int initial_cnt, unsigned int max_cnt)
 {
 	if (handle == NULL || initial_cnt > max_cnt) {
@@ -196,7 +277,9 @@ int plat_semaphore_wait(semaphore_handle_t handle, int wait_time)
 		ex_log(LOG_ERROR, "one method was called before thread manager init");
 		return THREAD_RES_OK;
 	}
-	retval = WaitForSingleObject(handle.sema, wait_time);
+	// wait_time is in microseconds, WaitForSingleObject takes milliseconds
+	retval = WaitForSingleObject(handle.sema,
+		wait_time < 0 ? INFINITE : ((DWORD)wait_time + 999) / 1000);
 	if (retval == WAIT_OBJECT_0) {
 		retval = THREAD_RES_OK;
 	}
@@ -211,23 +294,30 @@ int plat_semaphore_wait(semaphore_handle_t handle, int wait_time)
 
 int plat_semaphore_post(semaphore_handle_t handle)
 {
-	return ReleaseSemaphore(handle.sema, 1, NULL);
+	if (handle.sema == NULL) {
+		return THREAD_ERR_INVALID_PARAM;
+	}
+	if (!ReleaseSemaphore(handle.sema, 1, NULL)) {
+		return THREAD_ERR_FAILED;
+	}
+	return THREAD_RES_OK;
 }
 
-int plat_sched_setaffinity_ex(BYTE cpu_mask)
+int plat_sched_setaffinity_ex(unsigned long long cpu_mask)
 {
-	int syscallres = 0;
-
-	/*ex_log(LOG_DEBUG,"plat_sched_setaffinity_ex: %02x", cpu_mask);
+	ex_log(LOG_DEBUG, "plat_sched_setaffinity_ex: %llx", cpu_mask);
 
-	syscallres = syscall(__NR_sched_setaffinity, gettid(), sizeof(cpu_mask),
-			     &cpu_mask);
-	if (syscallres) {
-		ex_log(LOG_ERROR,"Error in the syscall setaffinity: mask = %d, err=%d",
-			  cpu_mask, errno);
-	}*/
-
-	return syscallres;
+	if ((unsigned long long)(DWORD_PTR)cpu_mask != cpu_mask) {
+		ex_log(LOG_ERROR, "plat_sched_setaffinity_ex: mask %llx is wider than DWORD_PTR",
+			cpu_mask);
+		return THREAD_ERR_FAILED;
+	}
+	if (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)cpu_mask) == 0) {
+		ex_log(LOG_ERROR, "SetThreadAffinityMask failed: mask = %llx, error = %d",
+			cpu_mask, GetLastError());
+		return THREAD_ERR_FAILED;
+	}
+	return THREAD_RES_OK;
 }
 
 int plat_sched_setaffinity()
@@ -235,10 +325,24 @@ int plat_sched_setaffinity()
 	return plat_sched_setaffinity_ex(0xf0);
 }
 
+/*
+ * Microseconds of QueryPerformanceCounter, which is monotonic unlike clock().
+ * The value wraps after ~35 minutes; callers only use differences.
+ */
 int egistec_clock(){
-	return 0;
+	static LARGE_INTEGER frequency = { 0 };
+	LARGE_INTEGER counter;
+
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (int)(unsigned int)((counter.QuadPart / frequency.QuadPart) * 1000000 +
+				   (counter.QuadPart % frequency.QuadPart) * 1000000 /
+				   frequency.QuadPart);
 }
 
 int egistec_cpu_id() {
-	return 0;
+	return (int)GetCurrentProcessorNumber();
 }
+
+#endif